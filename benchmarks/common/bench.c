@@ -0,0 +1,80 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "bench.h"
+#include "libsteel.h"
+
+#define DEFAULT_UART (UartController *)0x80000000
+
+// Found by mcu_sim in the symbols of --ram-init-elf
+volatile uint32_t tohost;
+
+void bench_print(const char *text)
+{
+  uart_write_string(DEFAULT_UART, text);
+}
+
+void bench_print_u64(uint64_t value)
+{
+  char text[21];
+  int pos = sizeof(text) - 1;
+
+  text[pos] = '\0';
+
+  do
+  {
+    text[--pos] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+
+  bench_print(&text[pos]);
+}
+
+void bench_print_hex(uint32_t value)
+{
+  char text[11] = "0x";
+
+  for (int i = 0; i < 8; i++)
+  {
+    text[2 + i] = "0123456789abcdef"[(value >> (28 - 4 * i)) & 0xf];
+  }
+
+  text[10] = '\0';
+  bench_print(text);
+}
+
+void bench_report(const char *name, const BenchCounters *counters, uint32_t iterations)
+{
+  uint64_t cpi = counters->instructions ? counters->cycles * 1000 / counters->instructions : 0;
+  uint32_t fraction = cpi % 1000;
+
+  bench_print(name);
+  bench_print(": ");
+  bench_print_u64(iterations);
+  bench_print(" iterations, ");
+  bench_print_u64(counters->cycles);
+  bench_print(" cycles, ");
+  bench_print_u64(counters->instructions);
+  bench_print(" instructions, CPI ");
+  bench_print_u64(cpi / 1000);
+  bench_print(fraction < 10 ? ".00" : fraction < 100 ? ".0" : ".");
+  bench_print_u64(fraction);
+  bench_print(", ");
+  bench_print_u64(iterations ? counters->cycles / iterations : 0);
+  bench_print(" cycles/iteration\n");
+}
+
+void bench_exit(int passed, uint32_t code)
+{
+  bench_print(passed ? "PASS\n" : "FAIL\n");
+
+  __asm__ volatile("csrci mstatus, 0x8");
+  tohost = passed ? 1 : (code << 1) | 1;
+
+  while (1)
+    ;
+}
@@ -0,0 +1,79 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+// Cycles and retired instructions of a measured region, from the mcycle and
+// minstret counters of the core
+typedef struct
+{
+  uint64_t cycles;
+  uint64_t instructions;
+} BenchCounters;
+
+static inline uint64_t bench_mcycle(void)
+{
+  uint32_t hi, lo, hi2;
+
+  // mcycleh is read again in case mcycle wrapped between the reads
+  do
+  {
+    __asm__ volatile("csrr %0, mcycleh" : "=r"(hi));
+    __asm__ volatile("csrr %0, mcycle" : "=r"(lo));
+    __asm__ volatile("csrr %0, mcycleh" : "=r"(hi2));
+  } while (hi != hi2);
+
+  return ((uint64_t)hi << 32) | lo;
+}
+
+static inline uint64_t bench_minstret(void)
+{
+  uint32_t hi, lo, hi2;
+
+  do
+  {
+    __asm__ volatile("csrr %0, minstreth" : "=r"(hi));
+    __asm__ volatile("csrr %0, minstret" : "=r"(lo));
+    __asm__ volatile("csrr %0, minstreth" : "=r"(hi2));
+  } while (hi != hi2);
+
+  return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void bench_start(BenchCounters *counters)
+{
+  counters->instructions = bench_minstret();
+  counters->cycles = bench_mcycle();
+}
+
+static inline void bench_stop(BenchCounters *counters)
+{
+  uint64_t cycles = bench_mcycle();
+  uint64_t instructions = bench_minstret();
+
+  counters->cycles = cycles - counters->cycles;
+  counters->instructions = instructions - counters->instructions;
+}
+
+// Text on the UART (print it on mcu_sim with --uart-fast)
+void bench_print(const char *text);
+void bench_print_u64(uint64_t value);
+void bench_print_hex(uint32_t value);
+
+// Prints one line: "<name>: <iterations> iterations, <n> cycles, <n> instructions,
+// CPI <x.xxx>, <n> cycles/iteration"
+void bench_report(const char *name, const BenchCounters *counters, uint32_t iterations);
+
+// Ends the run through tohost: 1 when passed, (code << 1) | 1 otherwise, which
+// mcu_sim turns into a failing exit code. code tells the failed check, from 1
+// up. Does not return.
+void bench_exit(int passed, uint32_t code);
+
+#endif // BENCH_H
@@ -0,0 +1,55 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+// The string functions GCC may call on its own, e.g. for a structure copy, for
+// the benchmarks linked with -nostdlib. Built with
+// -fno-tree-loop-distribute-patterns so the loops are not turned back into
+// calls to themselves.
+
+#include <stddef.h>
+
+void *memcpy(void *dest, const void *src, size_t n)
+{
+  unsigned char *d = dest;
+  const unsigned char *s = src;
+
+  while (n--)
+    *d++ = *s++;
+
+  return dest;
+}
+
+void *memset(void *dest, int c, size_t n)
+{
+  unsigned char *d = dest;
+
+  while (n--)
+    *d++ = (unsigned char)c;
+
+  return dest;
+}
+
+char *strcpy(char *dest, const char *src)
+{
+  char *d = dest;
+
+  while ((*d++ = *src++))
+    ;
+
+  return dest;
+}
+
+int strcmp(const char *s1, const char *s2)
+{
+  while (*s1 && *s1 == *s2)
+  {
+    s1++;
+    s2++;
+  }
+
+  return (unsigned char)*s1 - (unsigned char)*s2;
+}
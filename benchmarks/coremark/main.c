@@ -0,0 +1,641 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+// CoreMark-style workload: linked list processing, matrix operations and a
+// number parsing state machine, each folded into a CRC-16. The sizes fit the
+// 32 KB RAM of mcu_sim. The final CRC is checked against a reference pass run
+// after the measured region, on freshly generated inputs, with plain array code
+// and a table-driven CRC-16.
+
+#include "bench.h"
+
+#ifndef ITERATIONS
+#define ITERATIONS 10
+#endif
+
+#define LIST_SEED 0x3415
+#define MATRIX_SEED 0x66
+#define STATE_SEED 0x1234
+
+#define LIST_NODES 64
+#define MATRIX_N 12
+#define STATE_INPUTS 40
+
+typedef struct ListNode
+{
+  struct ListNode *next;
+  int16_t data;
+  int16_t index;
+} ListNode;
+
+enum State
+{
+  STATE_START,
+  STATE_INVALID,
+  STATE_S1,
+  STATE_S2,
+  STATE_INT,
+  STATE_FLOAT,
+  STATE_EXPONENT,
+  STATE_SCIENTIFIC,
+  STATES
+};
+
+static ListNode list_pool[LIST_NODES];
+static int16_t matrix_a[MATRIX_N * MATRIX_N];
+static int16_t matrix_b[MATRIX_N * MATRIX_N];
+static int32_t matrix_c[MATRIX_N * MATRIX_N];
+static char state_input[STATE_INPUTS * 9 + 1];
+
+// Inputs of the reference pass
+static int16_t reference_a[MATRIX_N * MATRIX_N];
+static int16_t reference_b[MATRIX_N * MATRIX_N];
+static char reference_input[STATE_INPUTS * 9 + 1];
+static uint16_t crc16_table[256];
+
+static const char *const state_patterns[] = {"5012", "1.234", "-110.700", "+0.64400",
+                                             "5.500e+3", "-.123e-2", "T0.3e-1F", "-T.T++Tq",
+                                             "1T3.4e4z", "34.0e-T^"};
+
+// CRC-16 of CoreMark, polynomial 0xa001
+static uint16_t crc8(uint8_t data, uint16_t crc)
+{
+  for (int i = 0; i < 8; i++)
+  {
+    uint8_t carry = (data ^ crc) & 1;
+
+    data >>= 1;
+    crc >>= 1;
+
+    if (carry)
+      crc ^= 0xa001;
+  }
+
+  return crc;
+}
+
+static uint16_t crc16(uint16_t value, uint16_t crc)
+{
+  crc = crc8(value & 0xff, crc);
+  return crc8(value >> 8, crc);
+}
+
+static uint32_t lcg(uint32_t *seed)
+{
+  *seed = *seed * 1103515245u + 12345u;
+  return *seed >> 16;
+}
+
+// List
+
+static ListNode *list_init(uint32_t seed)
+{
+  for (int i = 0; i < LIST_NODES; i++)
+  {
+    list_pool[i].next = i + 1 < LIST_NODES ? &list_pool[i + 1] : 0;
+    list_pool[i].data = lcg(&seed) & 0x7fff;
+    list_pool[i].index = i;
+  }
+
+  return &list_pool[0];
+}
+
+static ListNode *list_reverse(ListNode *list)
+{
+  ListNode *reversed = 0;
+
+  while (list)
+  {
+    ListNode *next = list->next;
+
+    list->next = reversed;
+    reversed = list;
+    list = next;
+  }
+
+  return reversed;
+}
+
+static int list_compare(const ListNode *a, const ListNode *b, int by_data)
+{
+  return by_data ? a->data - b->data : a->index - b->index;
+}
+
+// Bottom-up merge sort, stable
+static ListNode *list_sort(ListNode *list, int by_data)
+{
+  for (int width = 1;; width *= 2)
+  {
+    ListNode *p = list;
+    ListNode *tail = 0;
+    int merges = 0;
+
+    list = 0;
+
+    while (p)
+    {
+      ListNode *q = p;
+      int p_size = 0;
+      int q_size = width;
+
+      merges++;
+
+      for (int i = 0; i < width && q; i++)
+      {
+        p_size++;
+        q = q->next;
+      }
+
+      while (p_size > 0 || (q_size > 0 && q))
+      {
+        ListNode *node;
+
+        if (p_size == 0)
+        {
+          node = q;
+          q = q->next;
+          q_size--;
+        }
+        else if (q_size == 0 || !q || list_compare(p, q, by_data) <= 0)
+        {
+          node = p;
+          p = p->next;
+          p_size--;
+        }
+        else
+        {
+          node = q;
+          q = q->next;
+          q_size--;
+        }
+
+        if (tail)
+          tail->next = node;
+        else
+          list = node;
+
+        tail = node;
+      }
+
+      p = q;
+    }
+
+    tail->next = 0;
+
+    if (merges <= 1)
+      return list;
+  }
+}
+
+static uint16_t bench_list(ListNode **list, uint16_t crc)
+{
+  int16_t key = (*list)->data;
+  int found = 0;
+
+  for (ListNode *node = *list; node; node = node->next)
+  {
+    found += (node->data & 0xff) == (key & 0xff);
+  }
+
+  *list = list_reverse(*list);
+  *list = list_sort(*list, 1);
+
+  for (ListNode *node = *list; node; node = node->next)
+  {
+    crc = crc16(node->data, crc);
+  }
+
+  // Each node moves on to new data, the list back to its original order
+  for (ListNode *node = *list; node; node = node->next)
+  {
+    node->data = (node->data * 3 + node->index + 1) & 0x7fff;
+  }
+
+  *list = list_sort(*list, 0);
+
+  return crc16(found, crc);
+}
+
+// Matrix
+
+static void matrix_init(int16_t *a, int16_t *b, uint32_t seed)
+{
+  for (int i = 0; i < MATRIX_N * MATRIX_N; i++)
+  {
+    a[i] = lcg(&seed) & 0xff;
+    b[i] = (lcg(&seed) & 0xff) - 0x80;
+  }
+}
+
+static uint16_t matrix_crc(uint16_t crc)
+{
+  int32_t sum = 0;
+
+  for (int i = 0; i < MATRIX_N * MATRIX_N; i++)
+  {
+    sum += matrix_c[i];
+    crc = crc16((uint16_t)matrix_c[i], crc);
+  }
+
+  return crc16((uint16_t)sum, crc);
+}
+
+static uint16_t bench_matrix(int16_t value, uint16_t crc)
+{
+  // A + value
+  for (int i = 0; i < MATRIX_N * MATRIX_N; i++)
+  {
+    matrix_a[i] += value;
+  }
+
+  // A * value
+  for (int i = 0; i < MATRIX_N * MATRIX_N; i++)
+  {
+    matrix_c[i] = (int32_t)matrix_a[i] * value;
+  }
+
+  crc = matrix_crc(crc);
+
+  // A * column 0 of B
+  for (int i = 0; i < MATRIX_N; i++)
+  {
+    int32_t sum = 0;
+
+    for (int j = 0; j < MATRIX_N; j++)
+    {
+      sum += (int32_t)matrix_a[i * MATRIX_N + j] * matrix_b[j * MATRIX_N];
+    }
+
+    matrix_c[i] = sum;
+  }
+
+  crc = matrix_crc(crc);
+
+  // A * B
+  for (int i = 0; i < MATRIX_N; i++)
+  {
+    for (int j = 0; j < MATRIX_N; j++)
+    {
+      int32_t sum = 0;
+
+      for (int k = 0; k < MATRIX_N; k++)
+      {
+        sum += (int32_t)matrix_a[i * MATRIX_N + k] * matrix_b[k * MATRIX_N + j];
+      }
+
+      matrix_c[i * MATRIX_N + j] = sum;
+    }
+  }
+
+  crc = matrix_crc(crc);
+
+  // Bit fields of A * B
+  for (int i = 0; i < MATRIX_N * MATRIX_N; i++)
+  {
+    matrix_c[i] = (matrix_c[i] >> 2) & 0xf;
+  }
+
+  crc = matrix_crc(crc);
+
+  // A back to its original values
+  for (int i = 0; i < MATRIX_N * MATRIX_N; i++)
+  {
+    matrix_a[i] -= value;
+  }
+
+  return crc;
+}
+
+// State machine
+
+static void state_init(char *input, uint32_t seed)
+{
+  char *p = input;
+
+  for (int i = 0; i < STATE_INPUTS; i++)
+  {
+    const char *pattern = state_patterns[lcg(&seed) % 10];
+
+    while (*pattern)
+      *p++ = *pattern++;
+
+    *p++ = ',';
+  }
+
+  *p = '\0';
+}
+
+static int is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+// Next state for one character, the state of the input read so far
+static enum State state_next(enum State state, char c)
+{
+  switch (state)
+  {
+  case STATE_START:
+    if (is_digit(c))
+      return STATE_INT;
+    if (c == '+' || c == '-')
+      return STATE_S1;
+    if (c == '.')
+      return STATE_FLOAT;
+    return STATE_INVALID;
+
+  case STATE_S1:
+    if (is_digit(c))
+      return STATE_INT;
+    if (c == '.')
+      return STATE_FLOAT;
+    return STATE_INVALID;
+
+  case STATE_INT:
+    if (c == '.')
+      return STATE_FLOAT;
+    return is_digit(c) ? STATE_INT : STATE_INVALID;
+
+  case STATE_FLOAT:
+    if (c == 'E' || c == 'e')
+      return STATE_S2;
+    return is_digit(c) ? STATE_FLOAT : STATE_INVALID;
+
+  case STATE_S2:
+    if (c == '+' || c == '-')
+      return STATE_EXPONENT;
+    return STATE_INVALID;
+
+  case STATE_EXPONENT:
+    return is_digit(c) ? STATE_SCIENTIFIC : STATE_INVALID;
+
+  case STATE_SCIENTIFIC:
+    return is_digit(c) ? STATE_SCIENTIFIC : STATE_INVALID;
+
+  default: return STATE_INVALID;
+  }
+}
+
+static uint16_t state_scan(uint16_t crc)
+{
+  uint32_t final_counts[STATES] = {0};
+  uint32_t transitions = 0;
+  enum State state = STATE_START;
+
+  for (const char *p = state_input; *p; p++)
+  {
+    if (*p == ',')
+    {
+      final_counts[state]++;
+      state = STATE_START;
+      continue;
+    }
+
+    enum State next = state_next(state, *p);
+
+    transitions += next != state;
+    state = next;
+  }
+
+  for (int i = 0; i < STATES; i++)
+  {
+    crc = crc16(final_counts[i], crc);
+  }
+
+  return crc16(transitions, crc);
+}
+
+static uint16_t bench_state(uint32_t step, uint16_t crc)
+{
+  crc = state_scan(crc);
+
+  // Corrupt every step-th character, scan again and restore
+  for (char *p = state_input + step; *p; p += step)
+  {
+    *p ^= 0x5;
+  }
+
+  crc = state_scan(crc);
+
+  for (char *p = state_input + step; *p; p += step)
+  {
+    *p ^= 0x5;
+  }
+
+  return crc;
+}
+
+// Reference
+
+static void crc16_table_init(void)
+{
+  for (uint32_t i = 0; i < 256; i++)
+  {
+    uint16_t crc = i;
+
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xa001 & -(crc & 1));
+
+    crc16_table[i] = crc;
+  }
+}
+
+static uint16_t reference_crc16(uint16_t value, uint16_t crc)
+{
+  crc = (crc >> 8) ^ crc16_table[(crc ^ value) & 0xff];
+  return (crc >> 8) ^ crc16_table[(crc ^ (value >> 8)) & 0xff];
+}
+
+// The data of the list nodes by index: the list kernel folds the data in
+// sorted order, equal values being indistinguishable
+static uint16_t reference_list(int16_t *data, uint16_t crc)
+{
+  int16_t sorted[LIST_NODES];
+  int found = 0;
+
+  for (int i = 0; i < LIST_NODES; i++)
+  {
+    found += (data[i] & 0xff) == (data[0] & 0xff);
+    sorted[i] = data[i];
+  }
+
+  for (int i = 1; i < LIST_NODES; i++)
+  {
+    int16_t value = sorted[i];
+    int j = i;
+
+    for (; j > 0 && sorted[j - 1] > value; j--)
+      sorted[j] = sorted[j - 1];
+
+    sorted[j] = value;
+  }
+
+  for (int i = 0; i < LIST_NODES; i++)
+  {
+    crc = reference_crc16(sorted[i], crc);
+    data[i] = (data[i] * 3 + i + 1) & 0x7fff;
+  }
+
+  return reference_crc16(found, crc);
+}
+
+static uint16_t reference_matrix_crc(const int32_t c[MATRIX_N][MATRIX_N], uint16_t crc)
+{
+  int32_t sum = 0;
+
+  for (int i = 0; i < MATRIX_N; i++)
+  {
+    for (int j = 0; j < MATRIX_N; j++)
+    {
+      sum += c[i][j];
+      crc = reference_crc16((uint16_t)c[i][j], crc);
+    }
+  }
+
+  return reference_crc16((uint16_t)sum, crc);
+}
+
+static uint16_t reference_matrix(int16_t value, uint16_t crc)
+{
+  int16_t a[MATRIX_N][MATRIX_N];
+  int32_t c[MATRIX_N][MATRIX_N];
+
+  for (int i = 0; i < MATRIX_N; i++)
+  {
+    for (int j = 0; j < MATRIX_N; j++)
+    {
+      a[i][j] = (int16_t)(reference_a[i * MATRIX_N + j] + value);
+      c[i][j] = (int32_t)a[i][j] * value;
+    }
+  }
+
+  crc = reference_matrix_crc(c, crc);
+
+  // The product with column 0 of B fills the first row, the rest keeps A * value
+  for (int i = 0; i < MATRIX_N; i++)
+  {
+    c[0][i] = 0;
+
+    for (int k = 0; k < MATRIX_N; k++)
+      c[0][i] += (int32_t)a[i][k] * reference_b[k * MATRIX_N];
+  }
+
+  crc = reference_matrix_crc(c, crc);
+
+  for (int i = 0; i < MATRIX_N; i++)
+  {
+    for (int j = 0; j < MATRIX_N; j++)
+    {
+      c[i][j] = 0;
+
+      for (int k = 0; k < MATRIX_N; k++)
+        c[i][j] += (int32_t)a[i][k] * reference_b[k * MATRIX_N + j];
+    }
+  }
+
+  crc = reference_matrix_crc(c, crc);
+
+  for (int i = 0; i < MATRIX_N; i++)
+  {
+    for (int j = 0; j < MATRIX_N; j++)
+      c[i][j] = (c[i][j] >> 2) & 0xf;
+  }
+
+  return reference_matrix_crc(c, crc);
+}
+
+// Every step-th character is read corrupted, a step of 0 reads the input as is
+static uint16_t reference_scan(uint32_t step, uint16_t crc)
+{
+  uint32_t final_counts[STATES] = {0};
+  uint32_t transitions = 0;
+  enum State state = STATE_START;
+
+  for (uint32_t i = 0; reference_input[i]; i++)
+  {
+    char c = reference_input[i];
+
+    if (step && i > 0 && i % step == 0)
+      c ^= 0x5;
+
+    if (c == ',')
+    {
+      final_counts[state]++;
+      state = STATE_START;
+    }
+    else
+    {
+      enum State next = state_next(state, c);
+
+      transitions += next != state;
+      state = next;
+    }
+  }
+
+  for (int i = 0; i < STATES; i++)
+    crc = reference_crc16(final_counts[i], crc);
+
+  return reference_crc16(transitions, crc);
+}
+
+static uint16_t reference_crc(void)
+{
+  int16_t list_data[LIST_NODES];
+  uint32_t seed = LIST_SEED;
+  uint16_t crc = 0;
+
+  for (int i = 0; i < LIST_NODES; i++)
+    list_data[i] = lcg(&seed) & 0x7fff;
+
+  matrix_init(reference_a, reference_b, MATRIX_SEED);
+  state_init(reference_input, STATE_SEED);
+  crc16_table_init();
+
+  for (uint32_t i = 0; i < ITERATIONS; i++)
+  {
+    crc = reference_list(list_data, crc);
+    crc = reference_matrix((int16_t)(i + 1), crc);
+    crc = reference_scan(0, crc);
+    crc = reference_scan(i % 7 + 3, crc);
+  }
+
+  return crc;
+}
+
+int main(void)
+{
+  BenchCounters counters;
+  ListNode *list = list_init(LIST_SEED);
+  uint16_t crc = 0;
+  uint16_t expected;
+
+  matrix_init(matrix_a, matrix_b, MATRIX_SEED);
+  state_init(state_input, STATE_SEED);
+
+  bench_start(&counters);
+
+  for (uint32_t i = 0; i < ITERATIONS; i++)
+  {
+    crc = bench_list(&list, crc);
+    crc = bench_matrix((int16_t)(i + 1), crc);
+    crc = bench_state(i % 7 + 3, crc);
+  }
+
+  bench_stop(&counters);
+
+  bench_report("coremark", &counters, ITERATIONS);
+  bench_print("crc: ");
+  bench_print_hex(crc);
+  bench_print("\n");
+
+  expected = reference_crc();
+  bench_print("expected crc: ");
+  bench_print_hex(expected);
+  bench_print("\n");
+
+  bench_exit(crc == expected, 1);
+}
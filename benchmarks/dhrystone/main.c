@@ -0,0 +1,282 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+// Dhrystone-style workload: the mix of procedure calls, record and pointer
+// accesses, string copies and compares, enumerations and array indexing of
+// Dhrystone 2.1, with its structure and final values. The procedures are kept
+// out of line so the compiler cannot fold the loop away. The final values are
+// checked as Dhrystone lists them.
+
+#include <string.h>
+
+#include "bench.h"
+
+#ifndef ITERATIONS
+#define ITERATIONS 2000
+#endif
+
+#define NOINLINE __attribute__((noinline))
+
+typedef enum
+{
+  IDENT_1,
+  IDENT_2,
+  IDENT_3,
+  IDENT_4,
+  IDENT_5
+} Enumeration;
+
+typedef char String30[31];
+
+typedef struct Record
+{
+  struct Record *ptr_comp;
+  Enumeration discr;
+  Enumeration enum_comp;
+  int int_comp;
+  String30 str_comp;
+} Record;
+
+static Record record_glob;
+static Record next_record_glob;
+static Record *ptr_glob;
+static Record *next_ptr_glob;
+
+static int int_glob;
+static int bool_glob;
+static char ch_1_glob;
+static char ch_2_glob;
+static int arr_1_glob[50];
+static int arr_2_glob[50][50];
+
+NOINLINE static int func_3(Enumeration enum_par)
+{
+  return enum_par == IDENT_3;
+}
+
+NOINLINE static Enumeration func_1(char ch_1_par, char ch_2_par)
+{
+  char ch_1_loc = ch_1_par;
+  char ch_2_loc = ch_1_loc;
+
+  if (ch_2_loc != ch_2_par)
+    return IDENT_1;
+
+  ch_1_glob = ch_1_loc;
+  return IDENT_2;
+}
+
+NOINLINE static int func_2(const String30 str_1_par, const String30 str_2_par)
+{
+  int int_loc = 2;
+  char ch_loc = 'A';
+
+  while (int_loc <= 2)
+  {
+    if (func_1(str_1_par[int_loc], str_2_par[int_loc + 1]) == IDENT_1)
+    {
+      ch_loc = 'A';
+      int_loc += 1;
+    }
+  }
+
+  if (ch_loc >= 'W' && ch_loc < 'Z')
+    int_loc = 7;
+
+  if (ch_loc == 'R')
+    return 1;
+
+  if (strcmp(str_1_par, str_2_par) > 0)
+  {
+    int_loc += 7;
+    int_glob = int_loc;
+    return 1;
+  }
+
+  return 0;
+}
+
+NOINLINE static void proc_6(Enumeration enum_val_par, Enumeration *enum_ref_par)
+{
+  *enum_ref_par = enum_val_par;
+
+  if (!func_3(enum_val_par))
+    *enum_ref_par = IDENT_4;
+
+  switch (enum_val_par)
+  {
+  case IDENT_1: *enum_ref_par = IDENT_1; break;
+  case IDENT_2: *enum_ref_par = int_glob > 100 ? IDENT_1 : IDENT_4; break;
+  case IDENT_3: *enum_ref_par = IDENT_2; break;
+  case IDENT_4: break;
+  case IDENT_5: *enum_ref_par = IDENT_3; break;
+  }
+}
+
+NOINLINE static void proc_7(int int_1_par_val, int int_2_par_val, int *int_par_ref)
+{
+  *int_par_ref = int_2_par_val + int_1_par_val + 2;
+}
+
+NOINLINE static void proc_8(int arr_1_par_ref[50], int arr_2_par_ref[50][50], int int_1_par_val,
+                            int int_2_par_val)
+{
+  int int_loc = int_1_par_val + 5;
+
+  arr_1_par_ref[int_loc] = int_2_par_val;
+  arr_1_par_ref[int_loc + 1] = arr_1_par_ref[int_loc];
+  arr_1_par_ref[int_loc + 30] = int_loc;
+
+  for (int int_index = int_loc; int_index <= int_loc + 1; int_index++)
+    arr_2_par_ref[int_loc][int_index] = int_loc;
+
+  arr_2_par_ref[int_loc][int_loc - 1] += 1;
+  arr_2_par_ref[int_loc + 20][int_loc] = arr_1_par_ref[int_loc];
+  int_glob = 5;
+}
+
+NOINLINE static void proc_3(Record **ptr_ref_par)
+{
+  if (ptr_glob)
+    *ptr_ref_par = ptr_glob->ptr_comp;
+
+  proc_7(10, int_glob, &ptr_glob->int_comp);
+}
+
+NOINLINE static void proc_1(Record *ptr_val_par)
+{
+  Record *next_record = ptr_val_par->ptr_comp;
+
+  *ptr_val_par->ptr_comp = *ptr_glob;
+  ptr_val_par->int_comp = 5;
+  next_record->int_comp = ptr_val_par->int_comp;
+  next_record->ptr_comp = ptr_val_par->ptr_comp;
+  proc_3(&next_record->ptr_comp);
+
+  if (next_record->discr == IDENT_1)
+  {
+    next_record->int_comp = 6;
+    proc_6(ptr_val_par->enum_comp, &next_record->enum_comp);
+    next_record->ptr_comp = ptr_glob->ptr_comp;
+    proc_7(next_record->int_comp, 10, &next_record->int_comp);
+  }
+  else
+  {
+    *ptr_val_par = *ptr_val_par->ptr_comp;
+  }
+}
+
+NOINLINE static void proc_2(int *int_par_ref)
+{
+  int int_loc = *int_par_ref + 10;
+  Enumeration enum_loc = IDENT_1;
+
+  do
+  {
+    if (ch_1_glob == 'A')
+    {
+      int_loc -= 1;
+      *int_par_ref = int_loc - int_glob;
+      enum_loc = IDENT_1;
+    }
+  } while (enum_loc != IDENT_1);
+}
+
+NOINLINE static void proc_4(void)
+{
+  int bool_loc = ch_1_glob == 'A';
+
+  bool_glob = bool_loc | bool_glob;
+  ch_2_glob = 'B';
+}
+
+NOINLINE static void proc_5(void)
+{
+  ch_1_glob = 'A';
+  bool_glob = 0;
+}
+
+int main(void)
+{
+  BenchCounters counters;
+  int int_1_loc = 0;
+  int int_2_loc = 0;
+  int int_3_loc = 0;
+  char ch_index;
+  Enumeration enum_loc = IDENT_1;
+  String30 str_1_loc;
+  String30 str_2_loc;
+
+  next_ptr_glob = &next_record_glob;
+  ptr_glob = &record_glob;
+
+  ptr_glob->ptr_comp = next_ptr_glob;
+  ptr_glob->discr = IDENT_1;
+  ptr_glob->enum_comp = IDENT_3;
+  ptr_glob->int_comp = 40;
+  strcpy(ptr_glob->str_comp, "DHRYSTONE PROGRAM, SOME STRING");
+  strcpy(str_1_loc, "DHRYSTONE PROGRAM, 1'ST STRING");
+
+  arr_2_glob[8][7] = 10;
+
+  bench_start(&counters);
+
+  for (int run = 1; run <= ITERATIONS; run++)
+  {
+    proc_5();
+    proc_4();
+
+    int_1_loc = 2;
+    int_2_loc = 3;
+    strcpy(str_2_loc, "DHRYSTONE PROGRAM, 2'ND STRING");
+    enum_loc = IDENT_2;
+    bool_glob = !func_2(str_1_loc, str_2_loc);
+
+    while (int_1_loc < int_2_loc)
+    {
+      int_3_loc = 5 * int_1_loc - int_2_loc;
+      proc_7(int_1_loc, int_2_loc, &int_3_loc);
+      int_1_loc += 1;
+    }
+
+    proc_8(arr_1_glob, arr_2_glob, int_1_loc, int_3_loc);
+    proc_1(ptr_glob);
+
+    for (ch_index = 'A'; ch_index <= ch_2_glob; ch_index++)
+    {
+      if (enum_loc == func_1(ch_index, 'C'))
+      {
+        proc_6(IDENT_1, &enum_loc);
+        strcpy(str_2_loc, "DHRYSTONE PROGRAM, 3'RD STRING");
+        int_2_loc = run;
+        int_glob = run;
+      }
+    }
+
+    int_2_loc = int_2_loc * int_1_loc;
+    int_1_loc = int_2_loc / int_3_loc;
+    int_2_loc = 7 * (int_2_loc - int_3_loc) - int_1_loc;
+    proc_2(&int_1_loc);
+  }
+
+  bench_stop(&counters);
+
+  bench_report("dhrystone", &counters, ITERATIONS);
+
+  // The values printed by Dhrystone 2.1 as "should be"
+  int passed = int_glob == 5 && bool_glob == 1 && ch_1_glob == 'A' && ch_2_glob == 'B' &&
+               arr_1_glob[8] == 7 && arr_2_glob[8][7] == ITERATIONS + 10 &&
+               ptr_glob->discr == IDENT_1 && ptr_glob->enum_comp == IDENT_3 &&
+               ptr_glob->int_comp == 17 && next_ptr_glob->discr == IDENT_1 &&
+               next_ptr_glob->enum_comp == IDENT_2 && next_ptr_glob->int_comp == 18 &&
+               int_1_loc == 5 && int_2_loc == 13 && int_3_loc == 7 && enum_loc == IDENT_2 &&
+               strcmp(ptr_glob->str_comp, "DHRYSTONE PROGRAM, SOME STRING") == 0 &&
+               strcmp(str_1_loc, "DHRYSTONE PROGRAM, 1'ST STRING") == 0 &&
+               strcmp(str_2_loc, "DHRYSTONE PROGRAM, 2'ND STRING") == 0;
+
+  bench_exit(passed, 1);
+}
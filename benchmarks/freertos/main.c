@@ -0,0 +1,136 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+// FreeRTOS kernel costs: the cycles of a task switch on taskYIELD() between
+// two tasks of the same priority, and the latency from xQueueSend() in one task
+// to xQueueReceive() returning in a higher priority task blocked on the queue.
+
+#include "bench.h"
+#include "libsteel.h"
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <task.h>
+
+#define DEFAULT_MTIMER (MTimerController *)0x80010000
+
+#ifndef ITERATIONS
+#define ITERATIONS 200
+#endif
+
+#define BENCH_PRIORITY 2
+#define RECEIVE_PRIORITY 3
+
+extern void freertos_risc_v_mtimer_interrupt_handler();
+extern void freertos_risc_v_exception_handler();
+
+// FreeRTOS heap
+uint8_t ucHeap[configTOTAL_HEAP_SIZE];
+
+static QueueHandle_t queue;
+static volatile uint32_t yields;
+static volatile uint32_t received;
+static volatile uint64_t latency_cycles;
+
+// Override the trap handler for Machine Timer Interrupts: make it call FreeRTOS MTimer interrupt
+// handler.
+__NAKED void mti_irq_handler()
+{
+  freertos_risc_v_mtimer_interrupt_handler();
+}
+
+// Override the default trap handler (for non-vectored mode): make it call FreeRTOS exception
+// handler.
+__NAKED void default_trap_handler()
+{
+  freertos_risc_v_exception_handler();
+}
+
+// Hands the core back to the benchmark task, which has the same priority
+void yield_task(void *pvParameters)
+{
+  (void)pvParameters;
+
+  for (;;)
+  {
+    yields++;
+    taskYIELD();
+  }
+}
+
+// Preempts the benchmark task as soon as a timestamp is sent
+void receive_task(void *pvParameters)
+{
+  (void)pvParameters;
+  uint64_t sent;
+
+  for (;;)
+  {
+    if (xQueueReceive(queue, &sent, portMAX_DELAY) == pdPASS)
+    {
+      latency_cycles += bench_mcycle() - sent;
+      received++;
+    }
+  }
+}
+
+void bench_task(void *pvParameters)
+{
+  (void)pvParameters;
+  BenchCounters counters;
+  TaskHandle_t yield_handle;
+
+  // Task switch: every yield goes to yield_task and back, two switches. The
+  // first one starts yield_task and is not counted.
+  xTaskCreate(yield_task, "yield", configMINIMAL_STACK_SIZE, NULL, BENCH_PRIORITY, &yield_handle);
+  taskYIELD();
+
+  bench_start(&counters);
+
+  for (uint32_t i = 0; i < ITERATIONS; i++)
+    taskYIELD();
+
+  bench_stop(&counters);
+  vTaskSuspend(yield_handle);
+  bench_report("task switch", &counters, 2 * ITERATIONS);
+
+  // Queue: the receiver runs inside each xQueueSend() and blocks again
+  queue = xQueueCreate(1, sizeof(uint64_t));
+  xTaskCreate(receive_task, "receive", configMINIMAL_STACK_SIZE, NULL, RECEIVE_PRIORITY, NULL);
+
+  bench_start(&counters);
+
+  for (uint32_t i = 0; i < ITERATIONS; i++)
+  {
+    uint64_t sent = bench_mcycle();
+    xQueueSend(queue, &sent, portMAX_DELAY);
+  }
+
+  bench_stop(&counters);
+  bench_report("queue round trip", &counters, ITERATIONS);
+
+  bench_print("queue latency: ");
+  bench_print_u64(received ? latency_cycles / received : 0);
+  bench_print(" cycles\n");
+
+  if (yields < ITERATIONS)
+    bench_exit(0, 1);
+
+  bench_exit(received == ITERATIONS, 2);
+}
+
+int main(void)
+{
+  csr_enable_vectored_mode_irq();
+  mtimer_enable(DEFAULT_MTIMER);
+
+  xTaskCreate(bench_task, "bench", 2 * configMINIMAL_STACK_SIZE, NULL, BENCH_PRIORITY, NULL);
+
+  vTaskStartScheduler();
+
+  while (1)
+    ;
+}
@@ -0,0 +1,214 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+// Micro-kernels, each measured and checked on its own: word and byte memcpy,
+// word memset, bitwise CRC-32 and insertion sort. They isolate the load/store
+// path, the branch cost and the shift-heavy ALU loops of the core.
+
+#include "bench.h"
+
+#ifndef ITERATIONS
+#define ITERATIONS 8
+#endif
+
+#define NOINLINE __attribute__((noinline))
+
+#define BUFFER_WORDS 512
+#define SORT_ELEMENTS 128
+
+static uint32_t source[BUFFER_WORDS];
+static uint32_t destination[BUFFER_WORDS];
+static int32_t sort_data[SORT_ELEMENTS];
+static uint32_t crc32_table[256];
+
+// First check that failed, 0 while all pass
+static uint32_t failed;
+
+static uint32_t lcg(uint32_t *seed)
+{
+  *seed = *seed * 1103515245u + 12345u;
+  return *seed;
+}
+
+NOINLINE static void copy_words(uint32_t *dest, const uint32_t *src, uint32_t words)
+{
+  for (uint32_t i = 0; i < words; i++)
+    dest[i] = src[i];
+}
+
+NOINLINE static void copy_bytes(uint8_t *dest, const uint8_t *src, uint32_t bytes)
+{
+  for (uint32_t i = 0; i < bytes; i++)
+    dest[i] = src[i];
+}
+
+NOINLINE static void set_words(uint32_t *dest, uint32_t value, uint32_t words)
+{
+  for (uint32_t i = 0; i < words; i++)
+    dest[i] = value;
+}
+
+// Reflected, polynomial 0xedb88320
+NOINLINE static uint32_t crc32(const uint8_t *data, uint32_t bytes)
+{
+  uint32_t crc = 0xffffffff;
+
+  for (uint32_t i = 0; i < bytes; i++)
+  {
+    crc ^= data[i];
+
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+  }
+
+  return ~crc;
+}
+
+// Table-driven, the reference for the bitwise kernel
+static uint32_t reference_crc32(const uint8_t *data, uint32_t bytes)
+{
+  uint32_t crc = 0xffffffff;
+
+  for (uint32_t i = 0; i < 256; i++)
+  {
+    uint32_t entry = i;
+
+    for (int bit = 0; bit < 8; bit++)
+      entry = entry & 1 ? (entry >> 1) ^ 0xedb88320 : entry >> 1;
+
+    crc32_table[i] = entry;
+  }
+
+  for (uint32_t i = 0; i < bytes; i++)
+    crc = (crc >> 8) ^ crc32_table[(crc ^ data[i]) & 0xff];
+
+  return ~crc;
+}
+
+NOINLINE static void insertion_sort(int32_t *data, uint32_t count)
+{
+  for (uint32_t i = 1; i < count; i++)
+  {
+    int32_t value = data[i];
+    uint32_t j = i;
+
+    while (j > 0 && data[j - 1] > value)
+    {
+      data[j] = data[j - 1];
+      j--;
+    }
+
+    data[j] = value;
+  }
+}
+
+static void check(int ok, uint32_t code)
+{
+  if (!ok && !failed)
+    failed = code;
+}
+
+static int words_equal(const uint32_t *a, const uint32_t *b, uint32_t words)
+{
+  for (uint32_t i = 0; i < words; i++)
+  {
+    if (a[i] != b[i])
+      return 0;
+  }
+
+  return 1;
+}
+
+static int words_are(const uint32_t *a, uint32_t value, uint32_t words)
+{
+  for (uint32_t i = 0; i < words; i++)
+  {
+    if (a[i] != value)
+      return 0;
+  }
+
+  return 1;
+}
+
+int main(void)
+{
+  BenchCounters counters;
+  uint32_t seed = 0x5eed;
+  uint32_t crc = 0;
+
+  for (uint32_t i = 0; i < BUFFER_WORDS; i++)
+    source[i] = lcg(&seed);
+
+  bench_start(&counters);
+
+  for (uint32_t i = 0; i < ITERATIONS; i++)
+    copy_words(destination, source, BUFFER_WORDS);
+
+  bench_stop(&counters);
+  bench_report("memcpy words", &counters, ITERATIONS);
+
+  check(words_equal(destination, source, BUFFER_WORDS), 1);
+
+  set_words(destination, 0, BUFFER_WORDS);
+  bench_start(&counters);
+
+  for (uint32_t i = 0; i < ITERATIONS; i++)
+    copy_bytes((uint8_t *)destination, (const uint8_t *)source, 4 * BUFFER_WORDS);
+
+  bench_stop(&counters);
+  bench_report("memcpy bytes", &counters, ITERATIONS);
+
+  check(words_equal(destination, source, BUFFER_WORDS), 2);
+
+  bench_start(&counters);
+
+  for (uint32_t i = 0; i < ITERATIONS; i++)
+    set_words(destination, 0xa5a5a5a5 + i, BUFFER_WORDS);
+
+  bench_stop(&counters);
+  bench_report("memset words", &counters, ITERATIONS);
+
+  check(words_are(destination, 0xa5a5a5a5 + ITERATIONS - 1, BUFFER_WORDS), 3);
+
+  bench_start(&counters);
+
+  for (uint32_t i = 0; i < ITERATIONS; i++)
+    crc = crc32((const uint8_t *)source, 4 * BUFFER_WORDS);
+
+  bench_stop(&counters);
+  bench_report("crc32", &counters, ITERATIONS);
+
+  check(crc == reference_crc32((const uint8_t *)source, 4 * BUFFER_WORDS), 4);
+
+  // Sorting in place, each iteration gets the data anew, outside the count
+  uint64_t sort_cycles = 0;
+  uint64_t sort_instructions = 0;
+
+  for (uint32_t i = 0; i < ITERATIONS; i++)
+  {
+    for (uint32_t j = 0; j < SORT_ELEMENTS; j++)
+      sort_data[j] = (int32_t)source[(j + i) % BUFFER_WORDS] >> 8;
+
+    bench_start(&counters);
+    insertion_sort(sort_data, SORT_ELEMENTS);
+    bench_stop(&counters);
+
+    sort_cycles += counters.cycles;
+    sort_instructions += counters.instructions;
+
+    for (uint32_t j = 1; j < SORT_ELEMENTS; j++)
+    {
+      check(sort_data[j - 1] <= sort_data[j], 5);
+    }
+  }
+
+  counters.cycles = sort_cycles;
+  counters.instructions = sort_instructions;
+  bench_report("insertion sort", &counters, ITERATIONS);
+
+  bench_exit(failed == 0, failed);
+}
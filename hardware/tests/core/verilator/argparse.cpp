@@ -1,166 +1,395 @@
-// ----------------------------------------------------------------------------
-// Copyright (c) 2020-2024 RISC-V Steel contributors
-//
-// This work is licensed under the MIT License, see LICENSE file for details.
-// SPDX-License-Identifier: MIT
-// ----------------------------------------------------------------------------
-
-#include "argparse.h"
-
-#include <stdlib.h>
-#include <iostream>
-#include <getopt.h>
-#include <string.h>
-
-#include "log.h"
-
-const char *help_str =
-    "Use: app_name.run [options]\n"
-    "Options:\n"
-    "--out-wave=<name>      Output file *.fst (defaul: none - off)\n\n"
-    "--ram-init-h32=<name>  Input init ram file in h32 format (defaul: none - off)\n"
-    "                       Example: --ram-init-h32=my_program.hex\n\n"
-    "--ram-init-bin=<name>  Input init ram file in bin format (defaul: none)\n"
-    "                       Example: --ram-init-bin=my_program.bin\n\n"
-
-    "--ram-dump-h32=<name>  Output dump ram file in h32 format (defaul: none - off)\n"
-    "Note:                  If the file is not specified then the dump are not created.\n\n"
-    "\n\n"
-
-    "The end of the program is:\n"
-    "--cycles=<num>         Exit after processor cycles complete (default: 500000)\n"
-    "                       Example: --cycles=10000\n\n"
-    //    "--ecall            Exit if there is an instruction ecall\n"
-    "--wr-addr=<addr>       Exit if there is an entry at the specified address (default: 0x00001000)\n"
-    "                       Example: --wr-addr=0x00001000)\n\n"
-
-    "--host-out=<addr>      Message output detection address (default: 0x00000000 - off)\n"
-    "                       Example: --host-out=0x00000000\n"
-    "Note:                  Must not be 0x0\n\n"
-
-    "--quiet                Use --quiet to disable messages (default: messages enable)\n"
-    "                       Example: --quiet (equivalent: --log-level=QUIET)\n"
-
-    "--log-out              Output file log (default: none)\n"
-    "                       Example: --log-out=my_log.txt\n"
-
-    "--log-level            Log level (default: DEBUG)\n"
-    "                       Example: --log-level=DEBUG\n"
-    "Note:                  Available: DEBUG, INFO, WARNING, ERROR, CRITICAL, QUIET\n\n"
-
-    "\n\n"
-    "Example:\n"
-    "unit_tests --ram-init-h32=add-01.hex --ram-dump-h32=add-01-dump.hex"
-    "unit_tests --out-wave=wave.fst --ram-init-h32=add-01.hex --ram-dump-h32=add-01-dump.hex"
-    "unit_tests --ram-init-h32=main.hex --host-out=0x4";
-
-enum opts
-{
-  cmd_help = 0,
-
-  cmd_out_wave,
-  cmd_ram_init_h32,
-  cmd_ram_init_bin,
-  cmd_ram_dump_h32,
-  cmd_cycles,
-  //    cmd_ecall,
-  cmd_wr_addr,
-  cmd_dump_h32,
-  cmd_host_out,
-  cmd_quiet,
-  cmd_log_out,
-  cmd_log_level,
-};
-
-static constexpr option long_opts[] =
-    {
-        {"help", no_argument, NULL, opts::cmd_help},
-        {"out-wave", required_argument, NULL, opts::cmd_out_wave},
-        {"ram-init-h32", required_argument, NULL, opts::cmd_ram_init_h32},
-        {"ram-init-bin", required_argument, NULL, opts::cmd_ram_init_bin},
-        {"ram-dump-h32", required_argument, NULL, opts::cmd_ram_dump_h32},
-        {"cycles", required_argument, NULL, opts::cmd_cycles},
-        //        { "ecall",          no_argument,        NULL, opts::cmd_ecall               },
-        {"wr-addr", required_argument, NULL, opts::cmd_wr_addr},
-        {"host-out", required_argument, NULL, opts::cmd_host_out},
-        {"quiet", no_argument, NULL, opts::cmd_quiet},
-        {"log-out", required_argument, NULL, opts::cmd_log_out},
-        {"log-level", required_argument, NULL, opts::cmd_log_level},
-        {NULL, no_argument, NULL, 0}};
-
-static size_t get_int_arg(const char *arg)
-{
-  char *p;
-  return strtoull(arg, &p, 0);
-}
-
-Args parser(int argc, char *argv[])
-{
-  Args args;
-  int opt;
-
-  while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1)
-  {
-    switch (opt)
-    {
-    case opts::cmd_help:
-      std::cout << help_str;
-      std::exit(EXIT_SUCCESS);
-
-    case opts::cmd_out_wave:
-      args.out_wave_path = optarg;
-      Log::info("Wave out: %s", optarg);
-      break;
-
-    case opts::cmd_ram_init_h32:
-      args.ram_init_path = optarg;
-      args.ram_init_variants = RamInitVariants::H32;
-      Log::info("Input init ram h32 file: %s", optarg);
-      break;
-
-    case opts::cmd_ram_init_bin:
-      args.ram_init_path = optarg;
-      args.ram_init_variants = RamInitVariants::BIN;
-      Log::info("Input init ram bin file: %s", optarg);
-      break;
-
-    case opts::cmd_ram_dump_h32:
-      args.ram_dump_h32 = optarg;
-      Log::info("Output dump ram file: %s", optarg);
-      break;
-
-    case opts::cmd_cycles:
-      args.max_cycles = get_int_arg(optarg);
-      Log::info("Max cycles: %u", args.max_cycles);
-      break;
-
-    case opts::cmd_wr_addr:
-      args.wr_addr = get_int_arg(optarg);
-      Log::info("Write address: 0x%x", args.wr_addr);
-      break;
-
-    case opts::cmd_host_out:
-      args.host_out = get_int_arg(optarg);
-      Log::info("Host out: 0x%x", args.host_out);
-      break;
-
-    case opts::cmd_quiet:
-      Log::set_level(Log::QUIET);
-      break;
-
-    case opts::cmd_log_out:
-      Log::set_out(optarg);
-      break;
-
-    case opts::cmd_log_level:
-      Log::set_level(optarg);
-      break;
-
-    default:
-      Log::info("Please call for help: --help\n");
-      std::exit(EXIT_SUCCESS);
-    }
-  }
-
-  return args;
-}
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "argparse.h"
+
+#include <stdlib.h>
+#include <iostream>
+#include <getopt.h>
+#include <cinttypes>
+#include <string.h>
+
+#include "log.h"
+
+const char *help_str =
+    "Use: app_name.run [options]\n"
+    "Options:\n"
+    "--out-wave=<name>      Output file *.fst (defaul: none - off)\n\n"
+    "--trace-start=<num>    Start tracing at the given cycle (default: 0)\n"
+    "--trace-stop=<num>     Stop tracing at the given cycle (default: 0 - until exit)\n"
+    "--trace-cycles=<num>   Number of cycles to trace once tracing starts (default: 0 - until exit)\n"
+    "--trace-pc=<addr>      Start tracing when the program counter reaches <addr>\n"
+    "--trace-addr=<addr>    Start tracing on the first write to <addr>\n"
+    "--trace-scope=<name>   Trace only the given hierarchy (default: none - all)\n"
+    "                       Example: --trace-scope=TOP.unit_tests.rvsteel_core_instance\n"
+    "Note:                  --trace-* options only take effect with --out-wave\n\n"
+    "--wave-on-failure=<num>\n"
+    "                       Keep the last <num> cycles in memory and write them as FST only\n"
+    "                       if the run fails: end cycles without wr-addr, trap or SIGINT\n"
+    "                       Example: --wave-on-failure=10000\n"
+    "--wave-on-failure-out=<name>\n"
+    "                       Output file of --wave-on-failure (default: failure.fst)\n\n"
+    "--ram-init-h32=<name>  Input init ram file in h32 format (defaul: none - off)\n"
+    "                       Example: --ram-init-h32=my_program.hex\n\n"
+    "--ram-init-bin=<name>  Input init ram file in bin format (defaul: none)\n"
+    "                       Example: --ram-init-bin=my_program.bin\n\n"
+    "--ram-init-elf=<name>  Input init ram file in ELF format (defaul: none)\n"
+    "                       Example: --ram-init-elf=my_program.elf\n"
+    "Note:                  The tohost, begin_signature and end_signature symbols are used\n"
+    "                       when present\n\n"
+    "--host-out-symbol=<name>\n"
+    "                       Use the address of ELF symbol <name> as --host-out\n"
+    "                       Example: --host-out-symbol=console\n\n"
+    "--ram-file=<name>      Map the RAM onto file <name>, created if missing (default: none)\n"
+    "--ram-dump-pages=<name>\n"
+    "                       At exit, write the touched RAM pages in h32 format with @addresses\n"
+    "Note:                  Only in builds with the sparse RAM (RVSTEEL_RAM_DPI)\n\n"
+
+    "--ram-dump-h32=<name>  Output dump ram file in h32 format (defaul: none - off)\n"
+    "Note:                  If the file is not specified then the dump are not created.\n\n"
+    "--ram-dump-bin=<name>  Output dump ram file in bin format (defaul: none - off)\n\n"
+    "--compare-ref=<name>   Compare the signature with the h32 reference <name> at exit and\n"
+    "                       print a PASS/FAIL/TIMEOUT line as --batch does\n"
+    "Note:                  The exit code is nonzero if the signature differs or is missing\n\n"
+    "--cpi-stack=<name>     Count every cycle as retired, load wait, store wait, flush, trap,\n"
+    "                       halted or bus wait, log the CPI of each at exit and write them,\n"
+    "                       in total and per --ram-init-elf function, to <name>\n"
+    "                       Example: --cpi-stack=app.cpi\n\n"
+    "--commit-log=<name>    Write every retired instruction (pc, instruction, rd write, memory\n"
+    "                       access) and trap to <name> in a compact binary format. Print it\n"
+    "                       as spike --log-commits text with: commit_log_decode <name>\n"
+    "                       Example: --commit-log=app.commits\n\n"
+    "--lockstep             Check every retired instruction and trap against a built-in\n"
+    "                       RV32I/Zicsr model of the core and stop at the first difference\n"
+    "Note:                  With --compare-ref a difference prints a MISMATCH line\n\n"
+    "--stats=<name>         Write a JSON summary of the run to <name> at exit: exit reason,\n"
+    "                       wall time, startup time, simulated cycles, host kHz, mcycle,\n"
+    "                       minstret, CPI, host-out bytes, peak RSS and traps by mcause\n"
+    "                       Example: --stats=app.json\n\n"
+    "\n\n"
+
+    "--batch=<name>         Run every \"<program> <reference>\" pair of the manifest <name>\n"
+    "                       in-process and print one PASS/FAIL/TIMEOUT line per program\n"
+    "                       Example: --batch=manifest.txt\n"
+    "--jobs=<num>           Model instances of --batch and --fuzz (default: 0 - all cores)\n"
+    "Note:                  --batch uses --cycles and --wr-addr, other options are ignored\n\n"
+    "--fuzz=<num>           Run <num> random RV32I/Zicsr programs, with traps, CSR accesses and\n"
+    "                       misaligned loads and stores, each in a process forked after reset,\n"
+    "                       checking them against the --lockstep model. The programs that fail\n"
+    "                       are written to fuzz-<seed>.hex, to rerun with:\n"
+    "                       --ram-init-h32=fuzz-<seed>.hex --wr-addr=0x3ffc --lockstep\n"
+    "--fuzz-seed=<num>      Seed of the first program, the next ones count up (default: 1)\n"
+    "                       Example: --fuzz=100000 --fuzz-seed=1000000\n"
+    "Note:                  --fuzz runs --jobs processes and uses --cycles per program, other\n"
+    "                       options are ignored\n\n"
+
+    "The end of the program is:\n"
+    "--cycles=<num>         Exit after processor cycles complete (default: 500000)\n"
+    "                       Example: --cycles=10000\n\n"
+    //    "--ecall            Exit if there is an instruction ecall\n"
+    "--wr-addr=<addr>       Exit if there is an entry at the specified address (default: 0x00001000)\n"
+    "                       Example: --wr-addr=0x00001000)\n\n"
+
+    "--host-out=<addr>      Message output detection address (default: 0x00000000 - off)\n"
+    "                       Example: --host-out=0x00000000\n"
+    "Note:                  Must not be 0x0\n\n"
+    "--semihosting          Service the RISC-V semihosting calls (slli x0; ebreak; srai x0) on\n"
+    "                       the host: SYS_OPEN, SYS_CLOSE, SYS_READ, SYS_WRITE, SYS_WRITEC,\n"
+    "                       SYS_WRITE0, SYS_CLOCK, SYS_EXIT and SYS_EXIT_EXTENDED. The ebreak\n"
+    "                       retires as a nop, the call itself takes no cycles. SYS_EXIT ends\n"
+    "                       the run with the exit code of the program\n\n"
+
+    "--quiet                Use --quiet to disable messages (default: messages enable)\n"
+    "                       Example: --quiet (equivalent: --log-level=QUIET)\n"
+
+    "--log-out              Output file log (default: none)\n"
+    "                       Example: --log-out=my_log.txt\n"
+
+    "--log-level            Log level (default: DEBUG)\n"
+    "                       Example: --log-level=DEBUG\n"
+    "Note:                  Available: DEBUG, INFO, WARNING, ERROR, CRITICAL, QUIET\n\n"
+
+    "\n\n"
+    "Example:\n"
+    "unit_tests --ram-init-h32=add-01.hex --ram-dump-h32=add-01-dump.hex"
+    "unit_tests --out-wave=wave.fst --ram-init-h32=add-01.hex --ram-dump-h32=add-01-dump.hex"
+    "unit_tests --ram-init-h32=main.hex --host-out=0x4";
+
+enum opts
+{
+  cmd_help = 0,
+
+  cmd_out_wave,
+  cmd_trace_start,
+  cmd_trace_stop,
+  cmd_trace_cycles,
+  cmd_trace_pc,
+  cmd_trace_addr,
+  cmd_trace_scope,
+  cmd_wave_on_failure,
+  cmd_wave_on_failure_out,
+  cmd_ram_init_h32,
+  cmd_ram_init_bin,
+  cmd_ram_init_elf,
+  cmd_host_out_symbol,
+  cmd_ram_file,
+  cmd_ram_dump_pages,
+  cmd_ram_dump_h32,
+  cmd_ram_dump_bin,
+  cmd_compare_ref,
+  cmd_cpi_stack,
+  cmd_commit_log,
+  cmd_lockstep,
+  cmd_stats,
+  cmd_batch,
+  cmd_jobs,
+  cmd_fuzz,
+  cmd_fuzz_seed,
+  cmd_cycles,
+  //    cmd_ecall,
+  cmd_wr_addr,
+  cmd_dump_h32,
+  cmd_host_out,
+  cmd_semihosting,
+  cmd_quiet,
+  cmd_log_out,
+  cmd_log_level,
+};
+
+static constexpr option long_opts[] =
+    {
+        {"help", no_argument, NULL, opts::cmd_help},
+        {"out-wave", required_argument, NULL, opts::cmd_out_wave},
+        {"trace-start", required_argument, NULL, opts::cmd_trace_start},
+        {"trace-stop", required_argument, NULL, opts::cmd_trace_stop},
+        {"trace-cycles", required_argument, NULL, opts::cmd_trace_cycles},
+        {"trace-pc", required_argument, NULL, opts::cmd_trace_pc},
+        {"trace-addr", required_argument, NULL, opts::cmd_trace_addr},
+        {"trace-scope", required_argument, NULL, opts::cmd_trace_scope},
+        {"wave-on-failure", required_argument, NULL, opts::cmd_wave_on_failure},
+        {"wave-on-failure-out", required_argument, NULL, opts::cmd_wave_on_failure_out},
+        {"ram-init-h32", required_argument, NULL, opts::cmd_ram_init_h32},
+        {"ram-init-bin", required_argument, NULL, opts::cmd_ram_init_bin},
+        {"ram-init-elf", required_argument, NULL, opts::cmd_ram_init_elf},
+        {"host-out-symbol", required_argument, NULL, opts::cmd_host_out_symbol},
+        {"ram-file", required_argument, NULL, opts::cmd_ram_file},
+        {"ram-dump-pages", required_argument, NULL, opts::cmd_ram_dump_pages},
+        {"ram-dump-h32", required_argument, NULL, opts::cmd_ram_dump_h32},
+        {"ram-dump-bin", required_argument, NULL, opts::cmd_ram_dump_bin},
+        {"compare-ref", required_argument, NULL, opts::cmd_compare_ref},
+        {"cpi-stack", required_argument, NULL, opts::cmd_cpi_stack},
+        {"commit-log", required_argument, NULL, opts::cmd_commit_log},
+        {"lockstep", no_argument, NULL, opts::cmd_lockstep},
+        {"stats", required_argument, NULL, opts::cmd_stats},
+        {"batch", required_argument, NULL, opts::cmd_batch},
+        {"jobs", required_argument, NULL, opts::cmd_jobs},
+        {"fuzz", required_argument, NULL, opts::cmd_fuzz},
+        {"fuzz-seed", required_argument, NULL, opts::cmd_fuzz_seed},
+        {"cycles", required_argument, NULL, opts::cmd_cycles},
+        //        { "ecall",          no_argument,        NULL, opts::cmd_ecall               },
+        {"wr-addr", required_argument, NULL, opts::cmd_wr_addr},
+        {"host-out", required_argument, NULL, opts::cmd_host_out},
+        {"semihosting", no_argument, NULL, opts::cmd_semihosting},
+        {"quiet", no_argument, NULL, opts::cmd_quiet},
+        {"log-out", required_argument, NULL, opts::cmd_log_out},
+        {"log-level", required_argument, NULL, opts::cmd_log_level},
+        {NULL, no_argument, NULL, 0}};
+
+static size_t get_int_arg(const char *arg)
+{
+  char *p;
+  return strtoull(arg, &p, 0);
+}
+
+Args parser(int argc, char *argv[])
+{
+  Args args;
+  int opt;
+
+  while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case opts::cmd_help:
+      std::cout << help_str;
+      std::exit(EXIT_SUCCESS);
+
+    case opts::cmd_out_wave:
+      args.out_wave_path = optarg;
+      Log::info("Wave out: %s", optarg);
+      break;
+
+    case opts::cmd_trace_start:
+      args.trace_start = get_int_arg(optarg);
+      Log::info("Trace start: %" PRIu64, args.trace_start);
+      break;
+
+    case opts::cmd_trace_stop:
+      args.trace_stop = get_int_arg(optarg);
+      Log::info("Trace stop: %" PRIu64, args.trace_stop);
+      break;
+
+    case opts::cmd_trace_cycles:
+      args.trace_cycles = get_int_arg(optarg);
+      Log::info("Trace cycles: %" PRIu64, args.trace_cycles);
+      break;
+
+    case opts::cmd_trace_pc:
+      args.trace_pc = get_int_arg(optarg);
+      args.trace_pc_enable = true;
+      Log::info("Trace pc: 0x%x", args.trace_pc);
+      break;
+
+    case opts::cmd_trace_addr:
+      args.trace_addr = get_int_arg(optarg);
+      args.trace_addr_enable = true;
+      Log::info("Trace address: 0x%x", args.trace_addr);
+      break;
+
+    case opts::cmd_trace_scope:
+      args.trace_scope = optarg;
+      Log::info("Trace scope: %s", optarg);
+      break;
+
+    case opts::cmd_wave_on_failure:
+      args.wave_on_failure = get_int_arg(optarg);
+      Log::info("Wave on failure: %u cycles", args.wave_on_failure);
+      break;
+
+    case opts::cmd_wave_on_failure_out:
+      args.wave_on_failure_path = optarg;
+      Log::info("Wave on failure out: %s", optarg);
+      break;
+
+    case opts::cmd_ram_init_h32:
+      args.ram_init_path = optarg;
+      args.ram_init_variants = RamInitVariants::H32;
+      Log::info("Input init ram h32 file: %s", optarg);
+      break;
+
+    case opts::cmd_ram_init_bin:
+      args.ram_init_path = optarg;
+      args.ram_init_variants = RamInitVariants::BIN;
+      Log::info("Input init ram bin file: %s", optarg);
+      break;
+
+    case opts::cmd_ram_init_elf:
+      args.ram_init_path = optarg;
+      args.ram_init_variants = RamInitVariants::ELF;
+      Log::info("Input init ram elf file: %s", optarg);
+      break;
+
+    case opts::cmd_host_out_symbol:
+      args.host_out_symbol = optarg;
+      Log::info("Host out symbol: %s", optarg);
+      break;
+
+    case opts::cmd_ram_file:
+      args.ram_file_path = optarg;
+      Log::info("Ram file: %s", optarg);
+      break;
+
+    case opts::cmd_ram_dump_pages:
+      args.ram_dump_pages = optarg;
+      Log::info("Output dump ram pages file: %s", optarg);
+      break;
+
+    case opts::cmd_ram_dump_h32:
+      args.ram_dump_h32 = optarg;
+      Log::info("Output dump ram file: %s", optarg);
+      break;
+
+    case opts::cmd_ram_dump_bin:
+      args.ram_dump_bin = optarg;
+      Log::info("Output dump ram bin file: %s", optarg);
+      break;
+
+    case opts::cmd_compare_ref:
+      args.compare_ref = optarg;
+      Log::info("Reference file: %s", optarg);
+      break;
+
+    case opts::cmd_batch:
+      args.batch_path = optarg;
+      Log::info("Batch manifest: %s", optarg);
+      break;
+
+    case opts::cmd_cpi_stack:
+      args.cpi_stack_path = optarg;
+      Log::info("CPI stack: %s", optarg);
+      break;
+
+    case opts::cmd_commit_log:
+      args.commit_log_path = optarg;
+      Log::info("Commit log: %s", optarg);
+      break;
+
+    case opts::cmd_lockstep:
+      args.lockstep = true;
+      Log::info("Lockstep with the golden model");
+      break;
+
+    case opts::cmd_stats:
+      args.stats_path = optarg;
+      Log::info("Stats: %s", optarg);
+      break;
+
+    case opts::cmd_jobs:
+      args.jobs = get_int_arg(optarg);
+      Log::info("Jobs: %u", args.jobs);
+      break;
+
+    case opts::cmd_fuzz:
+      args.fuzz = get_int_arg(optarg);
+      Log::info("Fuzz: %" PRIu64 " programs", args.fuzz);
+      break;
+
+    case opts::cmd_fuzz_seed:
+      args.fuzz_seed = get_int_arg(optarg);
+      Log::info("Fuzz seed: %" PRIu64, args.fuzz_seed);
+      break;
+
+    case opts::cmd_cycles:
+      args.max_cycles = get_int_arg(optarg);
+      Log::info("Max cycles: %u", args.max_cycles);
+      break;
+
+    case opts::cmd_wr_addr:
+      args.wr_addr = get_int_arg(optarg);
+      Log::info("Write address: 0x%x", args.wr_addr);
+      break;
+
+    case opts::cmd_host_out:
+      args.host_out = get_int_arg(optarg);
+      Log::info("Host out: 0x%x", args.host_out);
+      break;
+
+    case opts::cmd_semihosting:
+      args.semihosting = true;
+      Log::info("Semihosting");
+      break;
+
+    case opts::cmd_quiet:
+      Log::set_level(Log::QUIET);
+      break;
+
+    case opts::cmd_log_out:
+      Log::set_out(optarg);
+      break;
+
+    case opts::cmd_log_level:
+      Log::set_level(optarg);
+      break;
+
+    default:
+      Log::info("Please call for help: --help\n");
+      std::exit(EXIT_SUCCESS);
+    }
+  }
+
+  return args;
+}
@@ -1,34 +1,59 @@
-// ----------------------------------------------------------------------------
-// Copyright (c) 2020-2024 RISC-V Steel contributors
-//
-// This work is licensed under the MIT License, see LICENSE file for details.
-// SPDX-License-Identifier: MIT
-// ----------------------------------------------------------------------------
-
-#ifndef ARGPARSE_H
-#define ARGPARSE_H
-
-#include <cstdint>
-#include <cstddef>
-
-enum RamInitVariants
-{
-  NONE,
-  H32,
-  BIN,
-};
-
-struct Args
-{
-  char *out_wave_path{nullptr};
-  char *ram_init_path{nullptr};
-  RamInitVariants ram_init_variants{NONE};
-  char *ram_dump_h32{nullptr};
-  uint32_t max_cycles{500000};
-  uint32_t wr_addr{0x00001000};
-  uint32_t host_out{0x00000000};
-};
-
-Args parser(int argc, char *argv[]);
-
-#endif // ARGPARSE_H
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef ARGPARSE_H
+#define ARGPARSE_H
+
+#include <cstdint>
+#include <cstddef>
+
+enum RamInitVariants
+{
+  NONE,
+  H32,
+  BIN,
+  ELF,
+};
+
+struct Args
+{
+  char *out_wave_path{nullptr};
+  char *ram_init_path{nullptr};
+  RamInitVariants ram_init_variants{NONE};
+  char *host_out_symbol{nullptr};
+  char *ram_file_path{nullptr};
+  char *ram_dump_pages{nullptr};
+  char *ram_dump_h32{nullptr};
+  char *ram_dump_bin{nullptr};
+  char *compare_ref{nullptr};
+  char *cpi_stack_path{nullptr};
+  char *commit_log_path{nullptr};
+  bool lockstep{false};
+  char *stats_path{nullptr};
+  uint32_t max_cycles{500000};
+  uint32_t wr_addr{0x00001000};
+  uint32_t host_out{0x00000000};
+  bool semihosting{false};
+  char *trace_scope{nullptr};
+  uint64_t trace_start{0};
+  uint64_t trace_stop{0};
+  uint64_t trace_cycles{0};
+  bool trace_pc_enable{false};
+  uint32_t trace_pc{0x00000000};
+  bool trace_addr_enable{false};
+  uint32_t trace_addr{0x00000000};
+  uint32_t wave_on_failure{0};
+  const char *wave_on_failure_path{"failure.fst"};
+  char *batch_path{nullptr};
+  uint32_t jobs{0};
+  uint64_t fuzz{0};
+  uint64_t fuzz_seed{1};
+};
+
+Args parser(int argc, char *argv[]);
+
+#endif // ARGPARSE_H
@@ -0,0 +1,301 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <verilated.h>
+
+#include "Vunit_tests.h"
+#include "Vunit_tests___024root.h"
+#include "log.h"
+#include "monitor.h"
+#include "ram_init.h"
+#include "signature.h"
+#include "sparse_ram.h"
+
+// RAM words holding the signature boundaries
+static constexpr uint32_t SIGNATURE_START = 2047;
+static constexpr uint32_t SIGNATURE_STOP = 2046;
+
+#ifdef RVSTEEL_MONITOR_DPI
+// Set by the bus write monitor. A model reports its writes from eval(), on the
+// thread of the worker that owns it.
+static thread_local bool wr_addr_written = false;
+#endif
+
+struct BatchJob
+{
+  std::string program;
+  std::string reference;
+};
+
+struct BatchResult
+{
+  enum Status
+  {
+    PASS,
+    FAIL,
+    TIMEOUT
+  };
+
+  Status status{TIMEOUT};
+  uint64_t cycles{0};
+  uint32_t line{0}; // First signature line that differs, from 1
+  uint32_t signature{0};
+  uint32_t reference{0};
+};
+
+// A model instance with its own context. Programs run back to back on the same
+// instance: the core is reset and the RAM reloaded in place between them.
+class BatchSim
+{
+  public:
+    BatchSim(const Args &args, uint32_t reset_edges)
+        : args(args), reset_edges(reset_edges), dut(new Vunit_tests(&context))
+    {
+    }
+
+    ~BatchSim()
+    {
+      dut->final();
+    }
+
+    BatchResult run(const BatchJob &job);
+
+  private:
+    const Args &args;
+    const uint32_t reset_edges;
+    VerilatedContext context;
+    std::unique_ptr<Vunit_tests> dut;
+
+    void edge()
+    {
+      dut->clock ^= 1;
+      dut->eval();
+    }
+
+    uint32_t *ram_words() const;
+    void reset();
+    void load(const char *path);
+    bool is_finished() const;
+    void compare(const char *path, BatchResult &result) const;
+};
+
+uint32_t *BatchSim::ram_words() const
+{
+#ifdef RVSTEEL_RAM_DPI
+  void *ram = dut->rootp->unit_tests__DOT__rvsteel_ram_instance__DOT__ram_handle;
+  return static_cast<SparseRam *>(ram)->data();
+#else
+  return &dut->rootp->unit_tests__DOT__rvsteel_ram_instance__DOT__ram[0];
+#endif
+}
+
+void BatchSim::reset()
+{
+  dut->reset = 1;
+
+  for (uint32_t i = 0; i < reset_edges; i++)
+  {
+    edge();
+  }
+
+  dut->reset = 0;
+  dut->halt = 0;
+}
+
+void BatchSim::load(const char *path)
+{
+  uint32_t ram_size = dut->rootp->unit_tests__DOT__MEMORY_SIZE;
+
+  ram_init_h32(path, ram_words(), ram_size / 4);
+}
+
+bool BatchSim::is_finished() const
+{
+#ifdef RVSTEEL_MONITOR_DPI
+  return wr_addr_written;
+#else
+  return (dut->rootp->unit_tests__DOT__rw_address == args.wr_addr) &&
+         dut->rootp->unit_tests__DOT__write_request &&
+         dut->rootp->unit_tests__DOT__write_data == 0x00000001;
+#endif
+}
+
+void BatchSim::compare(const char *path, BatchResult &result) const
+{
+  const uint32_t *ram = ram_words();
+  uint32_t ram_size = dut->rootp->unit_tests__DOT__MEMORY_SIZE;
+  uint32_t start = ram[SIGNATURE_START];
+  uint32_t stop = ram[SIGNATURE_STOP];
+
+  // Boundaries the program did not write, or wrote wrong, would read past the
+  // RAM of a model shared by the whole batch
+  if (not signature_in_ram(start, stop, ram_size))
+  {
+    Log::error("Bad signature boundaries 0x%08x-0x%08x, reference %s", start, stop, path);
+    result.status = BatchResult::FAIL;
+    return;
+  }
+
+  SignatureCompare compare = signature_compare(path, ram + start / 4, (stop - start) / 4);
+
+  result.status = compare.match ? BatchResult::PASS : BatchResult::FAIL;
+  result.line = compare.line;
+  result.signature = compare.signature;
+  result.reference = compare.reference;
+}
+
+BatchResult BatchSim::run(const BatchJob &job)
+{
+  BatchResult result;
+
+  reset();
+  load(job.program.c_str());
+
+#ifdef RVSTEEL_MONITOR_DPI
+  wr_addr_written = false;
+#endif
+
+  // --cycles=0 runs until the signature is written, as in a single run
+  while (not args.max_cycles or result.cycles < args.max_cycles)
+  {
+    edge();
+    result.cycles += dut->clock & 0x1;
+
+    if (is_finished())
+    {
+      compare(job.reference.c_str(), result);
+      break;
+    }
+  }
+
+  return result;
+}
+
+// One "<program> <reference>" pair per line, '#' starts a comment
+static std::vector<BatchJob> read_manifest(const char *path)
+{
+  std::ifstream file(path);
+
+  if (!file.is_open())
+  {
+    Log::error("Error file opening: %s", path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::vector<BatchJob> jobs;
+  std::string line;
+
+  while (std::getline(file, line))
+  {
+    std::istringstream ss(line.substr(0, line.find('#')));
+    BatchJob job;
+
+    if (not(ss >> job.program))
+    {
+      continue;
+    }
+
+    if (not(ss >> job.reference))
+    {
+      Log::error("Missing reference for %s in %s", job.program.c_str(), path);
+      std::exit(EXIT_FAILURE);
+    }
+
+    jobs.push_back(job);
+  }
+
+  return jobs;
+}
+
+int run_batch(const Args &args, uint32_t reset_edges)
+{
+  std::vector<BatchJob> jobs = read_manifest(args.batch_path);
+  std::vector<BatchResult> results(jobs.size());
+  std::atomic<size_t> next{0};
+
+  size_t threads = args.jobs ? args.jobs : std::thread::hardware_concurrency();
+  threads = std::max<size_t>(1, std::min(threads, jobs.size()));
+
+  Log::info("Batch: %zu programs on %zu threads", jobs.size(), threads);
+
+#ifdef RVSTEEL_MONITOR_DPI
+  Monitor::on_bus_write(
+      [&args](const Monitor::BusWrite &write)
+      {
+        if (write.address == args.wr_addr and write.data == 1)
+        {
+          wr_addr_written = true;
+        }
+      });
+#endif
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+
+  // Each worker owns a model and pulls the next program until none are left
+  for (size_t i = 0; i < threads; i++)
+  {
+    pool.emplace_back([&]() {
+      BatchSim sim(args, reset_edges);
+
+      for (size_t n = next++; n < jobs.size(); n = next++)
+      {
+        results[n] = sim.run(jobs[n]);
+      }
+    });
+  }
+
+  for (std::thread &worker : pool)
+  {
+    worker.join();
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  size_t passed = 0;
+
+  for (size_t n = 0; n < jobs.size(); n++)
+  {
+    const BatchResult &result = results[n];
+    const char *program = jobs[n].program.c_str();
+
+    switch (result.status)
+    {
+    case BatchResult::PASS:
+      passed++;
+      std::printf("PASS %s %" PRIu64 "\n", program, result.cycles);
+      break;
+
+    case BatchResult::FAIL:
+      std::printf("FAIL %s %" PRIu64 " %u 0x%08" PRIx32 " 0x%08" PRIx32 "\n", program,
+                  result.cycles, result.line, result.signature, result.reference);
+      break;
+
+    case BatchResult::TIMEOUT:
+      std::printf("TIMEOUT %s %" PRIu64 "\n", program, result.cycles);
+      break;
+    }
+  }
+
+  std::fflush(stdout);
+  Log::info("Batch: %zu of %zu passed in %.3f s", passed, jobs.size(), elapsed.count());
+
+  return passed == jobs.size() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
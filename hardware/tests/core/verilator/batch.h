@@ -0,0 +1,28 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstdint>
+
+#include "argparse.h"
+
+// Clock edges that hold reset for 100ns, in the single program run and in
+// every program of the batch
+inline uint32_t reset_edges(uint64_t clk_half_cycles)
+{
+  return (100 + clk_half_cycles - 1) / clk_half_cycles;
+}
+
+// Runs every program/reference pair of the --batch manifest on a pool of
+// --jobs model instances and prints one result line per program, in manifest
+// order, each reset for reset_edges(). Returns EXIT_SUCCESS when every
+// signature matches its reference.
+int run_batch(const Args &args, uint32_t reset_edges);
+
+#endif // BATCH_H
@@ -0,0 +1,434 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "commit_log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "log.h"
+
+static inline uint8_t *put_varint(uint8_t *p, uint32_t value)
+{
+  while (value >= 0x80)
+  {
+    *p++ = (value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+
+  *p++ = value;
+  return p;
+}
+
+static inline uint8_t *put_delta(uint8_t *p, uint32_t value, uint32_t base)
+{
+  int32_t delta = (int32_t)(value - base);
+  return put_varint(p, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+}
+
+// Both return nullptr past end
+static inline const uint8_t *get_varint(const uint8_t *p, const uint8_t *end, uint32_t &value)
+{
+  value = 0;
+
+  for (int shift = 0; shift < 35; shift += 7)
+  {
+    if (p == end)
+    {
+      return nullptr;
+    }
+
+    uint8_t byte = *p++;
+    value |= (uint32_t)(byte & 0x7f) << shift;
+
+    if (not(byte & 0x80))
+    {
+      return p;
+    }
+  }
+
+  return nullptr;
+}
+
+static inline const uint8_t *get_delta(const uint8_t *p, const uint8_t *end, uint32_t &value,
+                                       uint32_t base)
+{
+  uint32_t zigzag;
+  p = get_varint(p, end, zigzag);
+  value = base + ((zigzag >> 1) ^ -(zigzag & 1));
+  return p;
+}
+
+static const char *exception_name(uint32_t cause)
+{
+  switch (cause)
+  {
+  case 0: return "trap_instruction_address_misaligned";
+  case 1: return "trap_instruction_access_fault";
+  case 2: return "trap_illegal_instruction";
+  case 3: return "trap_breakpoint";
+  case 4: return "trap_load_address_misaligned";
+  case 5: return "trap_load_access_fault";
+  case 6: return "trap_store_address_misaligned";
+  case 7: return "trap_store_access_fault";
+  case 11: return "trap_machine_ecall";
+  default: return "trap_unknown";
+  }
+}
+
+std::string commit_to_string(const CommitRecord &record)
+{
+  char text[128];
+  int n;
+
+  if (record.trap)
+  {
+    if (record.cause & 0x80000000)
+    {
+      n = snprintf(text, sizeof(text), "core   0: interrupt #%u, epc 0x%08x",
+                   record.cause & 0x7fffffff, record.epc);
+    }
+    else
+    {
+      n = snprintf(text, sizeof(text), "core   0: exception %s, epc 0x%08x",
+                   exception_name(record.cause), record.epc);
+    }
+
+    return std::string(text, n);
+  }
+
+  n = snprintf(text, sizeof(text), "core   0: 3 0x%08x (0x%08x)", record.pc, record.instruction);
+
+  if (record.rd_write)
+  {
+    n += snprintf(text + n, sizeof(text) - n, " x%-2u 0x%08x", record.rd, record.rd_value);
+  }
+
+  if (record.load or record.store)
+  {
+    n += snprintf(text + n, sizeof(text) - n, " mem 0x%08x", record.address);
+  }
+
+  if (record.store)
+  {
+    // sb, sh and sw from funct3
+    int digits = 2 << ((record.instruction >> 12) & 0x3);
+    n += snprintf(text + n, sizeof(text) - n, " 0x%0*x", digits, record.store_value);
+  }
+
+  return std::string(text, n);
+}
+
+CommitLogFormat::CommitLogFormat()
+{
+  // Never an instruction address
+  std::fill_n(table_pc, TABLE_SIZE, UINT32_MAX);
+  std::fill_n(table_instruction, TABLE_SIZE, 0);
+}
+
+CommitLog::~CommitLog()
+{
+  close();
+}
+
+void CommitLog::open(const char *path)
+{
+  file = fopen(path, "wb");
+
+  if (!file)
+  {
+    Log::error("Error file opening: %s", path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  buffers[0].reset(new uint8_t[BUFFER_SIZE]);
+  buffers[1].reset(new uint8_t[BUFFER_SIZE]);
+  active = buffers[0].get();
+  std::memcpy(active, MAGIC, sizeof(MAGIC));
+  used = sizeof(MAGIC);
+
+  writer = std::thread(&CommitLog::drain, this);
+}
+
+void CommitLog::write(const CommitRecord &record)
+{
+  if (used + MAX_RECORD > BUFFER_SIZE)
+  {
+    swap();
+  }
+
+  uint8_t *tag = active + used;
+  uint8_t *p = tag + 1;
+
+  if (record.trap)
+  {
+    *tag = TRAP;
+    p = put_varint(p, record.cause);
+    p = put_varint(p, record.epc);
+
+    if (record.rd_write)
+    {
+      *tag |= RD_WRITE;
+      *p++ = record.rd;
+      p = put_varint(p, record.rd_value);
+    }
+
+    used = p - active;
+    return;
+  }
+
+  uint8_t flags = 0;
+
+  if (record.pc != next_pc)
+  {
+    flags |= PC_JUMP;
+    p = put_delta(p, record.pc, next_pc);
+  }
+
+  uint32_t index = table_index(record.pc);
+
+  if (table_pc[index] != record.pc or table_instruction[index] != record.instruction)
+  {
+    flags |= INSTRUCTION;
+    table_pc[index] = record.pc;
+    table_instruction[index] = record.instruction;
+    std::memcpy(p, &record.instruction, 4);
+    p += 4;
+  }
+
+  if (record.rd_write)
+  {
+    flags |= RD_WRITE;
+    *p++ = record.rd;
+    p = put_varint(p, record.rd_value);
+  }
+
+  if (record.load or record.store)
+  {
+    flags |= record.load ? LOAD : STORE;
+    p = put_delta(p, record.address, prev_address);
+    prev_address = record.address;
+  }
+
+  if (record.store)
+  {
+    p = put_varint(p, record.store_value);
+  }
+
+  *tag = flags;
+  used = p - active;
+  next_pc = record.pc + 4;
+}
+
+// Hands the active buffer to the writer and continues in the other one, once
+// the writer is done with it
+void CommitLog::swap()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  wake.wait(lock, [this] { return pending == nullptr; });
+
+  pending = active;
+  pending_size = used;
+  active = active == buffers[0].get() ? buffers[1].get() : buffers[0].get();
+  used = 0;
+
+  wake.notify_all();
+}
+
+// Writer thread
+void CommitLog::drain()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+
+  while (true)
+  {
+    wake.wait(lock, [this] { return pending != nullptr or stop; });
+
+    if (pending)
+    {
+      const uint8_t *data = pending;
+      size_t size = pending_size;
+
+      lock.unlock();
+      bool ok = fwrite(data, 1, size, file) == size;
+      lock.lock();
+
+      failed |= not ok;
+      pending = nullptr;
+      wake.notify_all();
+    }
+    else if (stop)
+    {
+      return;
+    }
+  }
+}
+
+void CommitLog::close()
+{
+  if (not file)
+  {
+    return;
+  }
+
+  swap();
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    wake.wait(lock, [this] { return pending == nullptr; });
+    stop = true;
+    wake.notify_all();
+  }
+
+  writer.join();
+
+  if (fclose(file) != 0 or failed)
+  {
+    Log::error("Error file writing: commit log");
+  }
+
+  file = nullptr;
+}
+
+CommitLogReader::~CommitLogReader()
+{
+  if (file)
+  {
+    fclose(file);
+  }
+}
+
+bool CommitLogReader::open(const char *path)
+{
+  file = fopen(path, "rb");
+
+  if (!file)
+  {
+    return false;
+  }
+
+  fill();
+
+  if (size < sizeof(MAGIC) or std::memcmp(buffer.get(), MAGIC, sizeof(MAGIC)) != 0)
+  {
+    return false;
+  }
+
+  pos = sizeof(MAGIC);
+  return true;
+}
+
+// Moves the unread bytes to the start of the buffer, then tops it up
+void CommitLogReader::fill()
+{
+  std::memmove(buffer.get(), buffer.get() + pos, size - pos);
+  size -= pos;
+  pos = 0;
+  size += fread(buffer.get() + size, 1, BUFFER_SIZE - size, file);
+}
+
+bool CommitLogReader::read(CommitRecord &record)
+{
+  if (size - pos < MAX_RECORD)
+  {
+    fill();
+  }
+
+  const uint8_t *p = buffer.get() + pos;
+  const uint8_t *end = buffer.get() + size;
+
+  if (p == end)
+  {
+    return false;
+  }
+
+  uint8_t flags = *p++;
+  record = CommitRecord{};
+
+  if (flags & TRAP)
+  {
+    record.trap = true;
+    p = get_varint(p, end, record.cause);
+    p = p ? get_varint(p, end, record.epc) : nullptr;
+
+    if (p and (flags & RD_WRITE))
+    {
+      if (p == end)
+      {
+        return false;
+      }
+
+      record.rd_write = true;
+      record.rd = *p++;
+      p = get_varint(p, end, record.rd_value);
+    }
+  }
+  else
+  {
+    record.pc = next_pc;
+
+    if (flags & PC_JUMP)
+    {
+      p = get_delta(p, end, record.pc, next_pc);
+    }
+
+    uint32_t index = table_index(record.pc);
+
+    if (p and (flags & INSTRUCTION))
+    {
+      if (end - p < 4)
+      {
+        return false;
+      }
+
+      std::memcpy(&record.instruction, p, 4);
+      p += 4;
+      table_pc[index] = record.pc;
+      table_instruction[index] = record.instruction;
+    }
+    else
+    {
+      record.instruction = table_instruction[index];
+    }
+
+    if (p and (flags & RD_WRITE))
+    {
+      if (p == end)
+      {
+        return false;
+      }
+
+      record.rd_write = true;
+      record.rd = *p++;
+      p = get_varint(p, end, record.rd_value);
+    }
+
+    if (p and (flags & (LOAD | STORE)))
+    {
+      record.load = flags & LOAD;
+      record.store = flags & STORE;
+      p = get_delta(p, end, record.address, prev_address);
+      prev_address = record.address;
+    }
+
+    if (p and (flags & STORE))
+    {
+      p = get_varint(p, end, record.store_value);
+    }
+
+    next_pc = record.pc + 4;
+  }
+
+  if (not p)
+  {
+    return false;
+  }
+
+  pos = p - buffer.get();
+  return true;
+}
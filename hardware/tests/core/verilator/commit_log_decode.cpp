@@ -0,0 +1,45 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+// Prints a binary commit log (--commit-log) in the text format of
+// spike --log-commits, e.g.
+//
+//   core   0: 3 0x00000104 (0x00812423) mem 0x00001ffc 0x00000000
+//   core   0: 3 0x00000108 (0x00000513) x10 0x00000000
+//
+// Usage: commit_log_decode <file>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "commit_log.h"
+
+int main(int argc, char *argv[])
+{
+  if (argc != 2)
+  {
+    fprintf(stderr, "Usage: %s <file>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  CommitLogReader reader;
+
+  if (not reader.open(argv[1]))
+  {
+    fprintf(stderr, "Not a commit log: %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  CommitRecord record;
+
+  while (reader.read(record))
+  {
+    printf("%s\n", commit_to_string(record).c_str());
+  }
+
+  return EXIT_SUCCESS;
+}
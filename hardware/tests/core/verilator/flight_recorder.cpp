@@ -0,0 +1,124 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "flight_recorder.h"
+
+#include <cstdlib>
+#include <sstream>
+
+#include <gtkwave/fstapi.h>
+
+#include "log.h"
+
+void FlightRecorder::add_signal(const char *scope, const char *name, uint32_t width,
+                                const void *value, size_t size)
+{
+  if (size > sizeof(uint32_t))
+  {
+    Log::error("Flight recorder: signal %s wider than 32 bits", name);
+    std::exit(EXIT_FAILURE);
+  }
+
+  signals.push_back({scope, name, width, value, size});
+}
+
+void FlightRecorder::start(size_t depth)
+{
+  this->depth = depth;
+  head = 0;
+  count = 0;
+  values.assign(depth * signals.size(), 0);
+  times.assign(depth, 0);
+}
+
+static std::vector<std::string> split_scope(const std::string &scope)
+{
+  std::vector<std::string> names;
+  std::stringstream ss(scope);
+  std::string name;
+
+  while (std::getline(ss, name, '.'))
+  {
+    names.push_back(name);
+  }
+
+  return names;
+}
+
+bool FlightRecorder::dump(const char *path) const
+{
+  void *fst = fstWriterCreate(path, 1);
+
+  if (!fst)
+  {
+    Log::error("Error file opening: %s", path);
+    return false;
+  }
+
+  fstWriterSetTimescaleFromString(fst, "1ns");
+
+  // Declare the signals, opening and closing scopes as the hierarchy changes
+  std::vector<fstHandle> handles;
+  std::vector<std::string> open_scopes;
+
+  for (const Signal &signal : signals)
+  {
+    std::vector<std::string> scopes = split_scope(signal.scope);
+    size_t common = 0;
+
+    while (common < open_scopes.size() && common < scopes.size() &&
+           open_scopes[common] == scopes[common])
+    {
+      common++;
+    }
+
+    for (size_t i = open_scopes.size(); i > common; i--)
+    {
+      fstWriterSetUpscope(fst);
+    }
+
+    for (size_t i = common; i < scopes.size(); i++)
+    {
+      fstWriterSetScope(fst, FST_ST_VCD_MODULE, scopes[i].c_str(), NULL);
+    }
+
+    open_scopes = scopes;
+    handles.push_back(fstWriterCreateVar(fst, FST_VT_VCD_WIRE, FST_VD_IMPLICIT, signal.width,
+                                         signal.name.c_str(), 0));
+  }
+
+  for (size_t i = open_scopes.size(); i > 0; i--)
+  {
+    fstWriterSetUpscope(fst);
+  }
+
+  // Emit the samples oldest first, only writing values that changed
+  size_t oldest = (head + depth - count) % depth;
+
+  for (size_t n = 0; n < count; n++)
+  {
+    size_t row = (oldest + n) % depth;
+    size_t prev = (row + depth - 1) % depth;
+
+    fstWriterEmitTimeChange(fst, times[row]);
+
+    for (size_t i = 0; i < signals.size(); i++)
+    {
+      uint32_t value = values[row * signals.size() + i];
+
+      if (n == 0 || value != values[prev * signals.size() + i])
+      {
+        fstWriterEmitValueChange32(fst, handles[i], signals[i].width, value);
+      }
+    }
+  }
+
+  fstWriterClose(fst);
+  Log::info("Flight recorder: %zu samples written to %s", count, path);
+
+  return true;
+}
@@ -0,0 +1,88 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Keeps the most recent samples of a set of signals in a bounded ring and
+// writes them as an FST file on request. Signals are registered by address and
+// read on every sample() call, so they must be public in the Verilated model.
+class FlightRecorder
+{
+  public:
+    // scope is a dot separated hierarchy, e.g. "unit_tests.rvsteel_core_instance"
+    template <typename T>
+    void add_signal(const char *scope, const char *name, uint32_t width, const T &value)
+    {
+      add_signal(scope, name, width, &value, sizeof(T));
+    }
+
+    // Allocates room for the given number of samples
+    void start(size_t depth);
+
+    bool enabled() const
+    {
+      return depth != 0;
+    }
+
+    void sample(uint64_t time)
+    {
+      uint32_t *row = &values[head * signals.size()];
+
+      for (size_t i = 0; i < signals.size(); i++)
+      {
+        row[i] = read(signals[i]);
+      }
+
+      times[head] = time;
+      head = (head + 1 == depth) ? 0 : head + 1;
+      count = (count < depth) ? count + 1 : depth;
+    }
+
+    // Writes the recorded samples, oldest first. Returns false on error.
+    bool dump(const char *path) const;
+
+  private:
+    struct Signal
+    {
+      std::string scope;
+      std::string name;
+      uint32_t width;
+      const void *value;
+      size_t size;
+    };
+
+    std::vector<Signal> signals;
+    std::vector<uint32_t> values;
+    std::vector<uint64_t> times;
+    size_t depth{0};
+    size_t head{0};
+    size_t count{0};
+
+    void add_signal(const char *scope, const char *name, uint32_t width, const void *value,
+                    size_t size);
+
+    static uint32_t read(const Signal &signal)
+    {
+      switch (signal.size)
+      {
+      case 1:
+        return *static_cast<const uint8_t *>(signal.value);
+      case 2:
+        return *static_cast<const uint16_t *>(signal.value);
+      default:
+        return *static_cast<const uint32_t *>(signal.value);
+      }
+    }
+};
+
+#endif // FLIGHT_RECORDER_H
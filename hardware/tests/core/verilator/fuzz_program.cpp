@@ -0,0 +1,404 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "fuzz_program.h"
+
+#include <algorithm>
+
+// Opcodes
+static constexpr uint32_t OPCODE_OP = 0x33;
+static constexpr uint32_t OPCODE_OP_IMM = 0x13;
+static constexpr uint32_t OPCODE_LOAD = 0x03;
+static constexpr uint32_t OPCODE_STORE = 0x23;
+static constexpr uint32_t OPCODE_BRANCH = 0x63;
+static constexpr uint32_t OPCODE_JAL = 0x6f;
+static constexpr uint32_t OPCODE_JALR = 0x67;
+static constexpr uint32_t OPCODE_LUI = 0x37;
+static constexpr uint32_t OPCODE_AUIPC = 0x17;
+static constexpr uint32_t OPCODE_MISC_MEM = 0x0f;
+static constexpr uint32_t OPCODE_SYSTEM = 0x73;
+
+static constexpr uint32_t ECALL = 0x00000073;
+static constexpr uint32_t EBREAK = 0x00100073;
+static constexpr uint32_t MRET = 0x30200073;
+static constexpr uint32_t WFI = 0x10500073;
+static constexpr uint32_t FENCE = 0x0ff0000f;
+
+static constexpr uint16_t MTVEC = 0x305;
+static constexpr uint16_t MEPC = 0x341;
+
+// The CSRs of rvsteel_core.v and a few it does not have
+static constexpr uint16_t CSRS[] = {
+    0xf11, 0xf12, 0xf13, 0xf14, 0xc00, 0xc01, 0xc02, 0xc80, 0xc81, 0xc82, 0x300, 0x310, 0x301,
+    0x304, 0x305, 0x340, 0x341, 0x342, 0x343, 0x344, 0xb00, 0xb02, 0xb80, 0xb82, 0x7c0};
+
+// Registers
+static constexpr uint32_t HANDLER_REG = 30;
+static constexpr uint32_t DATA_REG = 31;
+static constexpr uint32_t LAST_RANDOM_REG = 29;
+
+// The handler follows the jump to the start code
+static constexpr uint32_t HANDLER_ADDRESS = 0x4;
+
+// Items of the random sequence
+static constexpr uint32_t MIN_ITEMS = 64;
+static constexpr uint32_t MAX_ITEMS = 400;
+static constexpr uint32_t MAX_JUMP_ITEMS = 8;
+
+static uint32_t r_type(uint32_t funct7, uint32_t rs2, uint32_t rs1, uint32_t funct3, uint32_t rd,
+                       uint32_t opcode)
+{
+  return (funct7 << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) | (rd << 7) | opcode;
+}
+
+static uint32_t i_type(uint32_t imm, uint32_t rs1, uint32_t funct3, uint32_t rd, uint32_t opcode)
+{
+  return ((imm & 0xfff) << 20) | (rs1 << 15) | (funct3 << 12) | (rd << 7) | opcode;
+}
+
+static uint32_t s_type(uint32_t imm, uint32_t rs2, uint32_t rs1, uint32_t funct3)
+{
+  return (((imm >> 5) & 0x7f) << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) |
+         ((imm & 0x1f) << 7) | OPCODE_STORE;
+}
+
+static uint32_t b_type(uint32_t imm, uint32_t rs2, uint32_t rs1, uint32_t funct3)
+{
+  return (((imm >> 12) & 0x1) << 31) | (((imm >> 5) & 0x3f) << 25) | (rs2 << 20) | (rs1 << 15) |
+         (funct3 << 12) | (((imm >> 1) & 0xf) << 8) | (((imm >> 11) & 0x1) << 7) | OPCODE_BRANCH;
+}
+
+static uint32_t u_type(uint32_t imm, uint32_t rd, uint32_t opcode)
+{
+  return (imm & 0xfffff000) | (rd << 7) | opcode;
+}
+
+static uint32_t j_type(uint32_t imm, uint32_t rd)
+{
+  return (((imm >> 20) & 0x1) << 31) | (((imm >> 1) & 0x3ff) << 21) | (((imm >> 11) & 0x1) << 20) |
+         (imm & 0xff000) | (rd << 7) | OPCODE_JAL;
+}
+
+// lui and addi
+static void load_value(std::vector<uint32_t> &code, uint32_t rd, uint32_t value)
+{
+  code.push_back(u_type(value + 0x800, rd, OPCODE_LUI));
+  code.push_back(i_type(value, rd, 0, rd, OPCODE_OP_IMM));
+}
+
+uint32_t FuzzProgram::pick(uint32_t count)
+{
+  return random() % count;
+}
+
+bool FuzzProgram::chance(uint32_t percent)
+{
+  return pick(100) < percent;
+}
+
+// Edge values a quarter of the time
+uint32_t FuzzProgram::value()
+{
+  static constexpr uint32_t EDGES[] = {0, 1, 2, 0xffffffff, 0x80000000, 0x7fffffff, 0x7ff, 0x800};
+
+  if (chance(25))
+  {
+    return EDGES[pick(sizeof(EDGES) / sizeof(EDGES[0]))];
+  }
+
+  return (uint32_t)random();
+}
+
+uint32_t FuzzProgram::rd()
+{
+  return pick(LAST_RANDOM_REG + 1);
+}
+
+uint32_t FuzzProgram::rs()
+{
+  return pick(32);
+}
+
+FuzzProgram::Item FuzzProgram::alu_item()
+{
+  Item item;
+  uint32_t funct3 = pick(8);
+
+  switch (pick(4))
+  {
+  case 0:
+  {
+    // sub and sra
+    bool alternate = (funct3 == 0 or funct3 == 5) and chance(50);
+
+    item.code.push_back(r_type(alternate ? 0x20 : 0, rs(), rs(), funct3, rd(), OPCODE_OP));
+    break;
+  }
+
+  case 1:
+  {
+    uint32_t imm = value();
+
+    // slli, srli and srai take a shift amount
+    if (funct3 == 1 or funct3 == 5)
+    {
+      imm = (imm & 0x1f) | (funct3 == 5 and chance(50) ? 0x400 : 0);
+    }
+
+    item.code.push_back(i_type(imm, rs(), funct3, rd(), OPCODE_OP_IMM));
+    break;
+  }
+
+  case 2: item.code.push_back(u_type(value(), rd(), OPCODE_LUI)); break;
+  default: item.code.push_back(u_type(value(), rd(), OPCODE_AUIPC)); break;
+  }
+
+  return item;
+}
+
+// Loads and stores relative to DATA_START, aligned most of the time
+FuzzProgram::Item FuzzProgram::memory_item()
+{
+  static constexpr uint32_t LOADS[] = {0, 1, 2, 4, 5};
+
+  Item item;
+  bool store = chance(40);
+  uint32_t funct3 = store ? pick(3) : LOADS[pick(5)];
+  uint32_t size = 1 << (funct3 & 0x3);
+  uint32_t offset = pick(DATA_SIZE - 3);
+
+  if (chance(70))
+  {
+    offset &= ~(size - 1);
+  }
+
+  if (store)
+  {
+    item.code.push_back(s_type(offset, rs(), DATA_REG, funct3));
+  }
+  else
+  {
+    item.code.push_back(i_type(offset, DATA_REG, funct3, rd(), OPCODE_LOAD));
+  }
+
+  return item;
+}
+
+// Branches, jal and jalr to a later item. 2 bytes past it, the branch or jump
+// raises a misaligned fetch when taken.
+FuzzProgram::Item FuzzProgram::control_item()
+{
+  Item item;
+
+  item.target = 1 + pick(MAX_JUMP_ITEMS);
+  item.misalign = chance(10) ? 2 : 0;
+
+  switch (pick(3))
+  {
+  case 0:
+  {
+    static constexpr uint32_t FUNCT3[] = {0, 1, 4, 5, 6, 7};
+
+    item.code.push_back(b_type(0, rs(), rs(), FUNCT3[pick(6)]));
+    item.jump = 0;
+    break;
+  }
+
+  case 1:
+    item.code.push_back(j_type(0, rd()));
+    item.jump = 0;
+    break;
+
+  default:
+  {
+    uint32_t base = 1 + pick(LAST_RANDOM_REG);
+
+    // jalr clears bit 0 of the target
+    item.misalign |= pick(2);
+    item.code.push_back(u_type(0, base, OPCODE_AUIPC));
+    item.code.push_back(i_type(0, base, 0, rd(), OPCODE_JALR));
+    item.jump = 1;
+    item.jump_from = 0;
+    break;
+  }
+  }
+
+  return item;
+}
+
+// Accesses to the CSRs with the six instructions. mtvec is only read, the trap
+// handler needs it.
+FuzzProgram::Item FuzzProgram::csr_item()
+{
+  Item item;
+  uint32_t csr = CSRS[pick(sizeof(CSRS) / sizeof(CSRS[0]))];
+  uint32_t funct3 = (chance(50) ? 0 : 4) + 1 + pick(3);
+  uint32_t source = funct3 & 0x4 ? pick(32) : rs();
+
+  if (csr == MTVEC)
+  {
+    funct3 |= 0x2;
+    source = 0;
+  }
+
+  item.code.push_back(i_type(csr, source, funct3, rd(), OPCODE_SYSTEM));
+  return item;
+}
+
+// ecall, ebreak, fence, mret to the next item and instructions rvsteel_core.v
+// does not implement
+FuzzProgram::Item FuzzProgram::system_item()
+{
+  Item item;
+
+  switch (pick(6))
+  {
+  case 0: item.code.push_back(ECALL); break;
+  case 1: item.code.push_back(EBREAK); break;
+  case 2: item.code.push_back(FENCE); break;
+
+  case 3:
+    item.code.push_back(u_type(0, HANDLER_REG, OPCODE_AUIPC));
+    item.code.push_back(i_type(16, HANDLER_REG, 0, HANDLER_REG, OPCODE_OP_IMM));
+    item.code.push_back(i_type(MEPC, HANDLER_REG, 1, 0, OPCODE_SYSTEM));
+    item.code.push_back(MRET);
+    break;
+
+  case 4:
+  {
+    // Reserved funct3 of loads and stores, mul, a bad shift and a custom opcode
+    static constexpr uint32_t LOAD_FUNCT3[] = {3, 6, 7};
+
+    switch (pick(5))
+    {
+    case 0:
+      item.code.push_back(i_type(pick(DATA_SIZE), DATA_REG, LOAD_FUNCT3[pick(3)], rd(),
+                                 OPCODE_LOAD));
+      break;
+
+    case 1: item.code.push_back(s_type(pick(DATA_SIZE), rs(), DATA_REG, 3 + pick(5))); break;
+    case 2: item.code.push_back(r_type(1, rs(), rs(), pick(8), rd(), OPCODE_OP)); break;
+    case 3: item.code.push_back(i_type(0x200 | pick(32), rs(), 1, rd(), OPCODE_OP_IMM)); break;
+    default: item.code.push_back(((uint32_t)random() & ~0x7fu) | 0x0b); break;
+    }
+
+    break;
+  }
+
+  default:
+  {
+    static constexpr uint32_t WORDS[] = {0x00000000, 0xffffffff, WFI};
+
+    item.code.push_back(WORDS[pick(3)]);
+    break;
+  }
+  }
+
+  return item;
+}
+
+void FuzzProgram::generate(uint64_t seed)
+{
+  random.seed(seed);
+  words.clear();
+
+  // Start code: mtvec, DATA_START and random registers
+  std::vector<uint32_t> start;
+
+  start.push_back(i_type(HANDLER_ADDRESS, 0, 0, HANDLER_REG, OPCODE_OP_IMM));
+  start.push_back(i_type(MTVEC, HANDLER_REG, 1, 0, OPCODE_SYSTEM));
+  load_value(start, DATA_REG, DATA_START);
+
+  for (uint32_t reg = 1; reg <= LAST_RANDOM_REG; reg++)
+  {
+    load_value(start, reg, value());
+  }
+
+  // Jump over the handler, which returns past the instruction that trapped
+  words.push_back(j_type(HANDLER_ADDRESS + 16, 0));
+  words.push_back(i_type(MEPC, 0, 2, HANDLER_REG, OPCODE_SYSTEM));
+  words.push_back(i_type(4, HANDLER_REG, 0, HANDLER_REG, OPCODE_OP_IMM));
+  words.push_back(i_type(MEPC, HANDLER_REG, 1, 0, OPCODE_SYSTEM));
+  words.push_back(MRET);
+  words.insert(words.end(), start.begin(), start.end());
+
+  // The random sequence, then the end as its last item
+  std::vector<Item> items(MIN_ITEMS + pick(MAX_ITEMS - MIN_ITEMS + 1));
+
+  for (Item &item : items)
+  {
+    uint32_t kind = pick(100);
+
+    if (kind < 40)
+    {
+      item = alu_item();
+    }
+    else if (kind < 65)
+    {
+      item = memory_item();
+    }
+    else if (kind < 80)
+    {
+      item = control_item();
+    }
+    else if (kind < 92)
+    {
+      item = csr_item();
+    }
+    else
+    {
+      item = system_item();
+    }
+  }
+
+  Item end;
+
+  load_value(end.code, HANDLER_REG, TOHOST);
+  end.code.push_back(i_type(1, 0, 0, LAST_RANDOM_REG, OPCODE_OP_IMM));
+  end.code.push_back(s_type(0, LAST_RANDOM_REG, HANDLER_REG, 2));
+  end.code.push_back(j_type(0, 0));
+  items.push_back(end);
+
+  // Item addresses, then the offsets of the branches and jumps
+  std::vector<uint32_t> address(items.size());
+  uint32_t next = words.size() * 4;
+
+  for (size_t i = 0; i < items.size(); i++)
+  {
+    address[i] = next;
+    next += items[i].code.size() * 4;
+  }
+
+  for (size_t i = 0; i < items.size(); i++)
+  {
+    Item &item = items[i];
+
+    if (item.jump >= 0)
+    {
+      size_t target = std::min(i + item.target, items.size() - 1);
+      uint32_t offset = address[target] + item.misalign - (address[i] + 4 * item.jump_from);
+      uint32_t &code = item.code[item.jump];
+
+      switch (code & 0x7f)
+      {
+      case OPCODE_BRANCH: code |= b_type(offset, 0, 0, 0); break;
+      case OPCODE_JAL: code |= j_type(offset, 0); break;
+      default: code |= i_type(offset, 0, 0, 0, 0); break;
+      }
+    }
+
+    words.insert(words.end(), item.code.begin(), item.code.end());
+  }
+
+  // The data area, after the code
+  words.resize(DATA_START / 4);
+
+  for (uint32_t i = 0; i < DATA_SIZE / 4; i++)
+  {
+    words.push_back(value());
+  }
+}
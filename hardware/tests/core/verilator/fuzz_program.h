@@ -0,0 +1,69 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef FUZZ_PROGRAM_H
+#define FUZZ_PROGRAM_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Constrained-random RV32I/Zicsr program for --fuzz. The code sets every
+// register to a random value and runs a random sequence of ALU operations,
+// loads and stores to a data area, misaligned ones included, forward branches
+// and jumps, CSR accesses, ecall, ebreak, mret and illegal instructions. The
+// trap handler at mtvec returns to the instruction after the one that trapped.
+// The program ends writing 1 to TOHOST.
+//
+// Branches and jumps only go forward to the start of a later item of the
+// sequence, or 2 bytes past it to raise a misaligned fetch, so every program
+// ends. x30 belongs to the trap handler and x31 holds DATA_START.
+class FuzzProgram
+{
+  public:
+    static constexpr uint32_t TOHOST = 0x00003ffc;
+    static constexpr uint32_t DATA_START = 0x00004000;
+    static constexpr uint32_t DATA_SIZE = 0x800;
+
+    // The same seed gives the same program
+    void generate(uint64_t seed);
+
+    // From address 0 to the end of the data area
+    const std::vector<uint32_t> &image() const
+    {
+      return words;
+    }
+
+  private:
+    // Some instructions of the sequence, with a branch or jump to a later item
+    // patched in once the addresses are known
+    struct Item
+    {
+      std::vector<uint32_t> code;
+      int jump{-1};           // Index in code of the branch or jump
+      uint32_t jump_from{0};  // Index in code the offset is taken from
+      uint32_t target{0};     // Items ahead
+      uint32_t misalign{0};   // Added to the target address
+    };
+
+    std::mt19937_64 random;
+    std::vector<uint32_t> words;
+
+    uint32_t pick(uint32_t count);
+    bool chance(uint32_t percent);
+    uint32_t value();
+    uint32_t rd();
+    uint32_t rs();
+
+    Item alu_item();
+    Item memory_item();
+    Item control_item();
+    Item csr_item();
+    Item system_item();
+};
+
+#endif // FUZZ_PROGRAM_H
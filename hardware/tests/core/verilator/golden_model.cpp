@@ -0,0 +1,632 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "golden_model.h"
+
+// Opcodes
+static constexpr uint32_t OPCODE_OP = 0x33;
+static constexpr uint32_t OPCODE_OP_IMM = 0x13;
+static constexpr uint32_t OPCODE_LOAD = 0x03;
+static constexpr uint32_t OPCODE_STORE = 0x23;
+static constexpr uint32_t OPCODE_BRANCH = 0x63;
+static constexpr uint32_t OPCODE_JAL = 0x6f;
+static constexpr uint32_t OPCODE_JALR = 0x67;
+static constexpr uint32_t OPCODE_LUI = 0x37;
+static constexpr uint32_t OPCODE_AUIPC = 0x17;
+static constexpr uint32_t OPCODE_MISC_MEM = 0x0f;
+static constexpr uint32_t OPCODE_SYSTEM = 0x73;
+
+static constexpr uint32_t ECALL = 0x00000073;
+static constexpr uint32_t EBREAK = 0x00100073;
+static constexpr uint32_t MRET = 0x30200073;
+static constexpr uint32_t NOP = 0x00000013; // addi x0, x0, 0
+
+// Exception codes, in the order rvsteel_core.v gives them priority
+static constexpr int CAUSE_ILLEGAL_INSTRUCTION = 2;
+static constexpr int CAUSE_MISALIGNED_FETCH = 0;
+static constexpr int CAUSE_ECALL = 11;
+static constexpr int CAUSE_BREAKPOINT = 3;
+static constexpr int CAUSE_MISALIGNED_STORE = 6;
+static constexpr int CAUSE_MISALIGNED_LOAD = 4;
+
+static constexpr uint32_t CAUSE_INTERRUPT = 0x80000000;
+
+// CSR addresses of rvsteel_core.v
+static constexpr uint16_t MARCHID = 0xf12;
+static constexpr uint16_t MIMPID = 0xf13;
+static constexpr uint16_t CYCLE = 0xc00;
+static constexpr uint16_t TIME = 0xc01;
+static constexpr uint16_t INSTRET = 0xc02;
+static constexpr uint16_t CYCLEH = 0xc80;
+static constexpr uint16_t TIMEH = 0xc81;
+static constexpr uint16_t INSTRETH = 0xc82;
+static constexpr uint16_t MSTATUS = 0x300;
+static constexpr uint16_t MSTATUSH = 0x310;
+static constexpr uint16_t MISA = 0x301;
+static constexpr uint16_t MIE = 0x304;
+static constexpr uint16_t MTVEC = 0x305;
+static constexpr uint16_t MSCRATCH = 0x340;
+static constexpr uint16_t MEPC = 0x341;
+static constexpr uint16_t MCAUSE = 0x342;
+static constexpr uint16_t MTVAL = 0x343;
+static constexpr uint16_t MIP = 0x344;
+static constexpr uint16_t MCYCLE = 0xb00;
+static constexpr uint16_t MINSTRET = 0xb02;
+static constexpr uint16_t MCYCLEH = 0xb80;
+static constexpr uint16_t MINSTRETH = 0xb82;
+
+// Writable bits of mie: the fast, external, timer and software interrupts
+static constexpr uint32_t MIE_MASK = 0xffff0888;
+
+static uint32_t immediate_i(uint32_t instruction)
+{
+  return (int32_t)instruction >> 20;
+}
+
+static uint32_t immediate_s(uint32_t instruction)
+{
+  return ((int32_t)(instruction & 0xfe000000) >> 20) | ((instruction >> 7) & 0x1f);
+}
+
+static uint32_t immediate_b(uint32_t instruction)
+{
+  return ((int32_t)(instruction & 0x80000000) >> 19) | ((instruction & 0x80) << 4) |
+         ((instruction >> 20) & 0x7e0) | ((instruction >> 7) & 0x1e);
+}
+
+static uint32_t immediate_j(uint32_t instruction)
+{
+  return ((int32_t)(instruction & 0x80000000) >> 11) | (instruction & 0xff000) |
+         ((instruction >> 9) & 0x800) | ((instruction >> 20) & 0x7fe);
+}
+
+// The ALU of rvsteel_core.v. It also gives the register that an illegal OP or
+// OP-IMM instruction writes, e.g. a mul is an add.
+static uint32_t alu(uint32_t funct3, bool alternate, uint32_t a, uint32_t b)
+{
+  switch (funct3)
+  {
+  case 0: return alternate ? a - b : a + b;
+  case 1: return a << (b & 0x1f);
+  case 2: return (int32_t)a < (int32_t)b;
+  case 3: return a < b;
+  case 4: return a ^ b;
+  case 5: return alternate ? (uint32_t)((int32_t)a >> (b & 0x1f)) : a >> (b & 0x1f);
+  case 6: return a | b;
+  default: return a & b;
+  }
+}
+
+static bool branch_taken(uint32_t funct3, uint32_t a, uint32_t b)
+{
+  switch (funct3)
+  {
+  case 0: return a == b;
+  case 1: return a != b;
+  case 4: return (int32_t)a < (int32_t)b;
+  case 5: return (int32_t)a >= (int32_t)b;
+  case 6: return a < b;
+  case 7: return a >= b;
+  default: return false;
+  }
+}
+
+void GoldenModel::start(uint32_t boot_address, const uint32_t *ram, uint32_t words)
+{
+  *this = GoldenModel();
+  pc = boot_address;
+  this->ram.assign(ram, ram + words);
+}
+
+void GoldenModel::host_call(uint32_t a0, const uint32_t *ram, uint32_t address, uint32_t size)
+{
+  x[10] = a0;
+  host_nop = true;
+
+  for (uint32_t word = address / 4; size and word <= (address + size - 1) / 4; word++)
+  {
+    if (word < this->ram.size())
+    {
+      this->ram[word] = ram[word];
+    }
+  }
+}
+
+uint32_t GoldenModel::csr_read(uint16_t address, bool &from_rtl) const
+{
+  from_rtl = false;
+
+  switch (address)
+  {
+  case MARCHID: return 0x00000018;
+  case MIMPID: return 0x00000006;
+  case MSTATUS: return 0x00001800 | (mstatus_mpie << 7) | (mstatus_mie << 3);
+  case MSTATUSH: return 0;
+  case MISA: return 0x40000100;
+  case MIE: return mie;
+  case MTVEC: return mtvec;
+  case MSCRATCH: return mscratch;
+  case MEPC: return mepc;
+  case MCAUSE: return mcause;
+  case MTVAL: return mtval;
+
+  // Follow the interrupt inputs, the clock and the cycles the RTL spends
+  case MIP:
+  case CYCLE:
+  case CYCLEH:
+  case TIME:
+  case TIMEH:
+  case INSTRET:
+  case INSTRETH:
+  case MCYCLE:
+  case MCYCLEH:
+  case MINSTRET:
+  case MINSTRETH:
+    from_rtl = true;
+    return 0;
+
+  default: return 0;
+  }
+}
+
+// The counters are left to the RTL, the other CSRs are read-only
+void GoldenModel::csr_write(uint16_t address, uint32_t value)
+{
+  switch (address)
+  {
+  case MSTATUS:
+    mstatus_mie = (value >> 3) & 1;
+    mstatus_mpie = (value >> 7) & 1;
+    break;
+
+  case MIE: mie = value & MIE_MASK; break;
+  case MTVEC: mtvec = value & ~2u; break;
+  case MSCRATCH: mscratch = value; break;
+  case MEPC: mepc = value & ~3u; break;
+  case MCAUSE: mcause = value; break;
+  case MTVAL: mtval = value; break;
+  default: break;
+  }
+}
+
+void GoldenModel::execute_csr(uint32_t instruction, Step &step) const
+{
+  uint32_t funct3 = (instruction >> 12) & 0x7;
+  uint32_t rs1 = (instruction >> 15) & 0x1f;
+  uint16_t address = instruction >> 20;
+
+  // csrrwi, csrrsi and csrrci take rs1 as an immediate
+  uint32_t mask = funct3 & 0x4 ? rs1 : x[rs1];
+  uint32_t value = csr_read(address, step.rd_from_rtl);
+
+  step.csr_write = true;
+  step.csr_address = address;
+
+  switch (funct3 & 0x3)
+  {
+  case 1: step.csr_value = mask; break;
+  case 2: step.csr_value = value | mask; break;
+  default: step.csr_value = value & ~mask; break;
+  }
+
+  step.record.rd_value = value;
+}
+
+// Decodes and executes the instruction at pc without changing the state. The
+// trap causes and the registers written by trapping instructions follow
+// rvsteel_core.v.
+GoldenModel::Step GoldenModel::execute(uint32_t instruction) const
+{
+  Step step;
+  CommitRecord &record = step.record;
+
+  uint32_t opcode = instruction & 0x7f;
+  uint32_t rd = (instruction >> 7) & 0x1f;
+  uint32_t funct3 = (instruction >> 12) & 0x7;
+  uint32_t funct7 = instruction >> 25;
+  uint32_t rs1 = x[(instruction >> 15) & 0x1f];
+  uint32_t rs2 = x[(instruction >> 20) & 0x1f];
+
+  record.pc = pc;
+  record.instruction = instruction;
+  step.next_pc = pc + 4;
+
+  bool illegal = false;
+  bool writes_rd = false;
+  bool jump = false;
+  bool load = false;
+  bool store = false;
+  bool misaligned = false;
+  uint32_t target = 0; // target_address_adder
+
+  switch (opcode)
+  {
+  case OPCODE_LUI:
+    writes_rd = true;
+    record.rd_value = instruction & 0xfffff000;
+    break;
+
+  case OPCODE_AUIPC:
+    writes_rd = true;
+    record.rd_value = pc + (instruction & 0xfffff000);
+    break;
+
+  case OPCODE_JAL:
+    writes_rd = true;
+    record.rd_value = pc + 4;
+    target = pc + immediate_j(instruction);
+    jump = true;
+    break;
+
+  case OPCODE_JALR:
+    // Writes rd even when illegal
+    writes_rd = true;
+    record.rd_value = pc + 4;
+    target = rs1 + immediate_i(instruction);
+    illegal = funct3 != 0;
+    jump = not illegal;
+    break;
+
+  case OPCODE_BRANCH:
+    target = pc + immediate_b(instruction);
+    illegal = funct3 == 2 or funct3 == 3;
+    jump = branch_taken(funct3, rs1, rs2);
+    break;
+
+  case OPCODE_LOAD:
+    target = rs1 + immediate_i(instruction);
+    illegal = funct3 == 3 or funct3 == 6 or funct3 == 7;
+
+    // An illegal load writes the word on the bus, which is the instruction
+    writes_rd = true;
+    record.rd_value = instruction;
+    load = not illegal;
+    break;
+
+  case OPCODE_STORE:
+    target = rs1 + immediate_s(instruction);
+    illegal = funct3 > 2;
+    store = not illegal;
+    break;
+
+  case OPCODE_OP:
+  case OPCODE_OP_IMM:
+  {
+    bool op = opcode == OPCODE_OP;
+    bool shift = funct3 == 1 or funct3 == 5;
+    bool alternate = (funct7 & 0x20) and (op or shift);
+
+    if (op)
+    {
+      illegal = funct7 != 0 and not(funct7 == 0x20 and (funct3 == 0 or funct3 == 5));
+    }
+    else if (shift)
+    {
+      illegal = funct7 != 0 and not(funct7 == 0x20 and funct3 == 5);
+    }
+
+    // Illegal ones write the ALU result as well
+    writes_rd = true;
+    record.rd_value = alu(funct3, alternate, rs1, op ? rs2 : immediate_i(instruction));
+    break;
+  }
+
+  case OPCODE_MISC_MEM:
+    break;
+
+  case OPCODE_SYSTEM:
+    if (funct3 != 0 and funct3 != 4)
+    {
+      writes_rd = true;
+      execute_csr(instruction, step);
+    }
+    else if (instruction == MRET)
+    {
+      step.mret = true;
+      step.next_pc = mepc;
+    }
+    else
+    {
+      illegal = instruction != ECALL and instruction != EBREAK;
+    }
+    break;
+
+  default:
+    illegal = true;
+    break;
+  }
+
+  if (load or store)
+  {
+    uint32_t size = funct3 & 0x3;
+    misaligned = (size == 2 and (target & 0x3)) or (size == 1 and (target & 0x1));
+  }
+
+  // The branch target drops bit 0, a target that is not word aligned traps
+  if (jump)
+  {
+    step.next_pc = target & ~1u;
+  }
+
+  if (illegal)
+  {
+    step.exception = CAUSE_ILLEGAL_INSTRUCTION;
+  }
+  else if (jump and (step.next_pc & 0x2))
+  {
+    step.exception = CAUSE_MISALIGNED_FETCH;
+    step.tval = target;
+  }
+  else if (instruction == ECALL)
+  {
+    step.exception = CAUSE_ECALL;
+  }
+  else if (instruction == EBREAK)
+  {
+    step.exception = CAUSE_BREAKPOINT;
+    step.tval = pc;
+  }
+  else if (store and misaligned)
+  {
+    step.exception = CAUSE_MISALIGNED_STORE;
+    step.tval = target;
+  }
+  else if (load and misaligned)
+  {
+    step.exception = CAUSE_MISALIGNED_LOAD;
+    step.tval = target;
+  }
+
+  // A load writes rd when it commits, which a trap prevents
+  if (step.exception >= 0)
+  {
+    uint32_t rd_value = record.rd_value;
+
+    record = CommitRecord{};
+    record.trap = true;
+    record.cause = step.exception;
+    record.epc = pc;
+    record.rd_value = rd_value;
+    writes_rd = writes_rd and not load;
+  }
+  else if (load)
+  {
+    record.load = true;
+    record.address = target;
+
+    if (in_ram(target))
+    {
+      uint32_t word = ram[target / 4];
+
+      switch (funct3)
+      {
+      case 0: record.rd_value = (int8_t)(word >> 8 * (target & 0x3)); break;
+      case 1: record.rd_value = (int16_t)(word >> 8 * (target & 0x2)); break;
+      case 4: record.rd_value = (uint8_t)(word >> 8 * (target & 0x3)); break;
+      case 5: record.rd_value = (uint16_t)(word >> 8 * (target & 0x2)); break;
+      default: record.rd_value = word; break;
+      }
+    }
+    else
+    {
+      step.rd_from_rtl = true;
+    }
+  }
+  else if (store)
+  {
+    uint32_t size = 1 << (funct3 & 0x3);
+
+    record.store = true;
+    record.address = target;
+    record.store_value = size == 4 ? rs2 : rs2 & ((1u << (8 * size)) - 1);
+  }
+
+  // x0 is not written
+  if (writes_rd and rd)
+  {
+    record.rd_write = true;
+    record.rd = rd;
+  }
+  else
+  {
+    record.rd_value = 0;
+    step.rd_from_rtl = false;
+  }
+
+  return step;
+}
+
+// Byte lanes of a store into the RAM
+void GoldenModel::store(uint32_t address, uint32_t value, uint32_t size)
+{
+  uint32_t shift = 8 * (address & 0x3);
+  uint32_t mask = size == 4 ? UINT32_MAX : ((1u << (8 * size)) - 1) << shift;
+  uint32_t &word = ram[address / 4];
+
+  word = (word & ~mask) | ((value << shift) & mask);
+}
+
+void GoldenModel::write_rd(const CommitRecord &record)
+{
+  if (record.rd_write)
+  {
+    x[record.rd] = record.rd_value;
+  }
+}
+
+void GoldenModel::take_trap(uint32_t cause, uint32_t tval)
+{
+  mepc = pc;
+  mcause = cause;
+  mtval = tval;
+  mstatus_mpie = mstatus_mie;
+  mstatus_mie = false;
+
+  // Vectored mode for interrupts
+  uint32_t base = mtvec & ~3u;
+  bool vectored = (mtvec & 0x3) == 1 and (cause & CAUSE_INTERRUPT);
+
+  pc = vectored ? base + 4 * (cause & 0x1f) : base;
+}
+
+bool GoldenModel::fail(const char *what, const CommitRecord &rtl, const CommitRecord *expected)
+{
+  message = std::string(what) + " at record " + std::to_string(checked);
+  message += "\n  rtl:   " + commit_to_string(rtl);
+
+  if (expected)
+  {
+    message += "\n  model: " + commit_to_string(*expected);
+  }
+
+  return false;
+}
+
+bool GoldenModel::compare(const CommitRecord &rtl, const CommitRecord &expected)
+{
+  if (rtl.trap != expected.trap)
+  {
+    return fail(rtl.trap ? "Unexpected trap" : "Missing trap", rtl, &expected);
+  }
+
+  if (rtl.trap and (rtl.cause != expected.cause or rtl.epc != expected.epc))
+  {
+    return fail("Trap differs", rtl, &expected);
+  }
+
+  if (not rtl.trap and (rtl.pc != expected.pc or rtl.instruction != expected.instruction))
+  {
+    return fail("Instruction differs", rtl, &expected);
+  }
+
+  if (rtl.rd_write != expected.rd_write or
+      (rtl.rd_write and (rtl.rd != expected.rd or rtl.rd_value != expected.rd_value)))
+  {
+    return fail("Register write differs", rtl, &expected);
+  }
+
+  if (rtl.load != expected.load or rtl.store != expected.store or
+      rtl.address != expected.address or rtl.store_value != expected.store_value)
+  {
+    return fail("Memory access differs", rtl, &expected);
+  }
+
+  return true;
+}
+
+// The core takes an interrupt in place of the instruction at pc, which it
+// fetches again after mret. That instruction still writes its register and
+// CSR, but not the memory, mepc or mtval, and a load only writes its register
+// when the interrupt comes in its commit cycle.
+bool GoldenModel::check_interrupt(const CommitRecord &rtl)
+{
+  uint32_t code = rtl.cause & 0x1f;
+
+  CommitRecord expected;
+  expected.trap = true;
+  expected.cause = rtl.cause;
+  expected.epc = pc;
+
+  if (not mstatus_mie or not((mie >> code) & 1))
+  {
+    return fail("Interrupt taken while disabled", rtl, &expected);
+  }
+
+  Step step = execute(in_ram(pc) ? ram[pc / 4] : 0);
+
+  // Exceptions come first
+  if (step.exception >= 0)
+  {
+    return compare(rtl, step.record);
+  }
+
+  expected.rd = step.record.rd;
+  expected.rd_value = step.record.rd_value;
+
+  if (step.record.load)
+  {
+    expected.rd_write = step.record.rd_write and rtl.rd_write;
+    expected.rd_value = rtl.rd_value;
+  }
+  else
+  {
+    expected.rd_write = step.record.rd_write;
+  }
+
+  if (step.rd_from_rtl)
+  {
+    expected.rd_value = rtl.rd_value;
+  }
+
+  if (not compare(rtl, expected))
+  {
+    return false;
+  }
+
+  write_rd(expected);
+
+  if (step.csr_write and step.csr_address != MEPC and step.csr_address != MTVAL)
+  {
+    csr_write(step.csr_address, step.csr_value);
+  }
+
+  take_trap(rtl.cause, 0);
+  return true;
+}
+
+bool GoldenModel::check(const CommitRecord &rtl)
+{
+  checked++;
+
+  if (rtl.trap and (rtl.cause & CAUSE_INTERRUPT))
+  {
+    return check_interrupt(rtl);
+  }
+
+  // Code outside the RAM is taken as the RTL fetched it
+  Step step = execute(host_nop ? NOP : in_ram(pc) ? ram[pc / 4] : rtl.instruction);
+  host_nop = false;
+
+  if (step.rd_from_rtl)
+  {
+    step.record.rd_value = rtl.rd_value;
+  }
+
+  if (not compare(rtl, step.record))
+  {
+    return false;
+  }
+
+  write_rd(step.record);
+
+  if (step.exception >= 0)
+  {
+    take_trap(step.exception, step.tval);
+    return true;
+  }
+
+  if (step.csr_write)
+  {
+    csr_write(step.csr_address, step.csr_value);
+  }
+
+  // Stores past the RAM go to devices
+  if (step.record.store and in_ram(step.record.address))
+  {
+    store(step.record.address, step.record.store_value,
+          1 << ((step.record.instruction >> 12) & 0x3));
+  }
+
+  if (step.mret)
+  {
+    mstatus_mie = mstatus_mpie;
+    mstatus_mpie = true;
+  }
+
+  pc = step.next_pc;
+  return true;
+}
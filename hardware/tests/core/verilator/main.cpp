@@ -1,231 +1,1173 @@
-// ----------------------------------------------------------------------------
-// Copyright (c) 2020-2024 RISC-V Steel contributors
-//
-// This work is licensed under the MIT License, see LICENSE file for details.
-// SPDX-License-Identifier: MIT
-// ----------------------------------------------------------------------------
-
-#include <stdlib.h>
-
-#include <iostream>
-#include <fstream>
-#include <signal.h>
-#include <string.h>
-
-#include <verilated_fst_c.h>
-
-#include "Vunit_tests.h"
-#include "Vunit_tests___024root.h"
-#include "argparse.h"
-#include "log.h"
-#include "ram_init.h"
-
-using Dut = Vunit_tests;
-using Trace = VerilatedFstC;
-
-vluint64_t trace_time = 0;
-vluint64_t clk_cur_cycles = 0;
-vluint64_t clk_half_cycles = 2;
-Dut *dut = new Dut;
-Trace *trace = new Trace;
-Args args;
-
-static void open_trace(const char *out_wave_path)
-{
-  Verilated::traceEverOn(true);
-  dut->trace(trace, 99);
-  trace->set_time_resolution("1ns");
-  trace->set_time_unit("1ns");
-  trace->open(out_wave_path);
-}
-
-static void close_trace()
-{
-  if (trace->isOpen())
-  {
-    trace->dump(trace_time);
-    trace->close();
-  }
-}
-
-static void clk()
-{
-  static vluint64_t interval = 0;
-
-  if (trace_time >= interval)
-  {
-    dut->clock ^= 1;
-    interval = trace_time + clk_half_cycles;
-    clk_cur_cycles += dut->clock & 0x1;
-  }
-}
-
-static void eval(vluint64_t cycles_cnt = 1)
-{
-  while (cycles_cnt--)
-  {
-    clk();
-    dut->eval();
-    trace->dump(trace_time++);
-  }
-}
-
-static void reset_dut()
-{
-  dut->reset = 1;
-  eval(100);
-  dut->reset = 0;
-  dut->halt = 0;
-}
-
-void exit_app(int sig)
-{
-  (void)sig;
-  close_trace();
-  Log::info("Exit.");
-  std::exit(EXIT_SUCCESS);
-}
-
-static void ram_init(const char *path, RamInitVariants variants)
-{
-  if (not path)
-  {
-    return;
-  }
-
-  uint32_t ram_size = dut->rootp->unit_tests__DOT__MEMORY_SIZE;
-
-  switch (variants)
-  {
-    case RamInitVariants::H32:
-        ram_init_h32(args.ram_init_path, ram_size/4, [](uint32_t i, uint32_t v) {
-        dut->rootp->unit_tests__DOT__rvsteel_ram_instance__DOT__ram[i] = v;
-      });
-      break;
-
-    case RamInitVariants::BIN:
-        ram_init_bin(args.ram_init_path, ram_size/4, [](uint32_t i, uint32_t v) {
-        dut->rootp->unit_tests__DOT__rvsteel_ram_instance__DOT__ram[i] = v;
-      });
-      break;
-  }
-}
-
-static void ram_dump_h32(const char *path, uint32_t offset, uint32_t size)
-{
-  std::ofstream file;
-  file.open(path, std::ios::out | std::ios::trunc);
-
-  if (!file.is_open())
-  {
-    Log::error("Error file opening: %s", path);
-    std::exit(EXIT_FAILURE);
-  }
-
-  char buff[32];
-
-  // In words
-  offset /= 4;
-  size /= 4;
-
-  for (int i = 0; i < size; i++)
-  {
-    uint32_t data = dut->rootp->unit_tests__DOT__rvsteel_ram_instance__DOT__ram[offset + i];
-    snprintf(buff, sizeof(buff), "%08" PRIx32, (const uint32_t)data);
-    file << buff << '\n';
-  }
-
-  Log::info("Ok dump ram h32");
-  file.close();
-}
-
-static bool is_finished(uint32_t addr)
-{
-  // After each clock cycle it tests whether the test program finished its execution
-  // This event is signaled by writing 1 to the address 0x00001000
-  return (dut->rootp->unit_tests__DOT__rw_address == addr) &&
-         dut->rootp->unit_tests__DOT__write_request &&
-         dut->rootp->unit_tests__DOT__write_data == 0x00000001;
-}
-
-static bool is_host_out(uint32_t addr)
-{
-  static bool is_pos_edg = false;
-
-  bool is_write = (addr != 0x0) &&
-                  (not is_pos_edg and dut->rootp->unit_tests__DOT__write_request) &&
-                  (dut->rootp->unit_tests__DOT__rw_address == addr) &&
-                  dut->rootp->unit_tests__DOT__write_request &&
-                  dut->rootp->unit_tests__DOT__write_data;
-
-  is_pos_edg = dut->rootp->unit_tests__DOT__write_request;
-
-  return is_write;
-}
-
-static uint32_t get_signature(uint32_t addr)
-{
-  return dut->rootp->unit_tests__DOT__rvsteel_ram_instance__DOT__ram[addr];
-}
-
-int main(int argc, char *argv[])
-{
-  signal(SIGINT, exit_app);
-  signal(SIGKILL, exit_app);
-
-  // Default log level
-  Log::set_level(Log::DEBUG);
-  args = parser(argc, argv);
-
-  if (args.out_wave_path)
-  {
-    open_trace(args.out_wave_path);
-  }
-
-  reset_dut();
-
-  ram_init(args.ram_init_path, args.ram_init_variants);
-
-  while (true)
-  {
-    eval();
-
-    // --cycles
-    if (args.max_cycles)
-    {
-      if (clk_cur_cycles >= args.max_cycles)
-      {
-        Log::info("Exit: end cycles");
-        close_trace();
-        std::exit(EXIT_SUCCESS);
-      }
-    }
-
-    // --wr-addr
-    if (is_finished(args.wr_addr))
-    {
-      Log::info("Exit: wr-addr");
-
-      // The beginning and end of signature are stored at
-      uint32_t start_addr = get_signature(2047);
-      uint32_t stop_addr = get_signature(2046);
-      uint32_t size = stop_addr - start_addr;
-
-      Log::info("Signature size: %u", size);
-
-      if (args.ram_dump_h32 and (size >= 4))
-      {
-        ram_dump_h32(args.ram_dump_h32, start_addr, size);
-      }
-
-      close_trace();
-      std::exit(EXIT_SUCCESS);
-    }
-
-    // --host-out
-    if (is_host_out(args.host_out))
-    {
-      Log::host_out((char)dut->rootp->unit_tests__DOT__write_data);
-    }
-  }
-}
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <iostream>
+#include <fstream>
+#include <signal.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <verilated_fst_c.h>
+
+#include "Vunit_tests.h"
+#include "Vunit_tests___024root.h"
+#include "argparse.h"
+#include "batch.h"
+#include "commit_log.h"
+#include "cpi_stack.h"
+#include "flight_recorder.h"
+#include "fuzz_program.h"
+#include "golden_model.h"
+#include "log.h"
+#include "monitor.h"
+#include "ram_init.h"
+#include "run_stats.h"
+#include "semihosting.h"
+#include "signature.h"
+#include "sparse_ram.h"
+
+using Dut = Vunit_tests;
+using Trace = VerilatedFstC;
+
+vluint64_t trace_time = 0;
+vluint64_t clk_cur_cycles = 0;
+vluint64_t clk_half_cycles = 2;
+std::chrono::steady_clock::time_point run_start;
+// Before the model is constructed, for the startup time of --stats
+std::chrono::steady_clock::time_point process_start = std::chrono::steady_clock::now();
+Dut *dut = new Dut;
+Trace *trace = new Trace;
+FlightRecorder recorder;
+ElfSymbols elf_symbols;
+CpiStack cpi_stack;
+CommitLog commit_log;
+GoldenModel golden_model;
+Semihosting semihosting;
+RunStats run_stats;
+Args args;
+
+// Values of current_state in rvsteel_core.v
+static constexpr uint8_t CORE_STATE_OPERATING = 0x2;
+static constexpr uint8_t CORE_STATE_TRAP_TAKEN = 0x4;
+
+// NOP_INSTRUCTION of rvsteel_core.v, addi x0, x0, 0
+static constexpr uint32_t NOP = 0x00000013;
+
+#ifdef RVSTEEL_MONITOR_DPI
+// From the events of the RTL
+static bool wr_addr_written = false;
+static uint64_t retired_instructions = 0;
+#endif
+
+// Exit codes of a --fuzz program other than EXIT_SUCCESS and EXIT_FAILURE
+static constexpr int FUZZ_TIMEOUT = 2;
+static constexpr int FUZZ_CRASH = 3;
+
+// Tracing modes of the simulation loop. The loop is instantiated once per mode
+// so the untraced variants carry no tracing cost at all.
+enum TraceMode
+{
+  TRACE_OFF,   // Tracing disabled
+  TRACE_ARMED, // Waiting for --trace-start / --trace-pc / --trace-addr
+  TRACE_ON     // Dumping every edge
+};
+
+static void open_trace(const char *out_wave_path)
+{
+  Verilated::traceEverOn(true);
+
+  // --trace-scope
+  if (args.trace_scope)
+  {
+    trace->dumpvars(99, args.trace_scope);
+  }
+
+  dut->trace(trace, 99);
+  trace->set_time_resolution("1ns");
+  trace->set_time_unit("1ns");
+  trace->open(out_wave_path);
+}
+
+static void close_trace()
+{
+  if (trace->isOpen())
+  {
+    trace->dump(trace_time);
+    trace->close();
+  }
+}
+
+#ifdef RVSTEEL_FLIGHT_RECORDER
+
+static void open_flight_recorder(uint32_t cycles)
+{
+  auto *root = dut->rootp;
+
+  recorder.add_signal("unit_tests", "clock", 1, dut->clock);
+  recorder.add_signal("unit_tests", "reset", 1, dut->reset);
+  recorder.add_signal("unit_tests", "rw_address", 32, root->unit_tests__DOT__rw_address);
+  recorder.add_signal("unit_tests", "read_data", 32, root->unit_tests__DOT__read_data);
+  recorder.add_signal("unit_tests", "read_request", 1, root->unit_tests__DOT__read_request);
+  recorder.add_signal("unit_tests", "read_response", 1, root->unit_tests__DOT__read_response);
+  recorder.add_signal("unit_tests", "write_data", 32, root->unit_tests__DOT__write_data);
+  recorder.add_signal("unit_tests", "write_strobe", 4, root->unit_tests__DOT__write_strobe);
+  recorder.add_signal("unit_tests", "write_request", 1, root->unit_tests__DOT__write_request);
+  recorder.add_signal("unit_tests", "write_response", 1, root->unit_tests__DOT__write_response);
+  recorder.add_signal("unit_tests.rvsteel_core_instance", "program_counter", 32,
+                      root->unit_tests__DOT__rvsteel_core_instance__DOT__program_counter);
+  recorder.add_signal("unit_tests.rvsteel_core_instance", "current_state", 4,
+                      root->unit_tests__DOT__rvsteel_core_instance__DOT__current_state);
+
+  // One sample per clock edge
+  recorder.start(2 * (size_t)cycles);
+}
+
+#else
+
+static void open_flight_recorder(uint32_t) {}
+
+#endif
+
+static void dump_flight_recorder(const char *reason)
+{
+  if (recorder.enabled())
+  {
+    Log::info("Flight recorder: %s", reason);
+    recorder.dump(args.wave_on_failure_path);
+  }
+}
+
+// Advance the model by one clock edge. The model only changes on a clock edge,
+// so it is evaluated exactly once per edge and trace_time jumps by half a
+// clock period, keeping the FST timestamps in nanoseconds.
+template <TraceMode MODE> static void edge()
+{
+  dut->clock ^= 1;
+  dut->eval();
+
+  if constexpr (MODE == TRACE_ON)
+  {
+    trace->dump(trace_time);
+  }
+
+  if (recorder.enabled())
+  {
+    recorder.sample(trace_time);
+  }
+
+  trace_time += clk_half_cycles;
+  clk_cur_cycles += dut->clock & 0x1;
+}
+
+template <TraceMode MODE> static void eval(vluint64_t edges_cnt = 1)
+{
+  while (edges_cnt--)
+  {
+    edge<MODE>();
+  }
+}
+
+static void print_run_rate()
+{
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - run_start;
+  double seconds = elapsed.count();
+
+  Log::info("Simulated cycles: %" PRIu64 " in %.3f s (%.0f cycles/s)", (uint64_t)clk_cur_cycles,
+            seconds, seconds > 0 ? clk_cur_cycles / seconds : 0.0);
+
+#ifdef RVSTEEL_MONITOR_DPI
+  Log::info("Retired instructions: %" PRIu64 " (IPC %.3f)", retired_instructions,
+            clk_cur_cycles ? (double)retired_instructions / clk_cur_cycles : 0.0);
+#endif
+}
+
+// --stats
+static void write_stats(const char *exit_reason, int exit_code)
+{
+  auto *root = dut->rootp;
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - run_start;
+
+  run_stats.simulator = "unit_tests";
+  run_stats.exit_reason = exit_reason;
+  run_stats.exit_code = exit_code;
+  run_stats.wall_seconds = elapsed.count();
+  run_stats.startup_seconds = std::chrono::duration<double>(run_start - process_start).count();
+  run_stats.cycles = clk_cur_cycles;
+  run_stats.mcycle = root->unit_tests__DOT__rvsteel_core_instance__DOT__csr_mcycle;
+  run_stats.minstret = root->unit_tests__DOT__rvsteel_core_instance__DOT__csr_minstret;
+  run_stats.host_out_bytes = Log::host_out_count();
+  run_stats.write(args.stats_path);
+}
+
+// --cpi-stack, --commit-log, --lockstep and --stats
+static void write_reports(const char *exit_reason, int exit_code)
+{
+  if (args.cpi_stack_path)
+  {
+    cpi_stack.write(args.cpi_stack_path);
+  }
+
+  commit_log.close();
+
+  if (args.lockstep)
+  {
+    Log::info("Lockstep: %" PRIu64 " records checked", golden_model.records());
+  }
+
+  if (args.stats_path)
+  {
+    write_stats(exit_reason, exit_code);
+  }
+}
+
+template <TraceMode MODE> static void reset_dut()
+{
+  // Hold reset for 100ns
+  dut->reset = 1;
+  eval<MODE>(reset_edges(clk_half_cycles));
+  dut->reset = 0;
+  dut->halt = 0;
+}
+
+void exit_app(int sig)
+{
+  (void)sig;
+  dump_flight_recorder("SIGINT");
+  print_run_rate();
+  write_reports("sigint", EXIT_SUCCESS);
+  close_trace();
+  Log::info("Exit.");
+  std::exit(EXIT_SUCCESS);
+}
+
+// Words of the model RAM, held on the host in RVSTEEL_RAM_DPI builds
+static uint32_t *ram_words()
+{
+#ifdef RVSTEEL_RAM_DPI
+  void *ram = dut->rootp->unit_tests__DOT__rvsteel_ram_instance__DOT__ram_handle;
+  return static_cast<SparseRam *>(ram)->data();
+#else
+  return &dut->rootp->unit_tests__DOT__rvsteel_ram_instance__DOT__ram[0];
+#endif
+}
+
+static void ram_dump_pages()
+{
+#ifdef RVSTEEL_RAM_DPI
+  // --ram-dump-pages
+  if (args.ram_dump_pages)
+  {
+    void *ram = dut->rootp->unit_tests__DOT__rvsteel_ram_instance__DOT__ram_handle;
+    static_cast<SparseRam *>(ram)->dump_pages(args.ram_dump_pages);
+  }
+#endif
+}
+
+static void ram_init(const char *path, RamInitVariants variants)
+{
+  if (not path)
+  {
+    return;
+  }
+
+  uint32_t ram_size = dut->rootp->unit_tests__DOT__MEMORY_SIZE;
+  uint32_t *ram = ram_words();
+
+  switch (variants)
+  {
+    case RamInitVariants::H32:
+      ram_init_h32(args.ram_init_path, ram, ram_size/4);
+      break;
+
+    case RamInitVariants::BIN:
+      ram_init_bin(args.ram_init_path, ram, ram_size/4);
+      break;
+
+    case RamInitVariants::ELF:
+      elf_symbols = ram_init_elf(args.ram_init_path, ram, ram_size/4, args.host_out_symbol);
+      break;
+
+    case RamInitVariants::NONE:
+      break;
+  }
+
+  // The ELF symbols replace --wr-addr and --host-out
+  if (elf_symbols.tohost)
+  {
+    args.wr_addr = elf_symbols.tohost;
+    Log::info("Write address: 0x%x (tohost)", args.wr_addr);
+  }
+
+  if (elf_symbols.host_out)
+  {
+    args.host_out = elf_symbols.host_out;
+    Log::info("Host out: 0x%x", args.host_out);
+  }
+}
+
+static bool is_finished()
+{
+#ifdef RVSTEEL_MONITOR_DPI
+  // Set by the bus write monitor
+  return wr_addr_written;
+#else
+  // After each clock cycle it tests whether the test program finished its execution
+  // This event is signaled by writing 1 to the address 0x00001000
+  return (dut->rootp->unit_tests__DOT__rw_address == args.wr_addr) &&
+         dut->rootp->unit_tests__DOT__write_request &&
+         dut->rootp->unit_tests__DOT__write_data == 0x00000001;
+#endif
+}
+
+#ifndef RVSTEEL_MONITOR_DPI
+static bool is_host_out(uint32_t addr)
+{
+  static bool is_pos_edg = false;
+
+  bool is_write = (addr != 0x0) &&
+                  (not is_pos_edg and dut->rootp->unit_tests__DOT__write_request) &&
+                  (dut->rootp->unit_tests__DOT__rw_address == addr) &&
+                  dut->rootp->unit_tests__DOT__write_request &&
+                  dut->rootp->unit_tests__DOT__write_data;
+
+  is_pos_edg = dut->rootp->unit_tests__DOT__write_request;
+
+  return is_write;
+}
+#endif
+
+static uint32_t get_signature(uint32_t addr)
+{
+  return ram_words()[addr];
+}
+
+// Compares the signature with --compare-ref and prints a PASS or FAIL line in
+// the --batch format. Returns the exit code of the run.
+static int check_signature(const uint32_t *signature, uint32_t words)
+{
+  SignatureCompare result = signature_compare(args.compare_ref, signature, words);
+
+  if (result.match)
+  {
+    std::printf("PASS %s %" PRIu64 "\n", args.ram_init_path, (uint64_t)clk_cur_cycles);
+    return EXIT_SUCCESS;
+  }
+
+  Log::error("Signature at line %u differs from reference: 0x%08x, reference 0x%08x",
+             result.line, result.signature, result.reference);
+  std::printf("FAIL %s %" PRIu64 " %u 0x%08" PRIx32 " 0x%08" PRIx32 "\n", args.ram_init_path,
+              (uint64_t)clk_cur_cycles, result.line, result.signature, result.reference);
+  return EXIT_FAILURE;
+}
+
+// Stops the simulation when one of the exit conditions is met
+static void check_exit()
+{
+  // --cycles
+  if (args.max_cycles)
+  {
+    if (clk_cur_cycles >= args.max_cycles)
+    {
+      Log::info("Exit: end cycles");
+      dump_flight_recorder("end cycles without wr-addr");
+      ram_dump_pages();
+      print_run_rate();
+
+      // --compare-ref: no signature to compare
+      int status = args.compare_ref ? EXIT_FAILURE : EXIT_SUCCESS;
+
+      write_reports("end cycles", status);
+      close_trace();
+
+      if (args.compare_ref)
+      {
+        std::printf("TIMEOUT %s %" PRIu64 "\n", args.ram_init_path, (uint64_t)clk_cur_cycles);
+      }
+
+      std::exit(status);
+    }
+  }
+
+  // --wr-addr
+  if (is_finished())
+  {
+    Log::info("Exit: wr-addr");
+
+    // The beginning and end of signature come from the ELF symbols, otherwise they
+    // are stored at RAM words 2047 and 2046
+    bool is_elf_signature = elf_symbols.begin_signature and elf_symbols.end_signature;
+    uint32_t start_addr = is_elf_signature ? elf_symbols.begin_signature : get_signature(2047);
+    uint32_t stop_addr = is_elf_signature ? elf_symbols.end_signature : get_signature(2046);
+    uint32_t ram_size = dut->rootp->unit_tests__DOT__MEMORY_SIZE;
+    bool in_ram = signature_in_ram(start_addr, stop_addr, ram_size);
+    uint32_t size = in_ram ? stop_addr - start_addr : 0;
+    const uint32_t *signature = ram_words() + (in_ram ? start_addr / 4 : 0);
+
+    Log::info("Signature size: %u", size);
+
+    if (args.ram_dump_h32 and (size >= 4))
+    {
+      signature_dump_h32(args.ram_dump_h32, signature, size / 4);
+    }
+
+    if (args.ram_dump_bin and (size >= 4))
+    {
+      signature_dump_bin(args.ram_dump_bin, signature, size / 4);
+    }
+
+    // --compare-ref
+    int status = EXIT_SUCCESS;
+
+    if (not in_ram)
+    {
+      Log::warning("Bad signature boundaries 0x%08x-0x%08x", start_addr, stop_addr);
+    }
+
+    if (args.compare_ref and not in_ram)
+    {
+      status = EXIT_FAILURE;
+      std::printf("FAIL %s %" PRIu64 " 0 0x00000000 0x00000000\n", args.ram_init_path,
+                  (uint64_t)clk_cur_cycles);
+    }
+    else if (args.compare_ref)
+    {
+      status = check_signature(signature, size / 4);
+    }
+
+    ram_dump_pages();
+
+    print_run_rate();
+    write_reports("wr-addr", status);
+    close_trace();
+    std::exit(status);
+  }
+}
+
+static void check_host_out()
+{
+#ifndef RVSTEEL_MONITOR_DPI
+  // --host-out
+  if (is_host_out(args.host_out))
+  {
+    Log::host_out((char)dut->rootp->unit_tests__DOT__write_data);
+  }
+#endif
+}
+
+// --wr-addr and --host-out from the bus write monitor, and the count of
+// retired instructions, instead of polling the model after every edge
+static void start_monitor()
+{
+#ifdef RVSTEEL_MONITOR_DPI
+  Monitor::on_bus_write(
+      [](const Monitor::BusWrite &write)
+      {
+        if (write.address == args.wr_addr and write.data == 1)
+        {
+          wr_addr_written = true;
+        }
+
+        // Zero writes are not printed, as when polling
+        if (args.host_out and write.address == args.host_out and write.data != 0)
+        {
+          Log::host_out((char)write.data);
+        }
+      });
+
+  Monitor::on_retire([](const Monitor::Retire &) { retired_instructions++; });
+#endif
+}
+
+#ifdef RVSTEEL_CORE_TRACE
+
+// Register written in the cycle, if any
+static void read_rd_write(CommitRecord &record)
+{
+  auto *root = dut->rootp;
+  uint8_t rd = root->unit_tests__DOT__rvsteel_core_instance__DOT__instruction_rd_address;
+
+  if (rd and root->unit_tests__DOT__rvsteel_core_instance__DOT__integer_file_write_enable)
+  {
+    record.rd_write = true;
+    record.rd = rd;
+    record.rd_value =
+        root->unit_tests__DOT__rvsteel_core_instance__DOT__writeback_multiplexer_output;
+  }
+}
+
+// The instruction retired or the trap taken in the cycle. Returns false when
+// the cycle has neither.
+static bool read_commit(const CoreCycle &cycle, CommitRecord &record)
+{
+  auto *root = dut->rootp;
+  CpiStack::Category category = CpiStack::classify(cycle);
+
+  // The trapped instruction can still write its register in the cycle before
+  static CommitRecord trap;
+
+  if (category == CpiStack::TRAP and cycle.state != CORE_STATE_TRAP_TAKEN)
+  {
+    trap = CommitRecord{};
+    read_rd_write(trap);
+    return false;
+  }
+
+  if (category == CpiStack::TRAP and cycle.state == CORE_STATE_TRAP_TAKEN)
+  {
+    record = trap;
+    record.trap = true;
+    record.cause = root->unit_tests__DOT__rvsteel_core_instance__DOT__csr_mcause;
+    record.epc = root->unit_tests__DOT__rvsteel_core_instance__DOT__csr_mepc;
+    trap = CommitRecord{};
+    return true;
+  }
+
+  if (category != CpiStack::RETIRED)
+  {
+    return false;
+  }
+
+  record = CommitRecord{};
+  record.pc = cycle.pc;
+  record.instruction = root->unit_tests__DOT__rvsteel_core_instance__DOT__instruction;
+  read_rd_write(record);
+
+  // A load or store commits in its second cycle
+  record.load = root->unit_tests__DOT__rvsteel_core_instance__DOT__load_commit_cycle;
+  record.store = root->unit_tests__DOT__rvsteel_core_instance__DOT__store_commit_cycle;
+
+  if (record.load or record.store)
+  {
+    // sb, sh and sw from funct3
+    uint32_t size = 1 << ((record.instruction >> 12) & 0x3);
+
+    record.address = root->unit_tests__DOT__rvsteel_core_instance__DOT__target_address_adder;
+    record.store_value = root->unit_tests__DOT__rvsteel_core_instance__DOT__rs2_data;
+    record.store_value &= size == 4 ? UINT32_MAX : (1u << (8 * size)) - 1;
+  }
+
+  return true;
+}
+
+// --lockstep: stops at the first record that differs from the golden model
+static void check_lockstep(const CommitRecord &record)
+{
+  if (golden_model.check(record))
+  {
+    return;
+  }
+
+  Log::error("Lockstep: %s", golden_model.error().c_str());
+  dump_flight_recorder("lockstep mismatch");
+  print_run_rate();
+  write_reports("lockstep mismatch", EXIT_FAILURE);
+  close_trace();
+
+  // --compare-ref: the run fails before the signature
+  if (args.compare_ref)
+  {
+    std::printf("MISMATCH %s %" PRIu64 "\n", args.ram_init_path, (uint64_t)clk_cur_cycles);
+  }
+
+  std::exit(EXIT_FAILURE);
+}
+
+static CoreCycle read_core_cycle()
+{
+  auto *root = dut->rootp;
+
+  return CoreCycle{
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__program_counter,
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__current_state,
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__halt,
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__take_trap,
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__load_pending,
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__store_pending,
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__prev_load_request,
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__prev_read_request,
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__prev_write_request,
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__read_response,
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__write_response
+  };
+}
+
+// --cpi-stack, --commit-log and --lockstep: one sample per cycle, after the
+// falling edge
+static void check_core_cycle()
+{
+  if (dut->clock)
+  {
+    return;
+  }
+
+  CoreCycle cycle = read_core_cycle();
+
+  if (args.cpi_stack_path)
+  {
+    cpi_stack.sample(cycle);
+  }
+
+  CommitRecord record;
+
+  if ((commit_log.is_open() or args.lockstep) and read_commit(cycle, record))
+  {
+    if (commit_log.is_open())
+    {
+      commit_log.write(record);
+    }
+
+    if (args.lockstep)
+    {
+      check_lockstep(record);
+    }
+  }
+}
+
+#else
+
+static void check_core_cycle() {}
+
+#endif
+
+static void check_trap()
+{
+#ifdef RVSTEEL_FLIGHT_RECORDER
+  static bool trap_recorded = false;
+
+  // --wave-on-failure: dump the cycles that led to the first trap
+  if (recorder.enabled() and not trap_recorded and
+      dut->rootp->unit_tests__DOT__rvsteel_core_instance__DOT__current_state ==
+          CORE_STATE_TRAP_TAKEN)
+  {
+    trap_recorded = true;
+    dump_flight_recorder("trap taken");
+  }
+#endif
+
+#ifdef RVSTEEL_CORE_TRACE
+  static bool trap_taken = false;
+
+  // --stats: mcause is written on the edge that leaves the trap state
+  if (args.stats_path and dut->clock)
+  {
+    bool in_trap = dut->rootp->unit_tests__DOT__rvsteel_core_instance__DOT__current_state ==
+                   CORE_STATE_TRAP_TAKEN;
+
+    if (trap_taken and not in_trap)
+    {
+      run_stats.count_trap(dut->rootp->unit_tests__DOT__rvsteel_core_instance__DOT__csr_mcause);
+    }
+
+    trap_taken = in_trap;
+  }
+#endif
+}
+
+#ifdef RVSTEEL_SEMIHOSTING
+
+// --semihosting: services the call when the ebreak of the sequence is in the
+// core, before the rising edge that would take the trap. The ebreak is turned
+// into a nop where the core reads it, the RAM output or the instruction held
+// by a stall, and a0 gets the result. An interrupt taken at the ebreak goes
+// first, the call is made when the handler returns to it.
+static void check_semihosting()
+{
+  auto *root = dut->rootp;
+  auto &read_data = root->unit_tests__DOT__rvsteel_ram_instance__DOT__read_data;
+  auto &prev_instruction = root->unit_tests__DOT__rvsteel_core_instance__DOT__prev_instruction;
+  auto &integer_file = root->unit_tests__DOT__rvsteel_core_instance__DOT__integer_file;
+
+  if (dut->clock or
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__instruction != Semihosting::EBREAK or
+      root->unit_tests__DOT__rvsteel_core_instance__DOT__current_state != CORE_STATE_OPERATING)
+  {
+    return;
+  }
+
+  uint32_t pc = root->unit_tests__DOT__rvsteel_core_instance__DOT__program_counter;
+  uint32_t words = root->unit_tests__DOT__MEMORY_SIZE / 4;
+  uint32_t *ram = ram_words();
+
+  if (not Semihosting::is_call(ram, words, pc))
+  {
+    return;
+  }
+
+  uint32_t saved_read_data = read_data;
+  uint32_t saved_prev_instruction = prev_instruction;
+
+  read_data = read_data == Semihosting::EBREAK ? NOP : read_data;
+  prev_instruction = prev_instruction == Semihosting::EBREAK ? NOP : prev_instruction;
+  dut->eval();
+
+  if (root->unit_tests__DOT__rvsteel_core_instance__DOT__take_trap)
+  {
+    read_data = saved_read_data;
+    prev_instruction = saved_prev_instruction;
+    dut->eval();
+    return;
+  }
+
+  uint64_t time_ns = clk_cur_cycles * 2 * clk_half_cycles;
+  uint32_t a0 = semihosting.call(ram, words, integer_file[9], integer_file[10], time_ns);
+
+  integer_file[9] = a0;
+
+  if (args.lockstep)
+  {
+    golden_model.host_call(a0, ram, semihosting.written_address(), semihosting.written_size());
+  }
+
+  if (semihosting.exited())
+  {
+    Log::info("Exit: semihosting %d", semihosting.exit_code());
+    ram_dump_pages();
+    print_run_rate();
+    write_reports("semihosting", semihosting.exit_code());
+    close_trace();
+    std::exit(semihosting.exit_code());
+  }
+}
+
+#else
+
+static void check_semihosting() {}
+
+#endif
+
+static bool is_trace_trigger()
+{
+  // --trace-start
+  if (clk_cur_cycles < args.trace_start)
+  {
+    return false;
+  }
+
+#ifdef RVSTEEL_TRACE_TRIGGER
+  // --trace-pc
+  if (args.trace_pc_enable)
+  {
+    return dut->rootp->unit_tests__DOT__rvsteel_core_instance__DOT__program_counter ==
+           args.trace_pc;
+  }
+
+  // --trace-addr
+  if (args.trace_addr_enable)
+  {
+    return dut->rootp->unit_tests__DOT__write_request &&
+           dut->rootp->unit_tests__DOT__rw_address == args.trace_addr;
+  }
+#endif
+
+  return true;
+}
+
+static bool is_trace_stop(vluint64_t trace_start_cycle)
+{
+  // --trace-stop
+  if (args.trace_stop and clk_cur_cycles >= args.trace_stop)
+  {
+    return true;
+  }
+
+  // --trace-cycles
+  return args.trace_cycles and (clk_cur_cycles - trace_start_cycle >= args.trace_cycles);
+}
+
+// Runs the simulation loop. The TRACE_ARMED and TRACE_ON variants return when
+// the trace window opens or closes, TRACE_OFF only leaves through check_exit().
+template <TraceMode MODE> static void run()
+{
+  vluint64_t trace_start_cycle = clk_cur_cycles;
+
+  while (true)
+  {
+    eval<MODE>();
+    check_exit();
+    check_trap();
+    check_host_out();
+
+    if (args.semihosting)
+    {
+      check_semihosting();
+    }
+
+    if (args.cpi_stack_path or args.commit_log_path or args.lockstep)
+    {
+      check_core_cycle();
+    }
+
+    if constexpr (MODE == TRACE_ARMED)
+    {
+      if (is_trace_trigger())
+      {
+        return;
+      }
+    }
+
+    if constexpr (MODE == TRACE_ON)
+    {
+      if (is_trace_stop(trace_start_cycle))
+      {
+        return;
+      }
+    }
+  }
+}
+
+#ifdef RVSTEEL_CORE_TRACE
+
+// --fuzz: the registers and the RAM of the RTL against the golden model, when
+// the program writes TOHOST. Returns the first difference, empty when none.
+static std::string compare_fuzz_state()
+{
+  auto *root = dut->rootp;
+  char text[128];
+
+  for (uint32_t i = 1; i < 32; i++)
+  {
+    uint32_t rtl = root->unit_tests__DOT__rvsteel_core_instance__DOT__integer_file[i - 1];
+
+    if (rtl != golden_model.reg(i))
+    {
+      snprintf(text, sizeof(text), "x%u is 0x%08x, expected 0x%08x", i, rtl, golden_model.reg(i));
+      return text;
+    }
+  }
+
+  const uint32_t *ram = ram_words();
+  const std::vector<uint32_t> &memory = golden_model.memory();
+
+  for (uint32_t i = 0; i < memory.size(); i++)
+  {
+    // The store to TOHOST has not completed yet
+    if (ram[i] != memory[i] and i != FuzzProgram::TOHOST / 4)
+    {
+      snprintf(text, sizeof(text), "RAM at 0x%x is 0x%08x, expected 0x%08x", 4 * i, ram[i],
+               memory[i]);
+      return text;
+    }
+  }
+
+  return "";
+}
+
+// --fuzz: ends a child of the fork server. The writer thread of Log only runs
+// in the server, so the reason goes to the server through the pipe and the
+// child leaves with _exit(), without the exit handlers of the server.
+[[noreturn]] static void exit_fuzz_program(int report, int status, const std::string &reason)
+{
+  if (write(report, reason.data(), reason.size()) < 0)
+  {
+    status = FUZZ_CRASH;
+  }
+
+  _exit(status);
+}
+
+// --fuzz: runs the program of the seed in a child forked after reset, checking
+// every retired instruction and trap, then the final state, against the golden
+// model
+[[noreturn]] static void run_fuzz_program(uint64_t seed, int report)
+{
+  auto *root = dut->rootp;
+  FuzzProgram program;
+
+  program.generate(seed);
+  std::copy(program.image().begin(), program.image().end(), ram_words());
+  golden_model.start(root->unit_tests__DOT__rvsteel_core_instance__DOT__program_counter,
+                     ram_words(), root->unit_tests__DOT__MEMORY_SIZE / 4);
+
+  vluint64_t stop_cycle = clk_cur_cycles + args.max_cycles;
+  CommitRecord record;
+
+  // --cycles=0: no limit, as in a single run
+  while (not args.max_cycles or clk_cur_cycles < stop_cycle)
+  {
+    eval<TRACE_OFF>();
+
+    if (is_finished())
+    {
+      std::string difference = compare_fuzz_state();
+      exit_fuzz_program(report, difference.empty() ? EXIT_SUCCESS : EXIT_FAILURE, difference);
+    }
+
+    if (not dut->clock and read_commit(read_core_cycle(), record) and
+        not golden_model.check(record))
+    {
+      exit_fuzz_program(report, EXIT_FAILURE, golden_model.error());
+    }
+  }
+
+  exit_fuzz_program(report, FUZZ_TIMEOUT, "end cycles without TOHOST");
+}
+
+// --fuzz: the fork server. The model is built and reset once, then every
+// program runs in a child forked from that state, up to --jobs at a time. The
+// programs that fail are written to fuzz-<seed>.hex.
+static int run_fuzz()
+{
+  struct Child
+  {
+    uint64_t seed;
+    int report;
+  };
+
+  // The programs end writing 1 to TOHOST
+  args.wr_addr = FuzzProgram::TOHOST;
+  start_monitor();
+  reset_dut<TRACE_OFF>();
+
+  size_t jobs = args.jobs ? args.jobs : std::thread::hardware_concurrency();
+  jobs = std::max<size_t>(1, jobs);
+
+  Log::info("Fuzz: %" PRIu64 " programs from seed %" PRIu64 " on %zu processes", args.fuzz,
+            args.fuzz_seed, jobs);
+
+  std::map<pid_t, Child> running;
+  uint64_t started = 0;
+  uint64_t failed = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  while (started < args.fuzz or not running.empty())
+  {
+    if (started < args.fuzz and running.size() < jobs)
+    {
+      uint64_t seed = args.fuzz_seed + started++;
+      int report[2];
+
+      if (pipe(report) < 0)
+      {
+        Log::error("Fuzz: pipe failed: %s", strerror(errno));
+        std::exit(EXIT_FAILURE);
+      }
+
+      std::fflush(stdout);
+      pid_t pid = fork();
+
+      if (pid < 0)
+      {
+        Log::error("Fuzz: fork failed: %s", strerror(errno));
+        std::exit(EXIT_FAILURE);
+      }
+
+      if (pid == 0)
+      {
+        close(report[0]);
+        run_fuzz_program(seed, report[1]);
+      }
+
+      close(report[1]);
+      running[pid] = Child{seed, report[0]};
+      continue;
+    }
+
+    int status;
+    pid_t pid = wait(&status);
+
+    if (pid < 0)
+    {
+      Log::error("Fuzz: wait failed: %s", strerror(errno));
+      std::exit(EXIT_FAILURE);
+    }
+
+    Child child = running[pid];
+    running.erase(pid);
+
+    char reason[512];
+    ssize_t size = read(child.report, reason, sizeof(reason) - 1);
+    reason[std::max<ssize_t>(size, 0)] = '\0';
+    close(child.report);
+
+    if (WIFEXITED(status) and WEXITSTATUS(status) == EXIT_SUCCESS)
+    {
+      continue;
+    }
+
+    failed++;
+
+    std::string path = "fuzz-" + std::to_string(child.seed) + ".hex";
+    FuzzProgram program;
+    program.generate(child.seed);
+    signature_dump_h32(path.c_str(), program.image().data(), program.image().size());
+
+    if (WIFSIGNALED(status))
+    {
+      snprintf(reason, sizeof(reason), "killed by signal %d", WTERMSIG(status));
+    }
+
+    Log::error("Fuzz: seed %" PRIu64 ": %s", child.seed, reason);
+    std::printf("%s %s\n",
+                WIFEXITED(status) and WEXITSTATUS(status) == FUZZ_TIMEOUT ? "TIMEOUT" : "FAIL",
+                path.c_str());
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  double seconds = elapsed.count();
+
+  std::fflush(stdout);
+  Log::info("Fuzz: %" PRIu64 " of %" PRIu64 " programs passed in %.3f s (%.0f programs/s)",
+            args.fuzz - failed, args.fuzz, seconds, seconds > 0 ? args.fuzz / seconds : 0.0);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#else
+
+static int run_fuzz()
+{
+  return EXIT_FAILURE;
+}
+
+#endif
+
+int main(int argc, char *argv[])
+{
+  signal(SIGINT, exit_app);
+  signal(SIGKILL, exit_app);
+
+  // Default log level
+  Log::set_level(Log::DEBUG);
+  args = parser(argc, argv);
+
+  // The signals of these options are only public in the model when built with them
+#ifndef RVSTEEL_FLIGHT_RECORDER
+  if (args.wave_on_failure)
+  {
+    Log::error("--wave-on-failure needs a RVSTEEL_FLIGHT_RECORDER build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+#ifndef RVSTEEL_TRACE_TRIGGER
+  if (args.trace_pc_enable or args.trace_addr_enable)
+  {
+    Log::error("--trace-pc and --trace-addr need a RVSTEEL_TRACE_TRIGGER build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+#ifndef RVSTEEL_CORE_TRACE
+  if (args.cpi_stack_path or args.commit_log_path or args.lockstep or args.fuzz)
+  {
+    Log::error("--cpi-stack, --commit-log, --lockstep and --fuzz need a RVSTEEL_CORE_TRACE build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+#ifndef RVSTEEL_SEMIHOSTING
+  if (args.semihosting)
+  {
+    Log::error("--semihosting needs a RVSTEEL_SEMIHOSTING build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+  if (args.batch_path)
+  {
+    return run_batch(args, reset_edges(clk_half_cycles));
+  }
+
+  if (args.fuzz)
+  {
+    return run_fuzz();
+  }
+
+  // Messages are stamped with the simulated cycle from here on
+  Log::set_cycles(&clk_cur_cycles);
+
+#ifdef RVSTEEL_RAM_DPI
+  // --ram-file, before the first eval opens the RAM
+  SparseRam::backing_path = args.ram_file_path;
+#else
+  if (args.ram_file_path or args.ram_dump_pages)
+  {
+    Log::error("--ram-file and --ram-dump-pages need a RVSTEEL_RAM_DPI build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+  if (args.compare_ref and not args.ram_init_path)
+  {
+    Log::error("--compare-ref needs a program: --ram-init-h32, --ram-init-bin or --ram-init-elf");
+    std::exit(EXIT_FAILURE);
+  }
+
+  if (args.out_wave_path)
+  {
+    open_trace(args.out_wave_path);
+  }
+
+  if (args.wave_on_failure)
+  {
+    open_flight_recorder(args.wave_on_failure);
+  }
+
+  // Trace from reset unless a trace window or trigger is requested
+  bool trace_from_reset = args.out_wave_path and (args.trace_start == 0) and
+                          not args.trace_pc_enable and not args.trace_addr_enable;
+
+  if (trace_from_reset)
+  {
+    reset_dut<TRACE_ON>();
+  }
+  else
+  {
+    reset_dut<TRACE_OFF>();
+  }
+
+  ram_init(args.ram_init_path, args.ram_init_variants);
+  start_monitor();
+
+  run_start = std::chrono::steady_clock::now();
+
+  if (args.cpi_stack_path)
+  {
+    cpi_stack.start(elf_symbols.functions);
+  }
+
+  if (args.commit_log_path)
+  {
+    commit_log.open(args.commit_log_path);
+  }
+
+#ifdef RVSTEEL_CORE_TRACE
+  if (args.lockstep)
+  {
+    golden_model.start(dut->rootp->unit_tests__DOT__rvsteel_core_instance__DOT__program_counter,
+                       ram_words(), dut->rootp->unit_tests__DOT__MEMORY_SIZE / 4);
+  }
+#endif
+
+  if (not args.out_wave_path)
+  {
+    run<TRACE_OFF>();
+  }
+
+  if (not trace_from_reset)
+  {
+    run<TRACE_ARMED>();
+  }
+
+  Log::info("Trace start: cycle %" PRIu64, (uint64_t)clk_cur_cycles);
+  run<TRACE_ON>();
+
+  Log::info("Trace stop: cycle %" PRIu64, (uint64_t)clk_cur_cycles);
+  close_trace();
+  run<TRACE_OFF>();
+}
@@ -0,0 +1,46 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "monitor.h"
+
+void Monitor::bus_write(const BusWrite &write)
+{
+  Monitor &monitor = get_instance();
+
+  if (monitor.enabled)
+  {
+    for (const BusWriteHandler &handler : monitor.bus_write_handlers)
+    {
+      handler(write);
+    }
+  }
+}
+
+void Monitor::retire(const Retire &retire)
+{
+  Monitor &monitor = get_instance();
+
+  if (monitor.enabled)
+  {
+    for (const RetireHandler &handler : monitor.retire_handlers)
+    {
+      handler(retire);
+    }
+  }
+}
+
+// DPI-C imports of rvsteel_bus.v (unit_tests.v in the core tests) and
+// rvsteel_core.v
+extern "C" void rvsteel_monitor_bus_write(int address, int data, int strobe)
+{
+  Monitor::bus_write({(uint32_t)address, (uint32_t)data, (uint8_t)strobe});
+}
+
+extern "C" void rvsteel_monitor_retire(int pc, int instruction)
+{
+  Monitor::retire({(uint32_t)pc, (uint32_t)instruction});
+}
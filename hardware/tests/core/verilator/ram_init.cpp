@@ -7,115 +7,355 @@
 
 #include "ram_init.h"
 
-#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "log.h"
 
-void ram_init_h32(const char *path, uint32_t words, DutRamWrite write)
+static constexpr uint32_t RAM_FILL = 0xdeadbeef;
+
+#ifdef RVSTEEL_RAM_DPI
+// The sparse RAM reads zero until written, filling it would allocate every page
+static constexpr bool RAM_FILL_ENABLE = false;
+#else
+static constexpr bool RAM_FILL_ENABLE = true;
+#endif
+
+// Read-only mapping of a whole file
+class MappedFile
 {
-  std::ifstream file;
+  public:
+    explicit MappedFile(const char *path)
+    {
+      int fd = open(path, O_RDONLY);
+      struct stat st;
+
+      if (fd < 0 or fstat(fd, &st) < 0)
+      {
+        Log::error("Error file opening: %s", path);
+        std::exit(EXIT_FAILURE);
+      }
+
+      size = st.st_size;
 
-  file.open(path, std::ios::in);
+      if (size)
+      {
+        void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (map == MAP_FAILED)
+        {
+          Log::error("Error file mapping: %s", path);
+          std::exit(EXIT_FAILURE);
+        }
+
+        madvise(map, size, MADV_SEQUENTIAL);
+        data = static_cast<const uint8_t *>(map);
+      }
+
+      close(fd);
+    }
 
-  if (!file.is_open())
+    ~MappedFile()
+    {
+      if (data)
+      {
+        munmap(const_cast<uint8_t *>(data), size);
+      }
+    }
+
+    const uint8_t *data{nullptr};
+    size_t size{0};
+};
+
+// Hex digit value of each character, 0xff for anything else
+struct HexTable
+{
+  uint8_t value[256];
+
+  constexpr HexTable() : value()
   {
-    Log::error("Error file opening: %s", path);
-    std::exit(EXIT_FAILURE);
+    for (int c = 0; c < 256; c++)
+    {
+      value[c] = 0xff;
+    }
+
+    for (int c = '0'; c <= '9'; c++)
+    {
+      value[c] = c - '0';
+    }
+
+    for (int c = 'a'; c <= 'f'; c++)
+    {
+      value[c] = c - 'a' + 10;
+      value[c - 'a' + 'A'] = c - 'a' + 10;
+    }
   }
+};
 
-  Log::info("Ram words %u", words);
+static constexpr HexTable hex_table;
 
-  std::string line;
-  size_t load_address = 0x00000000;
+static bool is_space(uint8_t c)
+{
+  return c == ' ' or c == '\n' or c == '\r' or c == '\t';
+}
+
+void ram_init_h32(const char *path, uint32_t *ram, uint32_t words)
+{
+  MappedFile file(path);
+
+  Log::info("Ram words %u", words);
 
   // First initialize the RAM
-  for (size_t i = 0; i < words; i++)
+  if (RAM_FILL_ENABLE)
   {
-    write(i, 0xdeadbeef);
+    std::fill_n(ram, words, RAM_FILL);
   }
 
   // Then load the memory init file
-  while (std::getline(file, line))
+  const uint8_t *p = file.data;
+  const uint8_t *end = file.data + file.size;
+  size_t load_address = 0x00000000;
+
+  while (p < end)
   {
-    char *token = strtok((char *)line.c_str(), " \n");
-    while (token != NULL)
+    if (is_space(*p))
     {
-      std::string token_str = std::string(token);
-      if (token_str[0] == '@') // update load address
-      {
-        load_address = std::stoul(token_str.substr(1), nullptr, 16);
-        token = strtok(NULL, " \n");
-      }
-      else
-      {
-        uint32_t data = std::stoul(token_str, nullptr, 16);
+      p++;
+      continue;
+    }
 
-        if (load_address > words)
-        {
-          Log::error("Out of range load address ram: 0x%x", load_address);
-          std::exit(EXIT_FAILURE);
-        }
+    bool is_address = (*p == '@'); // update load address
+    p += is_address;
 
-        write(load_address, data);
-        token = strtok(NULL, " \n");
-        load_address++;
-      }
+    uint32_t value = 0;
+    const uint8_t *token = p;
+
+    for (uint8_t digit; p < end and (digit = hex_table.value[*p]) != 0xff; p++)
+    {
+      value = (value << 4) | digit;
+    }
+
+    if (p == token or (p < end and not is_space(*p)))
+    {
+      Log::error("Invalid hex at offset %zu: %s", (size_t)(p - file.data), path);
+      std::exit(EXIT_FAILURE);
+    }
+
+    if (is_address)
+    {
+      load_address = value;
+      continue;
     }
+
+    if (load_address >= words)
+    {
+      Log::error("Out of range load address ram: 0x%x", load_address);
+      std::exit(EXIT_FAILURE);
+    }
+
+    ram[load_address++] = value;
   }
 
   Log::info("Ok init ram h32");
-  file.close();
 }
 
-void ram_init_bin(const char *path, uint32_t words, DutRamWrite write)
+void ram_init_bin(const char *path, uint32_t *ram, uint32_t words)
 {
-  std::ifstream file;
+  MappedFile file(path);
+
+  Log::info("Ram words %u", words);
 
-  file.open(path, std::ios::binary);
+  // The file is a little-endian image of the RAM, copied as is
+  size_t load_words = (file.size + 3) / 4;
 
-  if (!file.is_open())
+  if (load_words > words)
   {
-    Log::error("Error file opening: %s", path);
+    Log::error("Out of range load address ram: 0x%x", words);
     std::exit(EXIT_FAILURE);
   }
 
+  // First initialize the RAM past the image, the last partial word is zero padded
+  if (RAM_FILL_ENABLE)
+  {
+    std::fill_n(ram + load_words, words - load_words, RAM_FILL);
+  }
+
+  if (file.size % 4)
+  {
+    ram[load_words - 1] = 0;
+  }
+
+  if (file.size)
+  {
+    std::memcpy(ram, file.data, file.size);
+  }
+
+  Log::info("Ok init ram bin");
+}
+
+static void elf_error(const char *path)
+{
+  Log::error("Not a valid RV32 ELF file: %s", path);
+  std::exit(EXIT_FAILURE);
+}
+
+// Functions, and the labels of assembly code such as _start, but not the local
+// labels nor the $x mapping symbols
+static bool is_function(const Elf32_Ehdr *ehdr, const Elf32_Shdr *shdr, const Elf32_Sym &sym,
+                        const char *name)
+{
+  if (name[0] == '\0' or name[0] == '$' or strncmp(name, ".L", 2) == 0)
+  {
+    return false;
+  }
+
+  if (ELF32_ST_TYPE(sym.st_info) == STT_FUNC)
+  {
+    return true;
+  }
+
+  return ELF32_ST_TYPE(sym.st_info) == STT_NOTYPE and sym.st_shndx != SHN_UNDEF and
+         sym.st_shndx < ehdr->e_shnum and (shdr[sym.st_shndx].sh_flags & SHF_EXECINSTR);
+}
+
+ElfSymbols ram_init_elf(const char *path, uint32_t *ram, uint32_t words,
+                        const char *host_out_symbol)
+{
+  MappedFile file(path);
+  const Elf32_Ehdr *ehdr = reinterpret_cast<const Elf32_Ehdr *>(file.data);
+
+  if (file.size < sizeof(Elf32_Ehdr) or memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 or
+      ehdr->e_ident[EI_CLASS] != ELFCLASS32 or ehdr->e_ident[EI_DATA] != ELFDATA2LSB or
+      ehdr->e_machine != EM_RISCV)
+  {
+    elf_error(path);
+  }
+
+  if (ehdr->e_phoff + (size_t)ehdr->e_phnum * sizeof(Elf32_Phdr) > file.size or
+      ehdr->e_shoff + (size_t)ehdr->e_shnum * sizeof(Elf32_Shdr) > file.size)
+  {
+    elf_error(path);
+  }
+
   Log::info("Ram words %u", words);
 
   // First initialize the RAM
-  for (size_t i = 0; i < words; i++)
+  if (RAM_FILL_ENABLE)
   {
-    write(i, 0xdeadbeef);
+    std::fill_n(ram, words, RAM_FILL);
   }
 
-  char buffer[4];
-  size_t load_address = 0;
+  // Then copy the loadable segments, zeroing what is not in the file (.bss)
+  uint8_t *ram_bytes = reinterpret_cast<uint8_t *>(ram);
+  const Elf32_Phdr *phdr = reinterpret_cast<const Elf32_Phdr *>(file.data + ehdr->e_phoff);
 
-  while (not file.eof())
+  for (size_t i = 0; i < ehdr->e_phnum; i++)
   {
-    file.read(buffer, 4);
+    const Elf32_Phdr &segment = phdr[i];
+
+    if (segment.p_type != PT_LOAD or segment.p_memsz == 0)
+    {
+      continue;
+    }
 
-    uint32_t data = 0;
-    size_t count = file.gcount();
+    if ((size_t)segment.p_paddr + segment.p_memsz > (size_t)words * 4)
+    {
+      Log::error("Out of range load address ram: 0x%x", segment.p_paddr);
+      std::exit(EXIT_FAILURE);
+    }
 
-    if (count == 0)
+    if ((size_t)segment.p_offset + segment.p_filesz > file.size or
+        segment.p_filesz > segment.p_memsz)
     {
-      break;
+      elf_error(path);
     }
 
-    for (size_t i = count; i != 0; i--)
+    std::memcpy(ram_bytes + segment.p_paddr, file.data + segment.p_offset, segment.p_filesz);
+    std::memset(ram_bytes + segment.p_paddr + segment.p_filesz, 0,
+                segment.p_memsz - segment.p_filesz);
+  }
+
+  // Resolve the symbols from the symbol table
+  ElfSymbols symbols;
+  const Elf32_Shdr *shdr = reinterpret_cast<const Elf32_Shdr *>(file.data + ehdr->e_shoff);
+
+  for (size_t i = 0; i < ehdr->e_shnum; i++)
+  {
+    if (shdr[i].sh_type != SHT_SYMTAB or shdr[i].sh_link >= ehdr->e_shnum)
     {
-        data <<= 8;
-        data |= (buffer[i-1] & 0xff);
+      continue;
     }
 
-    if (load_address > words)
+    const Elf32_Shdr &strtab = shdr[shdr[i].sh_link];
+    const Elf32_Sym *sym = reinterpret_cast<const Elf32_Sym *>(file.data + shdr[i].sh_offset);
+    size_t count = shdr[i].sh_size / sizeof(Elf32_Sym);
+
+    if (shdr[i].sh_offset + shdr[i].sh_size > file.size or
+        strtab.sh_offset + strtab.sh_size > file.size)
     {
-      Log::error("Out of range load address ram: 0x%x", load_address);
-      std::exit(EXIT_FAILURE);
+      elf_error(path);
     }
 
-    write(load_address++, data);
+    for (size_t n = 0; n < count; n++)
+    {
+      if (sym[n].st_name >= strtab.sh_size)
+      {
+        continue;
+      }
+
+      const char *name = reinterpret_cast<const char *>(file.data + strtab.sh_offset) +
+                         sym[n].st_name;
+
+      if (is_function(ehdr, shdr, sym[n], name))
+      {
+        symbols.functions.push_back({sym[n].st_value, sym[n].st_size, name});
+      }
+
+      if (strcmp(name, "tohost") == 0)
+      {
+        symbols.tohost = sym[n].st_value;
+      }
+      else if (strcmp(name, "begin_signature") == 0)
+      {
+        symbols.begin_signature = sym[n].st_value;
+      }
+      else if (strcmp(name, "end_signature") == 0)
+      {
+        symbols.end_signature = sym[n].st_value;
+      }
+      else if (host_out_symbol and strcmp(name, host_out_symbol) == 0)
+      {
+        symbols.host_out = sym[n].st_value;
+      }
+    }
   }
 
-  Log::info("Ok init ram bin");
-  file.close();
+  // One symbol per address, a sized one before the labels
+  std::stable_sort(symbols.functions.begin(), symbols.functions.end(),
+                   [](const ElfFunction &a, const ElfFunction &b)
+                   {
+                     return a.address < b.address or
+                            (a.address == b.address and a.size > b.size);
+                   });
+
+  auto last = std::unique(symbols.functions.begin(), symbols.functions.end(),
+                          [](const ElfFunction &a, const ElfFunction &b)
+                          { return a.address == b.address; });
+
+  symbols.functions.erase(last, symbols.functions.end());
+
+  if (host_out_symbol and not symbols.host_out)
+  {
+    Log::warning("Symbol not found: %s", host_out_symbol);
+  }
+
+  Log::info("Ok init ram elf");
+
+  return symbols;
 }
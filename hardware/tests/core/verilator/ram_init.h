@@ -10,11 +10,38 @@
 
 #include <cstdint>
 #include <cstddef>
-#include <functional>
+#include <string>
+#include <vector>
 
-using DutRamWrite = std::function<void(uint32_t i, uint32_t v)>;
+// Both loaders fill the RAM with 0xdeadbeef, then load the file. ram points to
+// the words of the Verilated RAM, e.g. &rootp->..._DOT__ram[0], and is
+// written directly in bulk.
+void ram_init_h32(const char *path, uint32_t *ram, uint32_t words);
+void ram_init_bin(const char *path, uint32_t *ram, uint32_t words);
 
-void ram_init_h32(const char *path, uint32_t words, DutRamWrite write);
-void ram_init_bin(const char *path, uint32_t words, DutRamWrite write);
+// Function or code label of the ELF symbol table, size 0 when unknown
+struct ElfFunction
+{
+  uint32_t address;
+  uint32_t size;
+  std::string name;
+};
+
+// Addresses of the symbols found by ram_init_elf(), 0 when not present. The
+// RAM starts at address 0, which holds the boot code, never one of these.
+struct ElfSymbols
+{
+  uint32_t tohost{0};
+  uint32_t begin_signature{0};
+  uint32_t end_signature{0};
+  uint32_t host_out{0}; // host_out_symbol, if given
+
+  // Sorted by address, one per address
+  std::vector<ElfFunction> functions;
+};
+
+// Loads the PT_LOAD segments of an RV32 ELF file and resolves its symbols
+ElfSymbols ram_init_elf(const char *path, uint32_t *ram, uint32_t words,
+                        const char *host_out_symbol);
 
 #endif // RAM_INIT_H
@@ -0,0 +1,59 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "run_stats.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+
+#include "log.h"
+
+void RunStats::write(const char *path) const
+{
+  FILE *file = fopen(path, "w");
+
+  if (!file)
+  {
+    Log::error("Error file opening: %s", path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  // Peak resident set size of the process so far, in KB on Linux
+  struct rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+
+  // The names come from the harness, none needs escaping
+  fprintf(file, "{\n");
+  fprintf(file, "  \"simulator\": \"%s\",\n", simulator);
+  fprintf(file, "  \"exit_reason\": \"%s\",\n", exit_reason);
+  fprintf(file, "  \"exit_code\": %d,\n", exit_code);
+  fprintf(file, "  \"wall_time_s\": %.6f,\n", wall_seconds);
+  fprintf(file, "  \"startup_s\": %.6f,\n", startup_seconds);
+  fprintf(file, "  \"simulated_cycles\": %llu,\n", (unsigned long long)cycles);
+  fprintf(file, "  \"host_khz\": %.3f,\n", wall_seconds > 0 ? cycles / wall_seconds / 1e3 : 0.0);
+  fprintf(file, "  \"mcycle\": %llu,\n", (unsigned long long)mcycle);
+  fprintf(file, "  \"minstret\": %llu,\n", (unsigned long long)minstret);
+  fprintf(file, "  \"cpi\": %.6f,\n", minstret ? (double)mcycle / minstret : 0.0);
+  fprintf(file, "  \"host_out_bytes\": %llu,\n", (unsigned long long)host_out_bytes);
+  fprintf(file, "  \"peak_rss_kb\": %ld,\n", usage.ru_maxrss);
+
+  // mcause as a hex string, JSON keys cannot be numbers
+  fprintf(file, "  \"traps\": {");
+
+  const char *separator = "";
+
+  for (const auto &[mcause, count] : traps)
+  {
+    fprintf(file, "%s\n    \"0x%08x\": %llu", separator, mcause, (unsigned long long)count);
+    separator = ",";
+  }
+
+  fprintf(file, "%s}\n", traps.empty() ? "" : "\n  ");
+  fprintf(file, "}\n");
+  fclose(file);
+}
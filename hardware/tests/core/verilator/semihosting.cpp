@@ -0,0 +1,264 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "semihosting.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <unistd.h>
+
+#include "log.h"
+
+// fopen() modes of SYS_OPEN
+static const char *const OPEN_MODES[] = {"r", "rb", "r+", "r+b", "w", "wb",
+                                         "w+", "w+b", "a", "ab", "a+", "a+b"};
+
+static constexpr uint32_t OPEN_MODES_COUNT = sizeof(OPEN_MODES) / sizeof(OPEN_MODES[0]);
+
+Semihosting::~Semihosting()
+{
+  for (File &entry : files)
+  {
+    if (entry.file and not entry.console)
+    {
+      fclose(entry.file);
+    }
+  }
+}
+
+bool Semihosting::is_call(const uint32_t *ram, uint32_t words, uint32_t pc)
+{
+  uint32_t index = pc / 4;
+
+  return (pc & 0x3) == 0 and index > 0 and index + 1 < words and ram[index] == EBREAK and
+         ram[index - 1] == SLLI_X0 and ram[index + 1] == SRAI_X0;
+}
+
+bool Semihosting::in_ram(uint32_t address, uint32_t size) const
+{
+  return (uint64_t)address + size <= ram_size;
+}
+
+bool Semihosting::read_block(uint32_t address, uint32_t *block, uint32_t count) const
+{
+  if (not in_ram(address, 4 * count))
+  {
+    Log::warning("Semihosting: parameter block out of RAM: 0x%x", address);
+    return false;
+  }
+
+  std::memcpy(block, ram + address, 4 * count);
+  return true;
+}
+
+Semihosting::File *Semihosting::file(uint32_t handle)
+{
+  if (handle == 0 or handle > files.size() or not files[handle - 1].file)
+  {
+    Log::warning("Semihosting: invalid handle %u", handle);
+    return nullptr;
+  }
+
+  return &files[handle - 1];
+}
+
+uint32_t Semihosting::call(uint32_t *ram, uint32_t words, uint32_t a0, uint32_t a1,
+                           uint64_t time_ns)
+{
+  this->ram = reinterpret_cast<uint8_t *>(ram);
+  ram_size = 4 * words;
+  written_start = 0;
+  written_bytes = 0;
+
+  uint32_t block[2];
+
+  switch (a0)
+  {
+  case SYS_OPEN: return sys_open(a1);
+  case SYS_CLOSE: return sys_close(a1);
+  case SYS_WRITE0: return sys_write0(a1);
+  case SYS_WRITE: return sys_write(a1);
+  case SYS_READ: return sys_read(a1);
+
+  case SYS_WRITEC:
+    if (not in_ram(a1, 1))
+    {
+      Log::warning("Semihosting: character out of RAM: 0x%x", a1);
+      return ERROR;
+    }
+
+    Log::host_out((char)this->ram[a1]);
+    return 0;
+
+  // Hundredths of a second
+  case SYS_CLOCK: return (uint32_t)(time_ns / 10000000);
+
+  // RV32 passes the reason itself, SYS_EXIT_EXTENDED a block with the code
+  case SYS_EXIT: return sys_exit(a1, EXIT_SUCCESS);
+
+  case SYS_EXIT_EXTENDED:
+    return read_block(a1, block, 2) ? sys_exit(block[0], block[1]) : ERROR;
+
+  default:
+    Log::warning("Semihosting: unsupported operation 0x%x", a0);
+    return ERROR;
+  }
+}
+
+// Block: name, mode, name length. Returns the handle.
+uint32_t Semihosting::sys_open(uint32_t parameter)
+{
+  uint32_t block[3];
+
+  if (not read_block(parameter, block, 3))
+  {
+    return ERROR;
+  }
+
+  uint32_t mode = block[1];
+
+  if (not in_ram(block[0], block[2]) or mode >= OPEN_MODES_COUNT)
+  {
+    Log::warning("Semihosting: invalid open at 0x%x", parameter);
+    return ERROR;
+  }
+
+  std::string name(reinterpret_cast<const char *>(ram + block[0]), block[2]);
+  File entry{nullptr, name == ":tt"};
+
+  if (entry.console)
+  {
+    // "r" modes read stdin, "w" modes write stdout and "a" modes stderr
+    entry.file = mode < 4 ? stdin : mode < 8 ? stdout : stderr;
+  }
+  else
+  {
+    entry.file = fopen(name.c_str(), OPEN_MODES[mode]);
+
+    if (not entry.file)
+    {
+      Log::warning("Semihosting: cannot open %s", name.c_str());
+      return ERROR;
+    }
+  }
+
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    if (not files[i].file)
+    {
+      files[i] = entry;
+      return i + 1;
+    }
+  }
+
+  files.push_back(entry);
+  return files.size();
+}
+
+// Block: handle
+uint32_t Semihosting::sys_close(uint32_t parameter)
+{
+  uint32_t handle;
+  File *entry;
+
+  if (not read_block(parameter, &handle, 1) or not(entry = file(handle)))
+  {
+    return ERROR;
+  }
+
+  int status = entry->console ? 0 : fclose(entry->file);
+  entry->file = nullptr;
+
+  return status == 0 ? 0 : ERROR;
+}
+
+// A zero terminated string
+uint32_t Semihosting::sys_write0(uint32_t address)
+{
+  for (; address < ram_size and ram[address]; address++)
+  {
+    Log::host_out((char)ram[address]);
+  }
+
+  return 0;
+}
+
+// Block: handle, buffer, length. Returns the bytes not written.
+uint32_t Semihosting::sys_write(uint32_t parameter)
+{
+  uint32_t block[3];
+  File *entry;
+
+  if (not read_block(parameter, block, 3) or not(entry = file(block[0])))
+  {
+    return ERROR;
+  }
+
+  uint32_t buffer = block[1];
+  uint32_t length = block[2];
+
+  if (not in_ram(buffer, length))
+  {
+    Log::warning("Semihosting: write buffer out of RAM: 0x%x", buffer);
+    return length;
+  }
+
+  // The console goes with the --host-out text
+  if (entry->console and entry->file != stdin)
+  {
+    for (uint32_t i = 0; i < length; i++)
+    {
+      Log::host_out((char)ram[buffer + i]);
+    }
+
+    return 0;
+  }
+
+  return length - fwrite(ram + buffer, 1, length, entry->file);
+}
+
+// Block: handle, buffer, length. Returns the bytes not read, length at the end
+// of the file.
+uint32_t Semihosting::sys_read(uint32_t parameter)
+{
+  uint32_t block[3];
+  File *entry;
+
+  if (not read_block(parameter, block, 3) or not(entry = file(block[0])))
+  {
+    return ERROR;
+  }
+
+  uint32_t buffer = block[1];
+  uint32_t length = block[2];
+
+  if (not in_ram(buffer, length))
+  {
+    Log::warning("Semihosting: read buffer out of RAM: 0x%x", buffer);
+    return length;
+  }
+
+  // The console returns what a line of stdin has
+  size_t count = entry->console ? read(fileno(stdin), ram + buffer, length)
+                                : fread(ram + buffer, 1, length, entry->file);
+
+  count = count == (size_t)-1 ? 0 : count;
+  written_start = buffer;
+  written_bytes = count;
+
+  return length - count;
+}
+
+// The exit code is the subcode of an application exit, a failure otherwise
+uint32_t Semihosting::sys_exit(uint32_t reason, uint32_t subcode)
+{
+  exit_called = true;
+  exit_status = reason == ADP_STOPPED_APPLICATION_EXIT ? (int)subcode : EXIT_FAILURE;
+  return 0;
+}
@@ -0,0 +1,111 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "signature.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "log.h"
+
+static FILE *open_file(const char *path, const char *mode)
+{
+  FILE *file = fopen(path, mode);
+
+  if (!file)
+  {
+    Log::error("Error file opening: %s", path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  return file;
+}
+
+static void write_file(const char *path, const void *data, size_t size)
+{
+  FILE *file = open_file(path, "wb");
+
+  if (fwrite(data, 1, size, file) != size or fclose(file) != 0)
+  {
+    Log::error("Error file writing: %s", path);
+    std::exit(EXIT_FAILURE);
+  }
+}
+
+void signature_dump_h32(const char *path, const uint32_t *signature, uint32_t words)
+{
+  static constexpr char HEX[] = "0123456789abcdef";
+
+  // "%08x\n" per word
+  std::vector<char> out((size_t)words * 9);
+  char *p = out.data();
+
+  for (uint32_t i = 0; i < words; i++)
+  {
+    for (int shift = 28; shift >= 0; shift -= 4)
+    {
+      *p++ = HEX[(signature[i] >> shift) & 0xf];
+    }
+
+    *p++ = '\n';
+  }
+
+  write_file(path, out.data(), out.size());
+  Log::info("Ok dump ram h32");
+}
+
+void signature_dump_bin(const char *path, const uint32_t *signature, uint32_t words)
+{
+  // Little-endian words, the format read by --ram-init-bin
+  write_file(path, signature, (size_t)words * 4);
+  Log::info("Ok dump ram bin");
+}
+
+SignatureCompare signature_compare(const char *path, const uint32_t *signature, uint32_t words)
+{
+  FILE *file = open_file(path, "rb");
+  std::vector<char> text;
+  char buff[4096];
+  size_t size;
+
+  while ((size = fread(buff, 1, sizeof(buff), file)) > 0)
+  {
+    text.insert(text.end(), buff, buff + size);
+  }
+
+  fclose(file);
+  text.push_back('\0');
+
+  SignatureCompare result;
+  const char *p = text.data();
+
+  for (uint32_t i = 0; i < words; i++)
+  {
+    char *end;
+    uint32_t reference = strtoul(p, &end, 16);
+
+    // End of the reference
+    if (end == p)
+    {
+      break;
+    }
+
+    p = end;
+
+    if (signature[i] != reference)
+    {
+      result.match = false;
+      result.line = i + 1;
+      result.signature = signature[i];
+      result.reference = reference;
+      break;
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,38 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef SIGNATURE_H
+#define SIGNATURE_H
+
+#include <cstdint>
+#include <cstddef>
+
+// First difference between a signature and its reference, lines count from 1
+struct SignatureCompare
+{
+  bool match{true};
+  uint32_t line{0};
+  uint32_t signature{0};
+  uint32_t reference{0};
+};
+
+// Whether the signature boundaries, in bytes, hold at least a word of a RAM of
+// ram_size bytes. A program that never writes them leaves anything there.
+inline bool signature_in_ram(uint32_t start, uint32_t stop, uint32_t ram_size)
+{
+  return start <= stop and stop <= ram_size and stop - start >= 4;
+}
+
+// Both dumps format the whole signature in memory and write it at once
+void signature_dump_h32(const char *path, const uint32_t *signature, uint32_t words);
+void signature_dump_bin(const char *path, const uint32_t *signature, uint32_t words);
+
+// Compares the signature with a reference in h32 format, one word per line, up
+// to the shorter of the two
+SignatureCompare signature_compare(const char *path, const uint32_t *signature, uint32_t words);
+
+#endif // SIGNATURE_H
@@ -0,0 +1,150 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "sparse_ram.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "log.h"
+
+const char *SparseRam::backing_path = nullptr;
+
+const uint32_t SparseRam::STROBE_MASK[16] = {
+    0x00000000, 0x000000ff, 0x0000ff00, 0x0000ffff, 0x00ff0000, 0x00ff00ff,
+    0x00ffff00, 0x00ffffff, 0xff000000, 0xff0000ff, 0xff00ff00, 0xff00ffff,
+    0xffff0000, 0xffff00ff, 0xffffff00, 0xffffffff,
+};
+
+SparseRam::SparseRam(uint32_t words) : words(words)
+{
+  bytes = ((size_t)words * 4 + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+  void *map;
+
+  if (backing_path)
+  {
+    int fd = open(backing_path, O_RDWR | O_CREAT, 0644);
+    struct stat st;
+
+    if (fd < 0 or fstat(fd, &st) < 0)
+    {
+      Log::error("Error file opening: %s", backing_path);
+      std::exit(EXIT_FAILURE);
+    }
+
+    // Growing the file leaves a hole, it takes no disk space until written
+    if ((size_t)st.st_size < bytes and ftruncate(fd, bytes) < 0)
+    {
+      Log::error("Error file resizing: %s", backing_path);
+      std::exit(EXIT_FAILURE);
+    }
+
+    map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+  }
+  else
+  {
+    map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+               -1, 0);
+  }
+
+  if (map == MAP_FAILED)
+  {
+    Log::error("Error ram mapping: %zu bytes", bytes);
+    std::exit(EXIT_FAILURE);
+  }
+
+  ram = static_cast<uint32_t *>(map);
+  Log::info("Sparse ram: %u words%s%s", words, backing_path ? " backed by " : "",
+            backing_path ? backing_path : "");
+}
+
+SparseRam::~SparseRam()
+{
+  munmap(ram, bytes);
+}
+
+void SparseRam::dump_pages(const char *path) const
+{
+  FILE *file = fopen(path, "w");
+
+  if (!file)
+  {
+    Log::error("Error file opening: %s", path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  // Only the pages the OS has allocated can hold anything but zeros
+  size_t pages = bytes / PAGE_SIZE;
+  std::vector<unsigned char> resident(pages);
+
+  if (mincore(ram, bytes, resident.data()) < 0)
+  {
+    std::fill(resident.begin(), resident.end(), 1);
+  }
+
+  constexpr uint32_t PAGE_WORDS = PAGE_SIZE / 4;
+  std::string out;
+  char buff[32];
+  size_t written = 0;
+
+  for (size_t page = 0; page < pages; page++)
+  {
+    const uint32_t *first = ram + page * PAGE_WORDS;
+    const uint32_t *last = first + std::min<size_t>(PAGE_WORDS, words - page * PAGE_WORDS);
+
+    if (not(resident[page] & 1) or std::all_of(first, last, [](uint32_t v) { return v == 0; }))
+    {
+      continue;
+    }
+
+    snprintf(buff, sizeof(buff), "@%08zx\n", page * PAGE_WORDS);
+    out += buff;
+
+    for (const uint32_t *p = first; p < last; p++)
+    {
+      snprintf(buff, sizeof(buff), "%08" PRIx32 "\n", *p);
+      out += buff;
+    }
+
+    written++;
+  }
+
+  fwrite(out.data(), 1, out.size(), file);
+  fclose(file);
+
+  Log::info("Ok dump ram pages: %zu of %zu", written, pages);
+}
+
+// DPI-C imports of rvsteel_ram.v. A chandle is a void * on the C side.
+extern "C" void *rvsteel_ram_open(int words)
+{
+  return new SparseRam(words);
+}
+
+extern "C" void rvsteel_ram_close(void *ram)
+{
+  delete static_cast<SparseRam *>(ram);
+}
+
+extern "C" int rvsteel_ram_read(void *ram, int address)
+{
+  return static_cast<SparseRam *>(ram)->read(address);
+}
+
+extern "C" void rvsteel_ram_write(void *ram, int address, int data, int strobe)
+{
+  static_cast<SparseRam *>(ram)->write(address, data, strobe);
+}
@@ -1,155 +1,474 @@
-// ----------------------------------------------------------------------------
-// Copyright (c) 2020-2024 RISC-V Steel contributors
-//
-// This work is licensed under the MIT License, see LICENSE file for details.
-// SPDX-License-Identifier: MIT
-// ----------------------------------------------------------------------------
-
-#include "argparse.h"
-
-#include <stdlib.h>
-#include <iostream>
-#include <getopt.h>
-#include <string.h>
-
-#include "log.h"
-
-const char *help_str =
-    "Use: app_name.run [options]\n"
-    "Options:\n"
-    "--out-wave=<name>      Output file *.fst (defaul: none - off)\n\n"
-    "--ram-init-h32=<name>  Input init ram file in h32 format (defaul: none - off)\n"
-    "                       Example: --ram-init-h32=my_program.hex\n\n"
-    "--ram-init-bin=<name>  Input init ram file in bin format (defaul: none)\n"
-    "                       Example: --ram-init-bin=my_program.bin\n\n"
-
-    "The end of the program is:\n"
-    "--cycles=<num>         Exit after processor cycles complete (default: 500000)\n"
-    "                       Example: --cycles=10000\n\n"
-    //    "--ecall            Exit if there is an instruction ecall\n"
-
-    "--host-out=<addr>      Message output detection address (default: 0x00000000 - off)\n"
-    "                       Example: --host-out=0x00000000\n"
-    "Note:                  Must not be 0x0\n\n"
-
-    "--quiet                Use --quiet to disable messages (default: messages enable)\n"
-    "                       Example: --quiet (equivalent: --log-level=QUIET)\n"
-
-    "--log-out              Output file log (default: none)\n"
-    "                       Example: --log-out=my_log.txt\n"
-
-    "--log-level            Log level (default: DEBUG)\n"
-    "                       Example: --log-level=DEBUG\n"
-    "Note:                  Available: DEBUG, INFO, WARNING, ERROR, CRITICAL, QUIET\n\n"
-
-    "--freq-ns=<name>       Clock frequency, set in (ns) (defaul: 10ns)\n"
-    "Note:                  Min 2ns, Max 2^32ns\n\n"
-
-    "\n\n"
-    "Example:\n"
-    "unit_tests --ram-init-bin=add-01.bin"
-    "unit_tests --out-wave=wave.fst --ram-init-bin=add-01.bin"
-    "unit_tests --ram-init-bin=add-01.bin --host-out=0x4"
-    "unit_tests --quiet --ram-init-bin=add-01.bin"
-    ;
-
-enum opts
-{
-  cmd_help = 0,
-
-  cmd_out_wave,
-  cmd_ram_init_h32,
-  cmd_ram_init_bin,
-  cmd_cycles,
-  cmd_host_out,
-  cmd_quiet,
-  cmd_log_out,
-  cmd_log_level,
-  cmd_freq_ns,
-};
-
-static constexpr option long_opts[] =
-    {
-        {"help", no_argument, NULL, opts::cmd_help},
-        {"out-wave", required_argument, NULL, opts::cmd_out_wave},
-        {"ram-init-h32", required_argument, NULL, opts::cmd_ram_init_h32},
-        {"ram-init-bin", required_argument, NULL, opts::cmd_ram_init_bin},
-        {"cycles", required_argument, NULL, opts::cmd_cycles},
-        {"host-out", required_argument, NULL, opts::cmd_host_out},
-        {"quiet", no_argument, NULL, opts::cmd_quiet},
-        {"log-out", required_argument, NULL, opts::cmd_log_out},
-        {"log-level", required_argument, NULL, opts::cmd_log_level},
-        {"freq-ns", required_argument, NULL, opts::cmd_freq_ns},
-        {NULL, no_argument, NULL, 0}};
-
-static size_t get_int_arg(const char *arg)
-{
-  char *p;
-  return strtoull(arg, &p, 0);
-}
-
-Args parser(int argc, char *argv[])
-{
-  Args args;
-  int opt;
-
-  while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1)
-  {
-    switch (opt)
-    {
-    case opts::cmd_help:
-      std::cout << help_str;
-      std::exit(EXIT_SUCCESS);
-
-    case opts::cmd_out_wave:
-      args.out_wave_path = optarg;
-      Log::info("Wave out: %s", optarg);
-      break;
-
-    case opts::cmd_ram_init_h32:
-      args.ram_init_path = optarg;
-      args.ram_init_variants = RamInitVariants::H32;
-      Log::info("Input init ram h32 file: %s", optarg);
-      break;
-
-    case opts::cmd_ram_init_bin:
-      args.ram_init_path = optarg;
-      args.ram_init_variants = RamInitVariants::BIN;
-      Log::info("Input init ram bin file: %s", optarg);
-      break;
-
-    case opts::cmd_cycles:
-      args.max_cycles = get_int_arg(optarg);
-      Log::info("Max cycles: %u", args.max_cycles);
-      break;
-
-    case opts::cmd_host_out:
-      args.host_out = get_int_arg(optarg);
-      Log::info("Host out: 0x%x", args.host_out);
-      break;
-
-    case opts::cmd_quiet:
-      Log::set_level(Log::QUIET);
-      break;
-
-    case opts::cmd_log_out:
-      Log::set_out(optarg);
-      break;
-
-    case opts::cmd_log_level:
-      Log::set_level(optarg);
-      break;
-
-    case opts::cmd_freq_ns:
-      args.freq = get_int_arg(optarg);
-      Log::info("Clock frequency: %u(ns)", args.freq);
-      break;
-
-    default:
-      Log::info("Please call for help: --help\n");
-      std::exit(EXIT_SUCCESS);
-    }
-  }
-
-  return args;
-}
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "argparse.h"
+
+#include <stdlib.h>
+#include <iostream>
+#include <getopt.h>
+#include <cinttypes>
+#include <string.h>
+
+#include "log.h"
+
+const char *help_str =
+    "Use: app_name.run [options]\n"
+    "Options:\n"
+    "--out-wave=<name>      Output file *.fst (defaul: none - off)\n\n"
+    "--trace-start=<num>    Start tracing at the given cycle (default: 0)\n"
+    "--trace-stop=<num>     Stop tracing at the given cycle (default: 0 - until exit)\n"
+    "--trace-cycles=<num>   Number of cycles to trace once tracing starts (default: 0 - until exit)\n"
+    "--trace-pc=<addr>      Start tracing when the program counter reaches <addr>\n"
+    "--trace-addr=<addr>    Start tracing on the first write to <addr>\n"
+    "--trace-scope=<name>   Trace only the given hierarchy (default: none - all)\n"
+    "                       Example: --trace-scope=TOP.mcu_sim.rvsteel_instance.rvsteel_core_instance\n"
+    "Note:                  --trace-* options only take effect with --out-wave\n\n"
+    "--wave-on-failure=<num>\n"
+    "                       Keep the last <num> cycles in memory and write them as FST only\n"
+    "                       if the run fails: end cycles, trap or SIGINT\n"
+    "                       Example: --wave-on-failure=10000\n"
+    "--wave-on-failure-out=<name>\n"
+    "                       Output file of --wave-on-failure (default: failure.fst)\n\n"
+    "--ram-init-h32=<name>  Input init ram file in h32 format (defaul: none - off)\n"
+    "                       Example: --ram-init-h32=my_program.hex\n\n"
+    "--ram-init-bin=<name>  Input init ram file in bin format (defaul: none)\n"
+    "                       Example: --ram-init-bin=my_program.bin\n\n"
+    "--ram-init-elf=<name>  Input init ram file in ELF format (defaul: none)\n"
+    "                       Example: --ram-init-elf=my_program.elf\n"
+    "Note:                  The tohost, begin_signature and end_signature symbols are used\n"
+    "                       when present\n\n"
+    "--host-out-symbol=<name>\n"
+    "                       Use the address of ELF symbol <name> as --host-out\n"
+    "                       Example: --host-out-symbol=console\n\n"
+    "--ram-file=<name>      Map the RAM onto file <name>, created if missing (default: none)\n"
+    "--ram-dump-pages=<name>\n"
+    "                       At exit, write the touched RAM pages in h32 format with @addresses\n"
+    "Note:                  Only in builds with the sparse RAM (RVSTEEL_RAM_DPI)\n\n"
+
+    "The end of the program is:\n"
+    "--cycles=<num>         Exit after processor cycles complete (default: 500000)\n"
+    "                       Example: --cycles=10000\n\n"
+    //    "--ecall            Exit if there is an instruction ecall\n"
+
+    "--host-out=<addr>      Message output detection address (default: 0x00000000 - off)\n"
+    "                       Example: --host-out=0x00000000\n"
+    "Note:                  Must not be 0x0\n\n"
+    "--semihosting          Service the RISC-V semihosting calls (slli x0; ebreak; srai x0) on\n"
+    "                       the host: SYS_OPEN, SYS_CLOSE, SYS_READ, SYS_WRITE, SYS_WRITEC,\n"
+    "                       SYS_WRITE0, SYS_CLOCK, SYS_EXIT and SYS_EXIT_EXTENDED. The ebreak\n"
+    "                       retires as a nop, the call itself takes no cycles. SYS_EXIT ends\n"
+    "                       the run with the exit code of the program\n\n"
+
+    "--quiet                Use --quiet to disable messages (default: messages enable)\n"
+    "                       Example: --quiet (equivalent: --log-level=QUIET)\n"
+
+    "--log-out              Output file log (default: none)\n"
+    "                       Example: --log-out=my_log.txt\n"
+
+    "--log-level            Log level (default: DEBUG)\n"
+    "                       Example: --log-level=DEBUG\n"
+    "Note:                  Available: DEBUG, INFO, WARNING, ERROR, CRITICAL, QUIET\n\n"
+
+    "--freq-ns=<name>       Clock frequency, set in (ns) (defaul: 10ns)\n"
+    "Note:                  Min 2ns, Max 2^32ns\n\n"
+
+    "--save-checkpoint=<name>@<num>\n"
+    "                       Save the model state to <name> when cycle <num> is reached\n"
+    "                       Example: --save-checkpoint=boot.ckpt@3000000\n"
+    "--restore-checkpoint=<name>\n"
+    "                       Start from the model state saved in <name> instead of reset\n"
+    "                       Example: --restore-checkpoint=boot.ckpt\n"
+    "Note:                  The checkpoint is only valid for the same mcu_sim build and --freq-ns\n"
+    "                       --ram-init-* are ignored when restoring\n\n"
+
+    "--snapshot-every=<num> Keep an in-memory snapshot every <num> cycles (default: 0 - off)\n"
+    "--snapshot-mem=<num>   Memory budget of the snapshots in MB (default: 1024)\n"
+    "                       When exceeded, every other snapshot is dropped\n"
+    "--replay-from=<num>    At exit, restore the nearest snapshot before cycle <num> and\n"
+    "                       write --out-wave from <num> to the exit cycle only\n"
+    "                       Not with --semihosting\n"
+    "                       Example: --snapshot-every=1000000 --replay-from=39900000\n\n"
+
+    "--uart-fast            Print UART output at once and report the UART ready on the next\n"
+    "                       cycle, and feed stdin to the UART receiver byte by byte\n"
+    "                       Example: --uart-fast < input.txt\n\n"
+
+    "--fast-forward         Jump over idle loops up to the next timer interrupt, the end of\n"
+    "                       the run, a checkpoint or a snapshot, advancing mtime, mcycle and\n"
+    "                       minstret as if the loop had run. Only while not tracing\n\n"
+
+    "--profile=<name>       Write a flat profile of the cycles per function to <name> and the\n"
+    "                       call stacks to <name>.folded, for flamegraph.pl or speedscope.\n"
+    "                       Function names come from --ram-init-elf\n"
+    "                       Example: --profile=app.prof\n\n"
+    "--cpi-stack=<name>     Count every cycle as retired, load wait, store wait, flush, trap,\n"
+    "                       halted or bus wait, log the CPI of each at exit and write them,\n"
+    "                       in total and per --ram-init-elf function, to <name>\n"
+    "                       Example: --cpi-stack=app.cpi\n\n"
+    "--commit-log=<name>    Write every retired instruction (pc, instruction, rd write, memory\n"
+    "                       access) and trap to <name> in a compact binary format. Print it\n"
+    "                       as spike --log-commits text with: commit_log_decode <name>\n"
+    "                       Example: --commit-log=app.commits\n\n"
+    "--lockstep             Check every retired instruction and trap against a built-in\n"
+    "                       RV32I/Zicsr model of the core and stop at the first difference\n"
+    "Note:                  Peripheral loads, interrupts and counters come from the RTL.\n"
+    "                       Not available with --restore-checkpoint\n\n"
+    "--stats=<name>         Write a JSON summary of the run to <name> at exit: exit reason,\n"
+    "                       wall time, startup time, simulated cycles, host kHz, mcycle,\n"
+    "                       minstret, CPI, host-out bytes, peak RSS and traps by mcause\n"
+    "                       Example: --stats=app.json\n\n"
+    "--functional           Run the program on a built-in instruction set simulator with\n"
+    "                       models of the peripherals instead of the RTL, one cycle per\n"
+    "                       instruction. The UART behaves as with --uart-fast\n"
+    "Note:                  Not available with --out-wave, --wave-on-failure, checkpoints,\n"
+    "                       snapshots, --fast-forward, --profile, --cpi-stack, --commit-log,\n"
+    "                       --lockstep, --ram-file and --ram-dump-pages\n\n"
+    "--sample-every=<num>   With --functional, stop every <num> instructions, load the state\n"
+    "                       into the RTL and run it for --sample-window instructions, then\n"
+    "                       go on functionally. Log the CPI of each window and, at exit, the\n"
+    "                       cycles of the whole run estimated from them\n"
+    "--sample-start=<num>   First sample point (default: --sample-every)\n"
+    "--sample-window=<num>  Instructions run on the RTL per sample (default: 100000)\n"
+    "                       Example: --functional --cycles=0 --sample-every=100000000\n"
+    "Note:                  The output of the RTL in the windows is discarded\n\n"
+
+    "\n\n"
+    "Example:\n"
+    "unit_tests --ram-init-bin=add-01.bin"
+    "unit_tests --out-wave=wave.fst --ram-init-bin=add-01.bin"
+    "unit_tests --ram-init-bin=add-01.bin --host-out=0x4"
+    "unit_tests --quiet --ram-init-bin=add-01.bin"
+    ;
+
+enum opts
+{
+  cmd_help = 0,
+
+  cmd_out_wave,
+  cmd_trace_start,
+  cmd_trace_stop,
+  cmd_trace_cycles,
+  cmd_trace_pc,
+  cmd_trace_addr,
+  cmd_trace_scope,
+  cmd_wave_on_failure,
+  cmd_wave_on_failure_out,
+  cmd_ram_init_h32,
+  cmd_ram_init_bin,
+  cmd_ram_init_elf,
+  cmd_host_out_symbol,
+  cmd_ram_file,
+  cmd_ram_dump_pages,
+  cmd_cycles,
+  cmd_host_out,
+  cmd_semihosting,
+  cmd_quiet,
+  cmd_log_out,
+  cmd_log_level,
+  cmd_freq_ns,
+  cmd_save_checkpoint,
+  cmd_restore_checkpoint,
+  cmd_snapshot_every,
+  cmd_snapshot_mem,
+  cmd_replay_from,
+  cmd_uart_fast,
+  cmd_fast_forward,
+  cmd_profile,
+  cmd_cpi_stack,
+  cmd_commit_log,
+  cmd_lockstep,
+  cmd_stats,
+  cmd_functional,
+  cmd_sample_start,
+  cmd_sample_every,
+  cmd_sample_window,
+};
+
+static constexpr option long_opts[] =
+    {
+        {"help", no_argument, NULL, opts::cmd_help},
+        {"out-wave", required_argument, NULL, opts::cmd_out_wave},
+        {"trace-start", required_argument, NULL, opts::cmd_trace_start},
+        {"trace-stop", required_argument, NULL, opts::cmd_trace_stop},
+        {"trace-cycles", required_argument, NULL, opts::cmd_trace_cycles},
+        {"trace-pc", required_argument, NULL, opts::cmd_trace_pc},
+        {"trace-addr", required_argument, NULL, opts::cmd_trace_addr},
+        {"trace-scope", required_argument, NULL, opts::cmd_trace_scope},
+        {"wave-on-failure", required_argument, NULL, opts::cmd_wave_on_failure},
+        {"wave-on-failure-out", required_argument, NULL, opts::cmd_wave_on_failure_out},
+        {"ram-init-h32", required_argument, NULL, opts::cmd_ram_init_h32},
+        {"ram-init-bin", required_argument, NULL, opts::cmd_ram_init_bin},
+        {"ram-init-elf", required_argument, NULL, opts::cmd_ram_init_elf},
+        {"host-out-symbol", required_argument, NULL, opts::cmd_host_out_symbol},
+        {"ram-file", required_argument, NULL, opts::cmd_ram_file},
+        {"ram-dump-pages", required_argument, NULL, opts::cmd_ram_dump_pages},
+        {"cycles", required_argument, NULL, opts::cmd_cycles},
+        {"host-out", required_argument, NULL, opts::cmd_host_out},
+        {"semihosting", no_argument, NULL, opts::cmd_semihosting},
+        {"quiet", no_argument, NULL, opts::cmd_quiet},
+        {"log-out", required_argument, NULL, opts::cmd_log_out},
+        {"log-level", required_argument, NULL, opts::cmd_log_level},
+        {"freq-ns", required_argument, NULL, opts::cmd_freq_ns},
+        {"save-checkpoint", required_argument, NULL, opts::cmd_save_checkpoint},
+        {"restore-checkpoint", required_argument, NULL, opts::cmd_restore_checkpoint},
+        {"snapshot-every", required_argument, NULL, opts::cmd_snapshot_every},
+        {"snapshot-mem", required_argument, NULL, opts::cmd_snapshot_mem},
+        {"replay-from", required_argument, NULL, opts::cmd_replay_from},
+        {"uart-fast", no_argument, NULL, opts::cmd_uart_fast},
+        {"fast-forward", no_argument, NULL, opts::cmd_fast_forward},
+        {"profile", required_argument, NULL, opts::cmd_profile},
+        {"cpi-stack", required_argument, NULL, opts::cmd_cpi_stack},
+        {"commit-log", required_argument, NULL, opts::cmd_commit_log},
+        {"lockstep", no_argument, NULL, opts::cmd_lockstep},
+        {"stats", required_argument, NULL, opts::cmd_stats},
+        {"functional", no_argument, NULL, opts::cmd_functional},
+        {"sample-start", required_argument, NULL, opts::cmd_sample_start},
+        {"sample-every", required_argument, NULL, opts::cmd_sample_every},
+        {"sample-window", required_argument, NULL, opts::cmd_sample_window},
+        {NULL, no_argument, NULL, 0}};
+
+static size_t get_int_arg(const char *arg)
+{
+  char *p;
+  return strtoull(arg, &p, 0);
+}
+
+Args parser(int argc, char *argv[])
+{
+  Args args;
+  int opt;
+
+  while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case opts::cmd_help:
+      std::cout << help_str;
+      std::exit(EXIT_SUCCESS);
+
+    case opts::cmd_out_wave:
+      args.out_wave_path = optarg;
+      Log::info("Wave out: %s", optarg);
+      break;
+
+    case opts::cmd_trace_start:
+      args.trace_start = get_int_arg(optarg);
+      Log::info("Trace start: %" PRIu64, args.trace_start);
+      break;
+
+    case opts::cmd_trace_stop:
+      args.trace_stop = get_int_arg(optarg);
+      Log::info("Trace stop: %" PRIu64, args.trace_stop);
+      break;
+
+    case opts::cmd_trace_cycles:
+      args.trace_cycles = get_int_arg(optarg);
+      Log::info("Trace cycles: %" PRIu64, args.trace_cycles);
+      break;
+
+    case opts::cmd_trace_pc:
+      args.trace_pc = get_int_arg(optarg);
+      args.trace_pc_enable = true;
+      Log::info("Trace pc: 0x%x", args.trace_pc);
+      break;
+
+    case opts::cmd_trace_addr:
+      args.trace_addr = get_int_arg(optarg);
+      args.trace_addr_enable = true;
+      Log::info("Trace address: 0x%x", args.trace_addr);
+      break;
+
+    case opts::cmd_trace_scope:
+      args.trace_scope = optarg;
+      Log::info("Trace scope: %s", optarg);
+      break;
+
+    case opts::cmd_wave_on_failure:
+      args.wave_on_failure = get_int_arg(optarg);
+      Log::info("Wave on failure: %u cycles", args.wave_on_failure);
+      break;
+
+    case opts::cmd_wave_on_failure_out:
+      args.wave_on_failure_path = optarg;
+      Log::info("Wave on failure out: %s", optarg);
+      break;
+
+    case opts::cmd_ram_init_h32:
+      args.ram_init_path = optarg;
+      args.ram_init_variants = RamInitVariants::H32;
+      Log::info("Input init ram h32 file: %s", optarg);
+      break;
+
+    case opts::cmd_ram_init_bin:
+      args.ram_init_path = optarg;
+      args.ram_init_variants = RamInitVariants::BIN;
+      Log::info("Input init ram bin file: %s", optarg);
+      break;
+
+    case opts::cmd_ram_init_elf:
+      args.ram_init_path = optarg;
+      args.ram_init_variants = RamInitVariants::ELF;
+      Log::info("Input init ram elf file: %s", optarg);
+      break;
+
+    case opts::cmd_host_out_symbol:
+      args.host_out_symbol = optarg;
+      Log::info("Host out symbol: %s", optarg);
+      break;
+
+    case opts::cmd_ram_file:
+      args.ram_file_path = optarg;
+      Log::info("Ram file: %s", optarg);
+      break;
+
+    case opts::cmd_ram_dump_pages:
+      args.ram_dump_pages = optarg;
+      Log::info("Output dump ram pages file: %s", optarg);
+      break;
+
+    case opts::cmd_cycles:
+      args.max_cycles = get_int_arg(optarg);
+      Log::info("Max cycles: %u", args.max_cycles);
+      break;
+
+    case opts::cmd_host_out:
+      args.host_out = get_int_arg(optarg);
+      Log::info("Host out: 0x%x", args.host_out);
+      break;
+
+    case opts::cmd_semihosting:
+      args.semihosting = true;
+      Log::info("Semihosting");
+      break;
+
+    case opts::cmd_quiet:
+      Log::set_level(Log::QUIET);
+      break;
+
+    case opts::cmd_log_out:
+      Log::set_out(optarg);
+      break;
+
+    case opts::cmd_log_level:
+      Log::set_level(optarg);
+      break;
+
+    case opts::cmd_freq_ns:
+      args.freq = get_int_arg(optarg);
+
+      // A clock period under 2ns has no half cycle to advance the time by
+      if (args.freq < 2)
+      {
+        Log::error("--freq-ns must be at least 2: %s", optarg);
+        std::exit(EXIT_FAILURE);
+      }
+
+      Log::info("Clock frequency: %u(ns)", args.freq);
+      break;
+
+    case opts::cmd_save_checkpoint:
+    {
+      // <name>@<num>
+      char *at = strrchr(optarg, '@');
+
+      if (not at)
+      {
+        Log::error("Expected <name>@<num>: %s", optarg);
+        std::exit(EXIT_FAILURE);
+      }
+
+      *at = '\0';
+      args.save_checkpoint_path = optarg;
+      args.save_checkpoint_cycle = get_int_arg(at + 1);
+      Log::info("Save checkpoint: %s at cycle %" PRIu64, optarg, args.save_checkpoint_cycle);
+      break;
+    }
+
+    case opts::cmd_restore_checkpoint:
+      args.restore_checkpoint_path = optarg;
+      Log::info("Restore checkpoint: %s", optarg);
+      break;
+
+    case opts::cmd_snapshot_every:
+      args.snapshot_every = get_int_arg(optarg);
+      Log::info("Snapshot every: %" PRIu64 " cycles", args.snapshot_every);
+      break;
+
+    case opts::cmd_snapshot_mem:
+      args.snapshot_mem = get_int_arg(optarg);
+      Log::info("Snapshot memory: %u MB", args.snapshot_mem);
+      break;
+
+    case opts::cmd_replay_from:
+      args.replay_from = get_int_arg(optarg);
+      args.replay_enable = true;
+      Log::info("Replay from: cycle %" PRIu64, args.replay_from);
+      break;
+
+    case opts::cmd_uart_fast:
+      args.uart_fast = true;
+      Log::info("UART fast-forward");
+      break;
+
+    case opts::cmd_fast_forward:
+      args.fast_forward = true;
+      Log::info("Idle loop fast-forward");
+      break;
+
+    case opts::cmd_profile:
+      args.profile_path = optarg;
+      Log::info("Profile: %s", optarg);
+      break;
+
+    case opts::cmd_cpi_stack:
+      args.cpi_stack_path = optarg;
+      Log::info("CPI stack: %s", optarg);
+      break;
+
+    case opts::cmd_commit_log:
+      args.commit_log_path = optarg;
+      Log::info("Commit log: %s", optarg);
+      break;
+
+    case opts::cmd_lockstep:
+      args.lockstep = true;
+      Log::info("Lockstep with the golden model");
+      break;
+
+    case opts::cmd_stats:
+      args.stats_path = optarg;
+      Log::info("Stats: %s", optarg);
+      break;
+
+    case opts::cmd_functional:
+      args.functional = true;
+      Log::info("Functional simulation");
+      break;
+
+    case opts::cmd_sample_start:
+      args.sample_start = get_int_arg(optarg);
+      Log::info("Sample start: %" PRIu64 " instructions", args.sample_start);
+      break;
+
+    case opts::cmd_sample_every:
+      args.sample_every = get_int_arg(optarg);
+      Log::info("Sample every: %" PRIu64 " instructions", args.sample_every);
+      break;
+
+    case opts::cmd_sample_window:
+      args.sample_window = get_int_arg(optarg);
+      Log::info("Sample window: %" PRIu64 " instructions", args.sample_window);
+      break;
+
+    default:
+      Log::info("Please call for help: --help\n");
+      std::exit(EXIT_SUCCESS);
+    }
+  }
+
+  return args;
+}
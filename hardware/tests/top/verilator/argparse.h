@@ -1,33 +1,66 @@
-// ----------------------------------------------------------------------------
-// Copyright (c) 2020-2024 RISC-V Steel contributors
-//
-// This work is licensed under the MIT License, see LICENSE file for details.
-// SPDX-License-Identifier: MIT
-// ----------------------------------------------------------------------------
-
-#ifndef ARGPARSE_H
-#define ARGPARSE_H
-
-#include <cstdint>
-#include <cstddef>
-
-enum RamInitVariants
-{
-  NONE,
-  H32,
-  BIN,
-};
-
-struct Args
-{
-  char *out_wave_path{nullptr};
-  char *ram_init_path{nullptr};
-  RamInitVariants ram_init_variants{NONE};
-  uint32_t max_cycles{500000};
-  uint32_t host_out{0x00000000};
-  uint32_t freq{100};
-};
-
-Args parser(int argc, char *argv[]);
-
-#endif // ARGPARSE_H
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef ARGPARSE_H
+#define ARGPARSE_H
+
+#include <cstdint>
+#include <cstddef>
+
+enum RamInitVariants
+{
+  NONE,
+  H32,
+  BIN,
+  ELF,
+};
+
+struct Args
+{
+  char *out_wave_path{nullptr};
+  char *ram_init_path{nullptr};
+  RamInitVariants ram_init_variants{NONE};
+  char *host_out_symbol{nullptr};
+  char *ram_file_path{nullptr};
+  char *ram_dump_pages{nullptr};
+  uint32_t max_cycles{500000};
+  uint32_t host_out{0x00000000};
+  bool semihosting{false};
+  char *trace_scope{nullptr};
+  uint64_t trace_start{0};
+  uint64_t trace_stop{0};
+  uint64_t trace_cycles{0};
+  bool trace_pc_enable{false};
+  uint32_t trace_pc{0x00000000};
+  bool trace_addr_enable{false};
+  uint32_t trace_addr{0x00000000};
+  uint32_t wave_on_failure{0};
+  const char *wave_on_failure_path{"failure.fst"};
+  uint32_t freq{100};
+  char *save_checkpoint_path{nullptr};
+  uint64_t save_checkpoint_cycle{0};
+  char *restore_checkpoint_path{nullptr};
+  uint64_t snapshot_every{0};
+  uint32_t snapshot_mem{1024};
+  bool replay_enable{false};
+  uint64_t replay_from{0};
+  bool uart_fast{false};
+  bool fast_forward{false};
+  char *profile_path{nullptr};
+  char *cpi_stack_path{nullptr};
+  char *commit_log_path{nullptr};
+  bool lockstep{false};
+  char *stats_path{nullptr};
+  bool functional{false};
+  uint64_t sample_start{0};
+  uint64_t sample_every{0};
+  uint64_t sample_window{100000};
+};
+
+Args parser(int argc, char *argv[]);
+
+#endif // ARGPARSE_H
@@ -0,0 +1,226 @@
+"""Measure the host speed of mcu_sim on a fixed set of programs, with tracing
+off and on, and fail when it drops below the baseline of the host, checked in
+under bench_baselines/."""
+
+import os
+import sys
+import json
+import argparse
+import platform
+import subprocess
+import tempfile
+from pathlib import Path
+
+
+class scolor:
+    NORMAL  = '\033[0m'
+    PASS    = '\033[32m'
+    SKIP    = '\033[33m'
+    FAIL    = '\033[31m'
+
+
+# Relative to this script, built by 'make' in benchmarks/
+workloads = [
+    ["coremark",    "../../../../benchmarks/build/coremark.elf",    ],
+    ["dhrystone",   "../../../../benchmarks/build/dhrystone.elf",   ],
+    ["kernels",     "../../../../benchmarks/build/kernels.elf",     ],
+    ["freertos",    "../../../../benchmarks/build/freertos.elf",    ],
+]
+
+trace_modes = ["off", "on"]
+
+# The speed depends on the host, each one has its own baseline
+default_baseline = f'bench_baselines/{platform.node().split(".")[0]}.json'
+
+
+def print_status(clr: scolor, text: str):
+    if clr == scolor.NORMAL:
+        print(f'{clr}{text}')
+
+    if clr == scolor.PASS:
+        print(f'{scolor.NORMAL}BENCH {clr}PASS {scolor.NORMAL}: {text}')
+
+    if clr == scolor.SKIP:
+        print(f'{scolor.NORMAL}BENCH {clr}NEW  {scolor.NORMAL}: {text}')
+
+    if clr == scolor.FAIL:
+        print(f'{scolor.NORMAL}BENCH {clr}FAIL {scolor.NORMAL}: {text}')
+
+
+def check_file(path: str):
+    if not os.path.isfile(path):
+        print_status(scolor.NORMAL, f'No such file or directory: {path}')
+        return False
+    return True
+
+
+def run_sim(sim_path: str, elf_path: str, trace: str, cycles: int, dump_dir: str):
+    # The reports of --stats: host_khz, startup_s and peak_rss_kb
+    stats_path = f'{dump_dir}/{Path(elf_path).stem}-trace-{trace}.json'
+    args = [f'{sim_path}',
+            f'--ram-init-elf={elf_path}',
+            f'--cycles={cycles}',
+            '--log-level=QUIET',
+            f'--stats={stats_path}']
+
+    if trace == 'on':
+        args.append(f'--out-wave={dump_dir}/{Path(elf_path).stem}.fst')
+
+    proc = subprocess.run(args, stdout=subprocess.DEVNULL)
+
+    if proc.returncode != 0 or not os.path.isfile(stats_path):
+        return None
+
+    with open(stats_path) as fd:
+        return json.load(fd)
+
+
+def measure(sim_path: str, elf_path: str, trace: str, cycles: int, repeat: int, dump_dir: str):
+    # The fastest of the runs, the others are slowed down by the rest of the host
+    best = None
+
+    for _ in range(repeat):
+        stats = run_sim(sim_path, elf_path, trace, cycles, dump_dir)
+
+        if stats is None:
+            return None
+
+        if best is None or stats['host_khz'] > best['host_khz']:
+            best = stats
+
+    return {key: best[key] for key in ('host_khz', 'startup_s', 'peak_rss_kb',
+                                       'simulated_cycles', 'wall_time_s')}
+
+
+def main(argv=None):
+    if argv is None:
+        argv = sys.argv[1:]
+
+    os.chdir(Path(__file__).resolve().parent)
+
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+
+    parser.add_argument('--sim',
+                        type=str,
+                        default='build/mcu_sim',
+                        help='Path to the simulator')
+
+    parser.add_argument('--cycles',
+                        type=int,
+                        default=2000000,
+                        help='Cycles simulated per program with tracing off')
+
+    parser.add_argument('--trace-cycles',
+                        type=int,
+                        default=200000,
+                        help='Cycles simulated per program with tracing on')
+
+    parser.add_argument('--repeat',
+                        type=int,
+                        default=3,
+                        help='Runs per program, the fastest one is kept')
+
+    parser.add_argument('--max-slowdown',
+                        type=float,
+                        default=10.0,
+                        help='Fail when the host cycles/s drop by more than this percentage')
+
+    parser.add_argument('--baseline',
+                        type=str,
+                        default=os.environ.get('BENCH_BASELINE', default_baseline),
+                        help='Baseline to compare with, from BENCH_BASELINE when set')
+
+    parser.add_argument('--update-baseline',
+                        action='store_true',
+                        help='Write the baseline from the results of this run instead of comparing')
+
+    parser.add_argument('--out',
+                        type=str,
+                        default='build/bench.json',
+                        help='Results of this run')
+
+    args = parser.parse_args(argv)
+
+    if not check_file(args.sim):
+        print_status(scolor.NORMAL, f'Please build file: {args.sim}')
+        return 1
+
+    for name, elf_path in workloads:
+        if not check_file(elf_path):
+            print_status(scolor.NORMAL, 'Please build the benchmarks: make -C ../../../../benchmarks')
+            return 1
+
+    baseline = {}
+
+    if not args.update_baseline:
+        if not check_file(args.baseline):
+            print_status(scolor.NORMAL, 'Please write the baseline of this host with --update-baseline')
+            return 1
+
+        with open(args.baseline) as fd:
+            baseline = json.load(fd)
+
+    results = {}
+    failed = 0
+
+    print_status(scolor.NORMAL, f'{"program":<24} {"kHz":>10} {"baseline":>10} {"change":>8} '
+                                f'{"startup s":>10} {"RSS MB":>8}')
+
+    with tempfile.TemporaryDirectory() as dump_dir:
+        for name, elf_path in workloads:
+            for trace in trace_modes:
+                key = f'{name}/trace-{trace}'
+                cycles = args.trace_cycles if trace == 'on' else args.cycles
+                result = measure(args.sim, elf_path, trace, cycles, args.repeat, dump_dir)
+
+                if result is None:
+                    failed += 1
+                    print_status(scolor.FAIL, f'{key}: the simulator did not exit cleanly')
+                    continue
+
+                results[key] = result
+                line = f'{key:<24} {result["host_khz"]:>10.1f}'
+
+                if key in baseline:
+                    base_khz = baseline[key]['host_khz']
+                    change = (result['host_khz'] / base_khz - 1) * 100
+                    line += f' {base_khz:>10.1f} {change:>+7.1f}%'
+                else:
+                    line += f' {"-":>10} {"-":>8}'
+
+                line += f' {result["startup_s"]:>10.3f} {result["peak_rss_kb"] / 1024:>8.1f}'
+
+                if args.update_baseline:
+                    print_status(scolor.SKIP, line)
+                elif key not in baseline:
+                    # A program without a baseline would never be checked
+                    failed += 1
+                    print_status(scolor.FAIL, line)
+                elif change < -args.max_slowdown:
+                    failed += 1
+                    print_status(scolor.FAIL, line)
+                else:
+                    print_status(scolor.PASS, line)
+
+    os.makedirs(Path(args.out).parent, exist_ok=True)
+
+    with open(args.out, 'w') as fd:
+        json.dump(results, fd, indent=2)
+
+    if args.update_baseline and not failed:
+        os.makedirs(Path(args.baseline).parent, exist_ok=True)
+
+        with open(args.baseline, 'w') as fd:
+            json.dump(results, fd, indent=2)
+
+        print_status(scolor.NORMAL, f'Baseline written: {args.baseline}')
+
+    print_status(scolor.NORMAL, f'Total: {len(results)} measured, failed {failed} '
+                                f'(max slowdown {args.max_slowdown}%)')
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
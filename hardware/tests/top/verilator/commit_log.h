@@ -0,0 +1,150 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef COMMIT_LOG_H
+#define COMMIT_LOG_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// One retired instruction, or one trap taken. A trap can come with the
+// register written by the instruction it replaces, see GoldenModel.
+struct CommitRecord
+{
+  bool trap{false};
+
+  // Instruction
+  uint32_t pc{0};
+  uint32_t instruction{0};
+  bool rd_write{false};
+  uint8_t rd{0};
+  uint32_t rd_value{0};
+  bool load{false};
+  bool store{false};
+  uint32_t address{0};
+  uint32_t store_value{0}; // Not shifted to the byte lanes
+
+  // Trap
+  uint32_t cause{0};
+  uint32_t epc{0};
+};
+
+// The record in the text format of spike --log-commits, without a newline
+std::string commit_to_string(const CommitRecord &record);
+
+// Binary commit log file. Each record is a tag byte followed by the fields
+// the tag announces:
+//
+//   PC_JUMP       pc, zigzag varint delta from the pc after the previous one
+//   INSTRUCTION   instruction word, 4 bytes, unless it is the last word seen
+//                 at this pc in a 1024-entry direct-mapped table
+//   RD_WRITE      rd byte, rd_value varint
+//   LOAD / STORE  address, zigzag varint delta from the previous address
+//   STORE         store_value varint
+//   TRAP          cause varint, epc varint, and with RD_WRITE the register
+//                 the trapped instruction still wrote, nothing else
+//
+// so a straight-line instruction that is already in the table is one byte.
+class CommitLogFormat
+{
+  public:
+    static constexpr char MAGIC[8] = {'R', 'V', 'S', 'T', 'C', 'L', '0', '1'};
+
+    static constexpr uint8_t TRAP = 0x01;
+    static constexpr uint8_t PC_JUMP = 0x02;
+    static constexpr uint8_t INSTRUCTION = 0x04;
+    static constexpr uint8_t RD_WRITE = 0x08;
+    static constexpr uint8_t LOAD = 0x10;
+    static constexpr uint8_t STORE = 0x20;
+
+    static constexpr size_t MAX_RECORD = 32; // Bytes
+    static constexpr size_t TABLE_SIZE = 1024;
+
+  protected:
+    uint32_t next_pc{0};
+    uint32_t prev_address{0};
+    uint32_t table_pc[TABLE_SIZE];
+    uint32_t table_instruction[TABLE_SIZE];
+
+    CommitLogFormat();
+
+    static uint32_t table_index(uint32_t pc)
+    {
+      return (pc >> 2) & (TABLE_SIZE - 1);
+    }
+};
+
+// Encodes the records into one of two buffers while a background thread
+// writes the other, so the simulation only waits when the disk falls behind
+class CommitLog : public CommitLogFormat
+{
+  public:
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+    ~CommitLog();
+
+    void open(const char *path);
+
+    bool is_open() const
+    {
+      return file != nullptr;
+    }
+
+    void write(const CommitRecord &record);
+
+    // Writes what is buffered and closes the file
+    void close();
+
+  private:
+    FILE *file{nullptr};
+    std::unique_ptr<uint8_t[]> buffers[2];
+    uint8_t *active{nullptr}; // Filled by the simulation
+    size_t used{0};
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    const uint8_t *pending{nullptr}; // Handed to the writer
+    size_t pending_size{0};
+    bool stop{false};
+    bool failed{false};
+
+    void swap();
+    void drain();
+};
+
+// Reads back the records of a commit log file
+class CommitLogReader : public CommitLogFormat
+{
+  public:
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+    ~CommitLogReader();
+
+    // Returns false when the file cannot be opened or is not a commit log
+    bool open(const char *path);
+
+    // Returns false at the end of the file. A truncated last record, e.g.
+    // from a killed run, also ends the file.
+    bool read(CommitRecord &record);
+
+  private:
+    FILE *file{nullptr};
+    std::unique_ptr<uint8_t[]> buffer{new uint8_t[BUFFER_SIZE]};
+    size_t pos{0};
+    size_t size{0};
+
+    void fill();
+};
+
+#endif // COMMIT_LOG_H
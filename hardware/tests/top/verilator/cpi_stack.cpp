@@ -0,0 +1,243 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "cpi_stack.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "log.h"
+
+// Values of current_state in rvsteel_core.v
+static constexpr uint8_t STATE_OPERATING = 0x2;
+static constexpr uint8_t STATE_TRAP_TAKEN = 0x4;
+static constexpr uint8_t STATE_TRAP_RETURN = 0x8;
+
+const char *CpiStack::category_name(Category category)
+{
+  switch (category)
+  {
+  case RETIRED: return "retired";
+  case LOAD_WAIT: return "load wait";
+  case STORE_WAIT: return "store wait";
+  case FLUSH: return "flush";
+  case TRAP: return "trap";
+  case HALTED: return "halted";
+  case BUS_WAIT: return "bus wait";
+  case SKIPPED: return "skipped";
+  default: return "unknown";
+  }
+}
+
+CpiStack::Category CpiStack::classify(const CoreCycle &cycle)
+{
+  if (cycle.halt)
+  {
+    return HALTED;
+  }
+
+  // clock_enable is low until the response of the last request comes
+  if (cycle.prev_read_request and not cycle.read_response)
+  {
+    return cycle.prev_load_request ? LOAD_WAIT : BUS_WAIT;
+  }
+
+  if (cycle.prev_write_request and not cycle.write_response)
+  {
+    return STORE_WAIT;
+  }
+
+  // A trap replaces the instruction of the cycle, which is fetched again
+  // after mret when the trap is an interrupt
+  if (cycle.state == STATE_TRAP_TAKEN or cycle.state == STATE_TRAP_RETURN or
+      (cycle.state == STATE_OPERATING and cycle.take_trap))
+  {
+    return TRAP;
+  }
+
+  if (cycle.state != STATE_OPERATING)
+  {
+    return FLUSH;
+  }
+
+  // A load or store takes a second cycle to commit, which is the one retired
+  if (cycle.load_pending)
+  {
+    return LOAD_WAIT;
+  }
+
+  if (cycle.store_pending)
+  {
+    return STORE_WAIT;
+  }
+
+  return RETIRED;
+}
+
+void CpiStack::start(const std::vector<ElfFunction> &functions)
+{
+  this->functions = functions;
+  per_function.assign(functions.size() + 1, Counters{});
+  skipped_instructions.assign(functions.size() + 1, 0);
+}
+
+// Index in functions, functions.size() when pc is in none. Also sets the
+// address range that maps to the same index.
+uint32_t CpiStack::function_of(uint32_t pc)
+{
+  auto it = std::upper_bound(functions.begin(), functions.end(), pc,
+                             [](uint32_t pc, const ElfFunction &f) { return pc < f.address; });
+
+  uint32_t next = it == functions.end() ? UINT32_MAX : it->address;
+
+  if (it == functions.begin())
+  {
+    range_start = 0;
+    range_end = next;
+    return functions.size();
+  }
+
+  const ElfFunction &f = *(it - 1);
+
+  // A label extends to the next symbol, the last one to its first word
+  uint32_t end = f.size ? f.address + f.size : next;
+
+  if (f.size == 0 and it == functions.end())
+  {
+    end = f.address + 4;
+  }
+
+  if (pc < end)
+  {
+    range_start = f.address;
+    range_end = end;
+    return it - 1 - functions.begin();
+  }
+
+  range_start = end;
+  range_end = next;
+  return functions.size();
+}
+
+void CpiStack::add_skipped(uint32_t pc, uint64_t cycles, uint64_t instructions)
+{
+  count(pc, SKIPPED, cycles);
+  skipped_instructions[range_function] += instructions;
+}
+
+void CpiStack::write(const char *path) const
+{
+  Counters total{};
+  uint64_t total_skipped_instructions = 0;
+
+  for (size_t f = 0; f < per_function.size(); f++)
+  {
+    for (size_t c = 0; c < CATEGORIES; c++)
+    {
+      total[c] += per_function[f][c];
+    }
+
+    total_skipped_instructions += skipped_instructions[f];
+  }
+
+  auto cycles_of = [](const Counters &counters)
+  {
+    uint64_t cycles = 0;
+
+    for (uint64_t count : counters)
+    {
+      cycles += count;
+    }
+
+    return cycles;
+  };
+
+  uint64_t cycles = cycles_of(total);
+  uint64_t instructions = total[RETIRED] + total_skipped_instructions;
+  double cpi = instructions ? (double)cycles / instructions : 0.0;
+
+  // The run in one line, each category as its share of the CPI
+  std::string line;
+  char part[64];
+
+  for (size_t c = 0; c < CATEGORIES; c++)
+  {
+    if (total[c])
+    {
+      snprintf(part, sizeof(part), ", %s %.3f", category_name((Category)c),
+               instructions ? (double)total[c] / instructions : 0.0);
+      line += part;
+    }
+  }
+
+  Log::info("CPI: %.3f%s", cpi, line.c_str());
+
+  FILE *file = fopen(path, "w");
+
+  if (!file)
+  {
+    Log::error("Error file opening: %s", path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  fprintf(file, "CPI stack, %llu cycles, %llu instructions, CPI %.3f\n\n",
+          (unsigned long long)cycles, (unsigned long long)instructions, cpi);
+  fprintf(file, "category           cycles       %%     CPI\n");
+
+  for (size_t c = 0; c < CATEGORIES; c++)
+  {
+    fprintf(file, "%-12s %12llu  %6.2f  %6.3f\n", category_name((Category)c),
+            (unsigned long long)total[c], cycles ? 100.0 * total[c] / cycles : 0.0,
+            instructions ? (double)total[c] / instructions : 0.0);
+  }
+
+  // Functions by cycles, each category in cycles
+  std::vector<uint32_t> order;
+
+  for (uint32_t f = 0; f < per_function.size(); f++)
+  {
+    if (cycles_of(per_function[f]))
+    {
+      order.push_back(f);
+    }
+  }
+
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+                   { return cycles_of(per_function[a]) > cycles_of(per_function[b]); });
+
+  fprintf(file, "\n      cycles instructions     CPI");
+
+  for (size_t c = 0; c < CATEGORIES; c++)
+  {
+    fprintf(file, " %12s", category_name((Category)c));
+  }
+
+  fprintf(file, "  function\n");
+
+  for (uint32_t f : order)
+  {
+    const Counters &counters = per_function[f];
+    uint64_t function_cycles = cycles_of(counters);
+    uint64_t function_instructions = counters[RETIRED] + skipped_instructions[f];
+
+    fprintf(file, "%12llu %12llu %7.3f", (unsigned long long)function_cycles,
+            (unsigned long long)function_instructions,
+            function_instructions ? (double)function_cycles / function_instructions : 0.0);
+
+    for (size_t c = 0; c < CATEGORIES; c++)
+    {
+      fprintf(file, " %12llu", (unsigned long long)counters[c]);
+    }
+
+    fprintf(file, "  %s\n", f < functions.size() ? functions[f].name.c_str() : "[unknown]");
+  }
+
+  fclose(file);
+  Log::info("Ok cpi stack: %s", path);
+}
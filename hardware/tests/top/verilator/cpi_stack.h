@@ -0,0 +1,102 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef CPI_STACK_H
+#define CPI_STACK_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "ram_init.h"
+
+// Signals of rvsteel_core that tell what a cycle is spent on, as read from the
+// model after the falling edge, so they hold the decisions of the next rising
+// edge
+struct CoreCycle
+{
+  uint32_t pc;
+  uint8_t state; // current_state
+  uint8_t halt;
+  uint8_t take_trap;
+  uint8_t load_pending;
+  uint8_t store_pending;
+  uint8_t prev_load_request;
+  uint8_t prev_read_request;
+  uint8_t prev_write_request;
+  uint8_t read_response;
+  uint8_t write_response;
+};
+
+// Counts every cycle of the core in one category, in total and per function
+class CpiStack
+{
+  public:
+    enum Category
+    {
+      RETIRED,    // An instruction completes
+      LOAD_WAIT,  // Load issued, or its response late
+      STORE_WAIT, // Store issued, or its response late
+      FLUSH,      // Pipeline flushed outside a trap, i.e. right after reset
+      TRAP,       // Trap entry and mret
+      HALTED,     // halt input set
+      BUS_WAIT,   // Instruction fetch response late
+      SKIPPED,    // Jumped over by the harness, see add_skipped()
+      CATEGORIES
+    };
+
+    static const char *category_name(Category category);
+
+    // Which category the cycle falls in. halt comes first, then the late bus
+    // responses, the trap and flush states, and last the loads and stores
+    // being issued.
+    static Category classify(const CoreCycle &cycle);
+
+    // Functions as resolved by ram_init_elf(), may be empty
+    void start(const std::vector<ElfFunction> &functions);
+
+    void sample(const CoreCycle &cycle)
+    {
+      count(cycle.pc, classify(cycle), 1);
+    }
+
+    // Cycles and instructions that were not simulated, e.g. by --fast-forward
+    void add_skipped(uint32_t pc, uint64_t cycles, uint64_t instructions);
+
+    // Logs the breakdown of the run and writes it, with one line per
+    // function, to path
+    void write(const char *path) const;
+
+  private:
+    using Counters = std::array<uint64_t, CATEGORIES>;
+
+    std::vector<ElfFunction> functions;
+
+    // Last entry for code outside every function
+    std::vector<Counters> per_function;
+    std::vector<uint64_t> skipped_instructions;
+
+    // Address range of the function found last
+    uint32_t range_start{0};
+    uint32_t range_end{0};
+    uint32_t range_function{0};
+
+    uint32_t function_of(uint32_t pc);
+
+    void count(uint32_t pc, Category category, uint64_t cycles)
+    {
+      if (pc - range_start >= range_end - range_start)
+      {
+        range_function = function_of(pc);
+      }
+
+      per_function[range_function][category] += cycles;
+    }
+};
+
+#endif // CPI_STACK_H
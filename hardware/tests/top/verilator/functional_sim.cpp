@@ -0,0 +1,871 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "functional_sim.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "log.h"
+
+// Opcodes
+static constexpr uint32_t OPCODE_OP = 0x33;
+static constexpr uint32_t OPCODE_OP_IMM = 0x13;
+static constexpr uint32_t OPCODE_LOAD = 0x03;
+static constexpr uint32_t OPCODE_STORE = 0x23;
+static constexpr uint32_t OPCODE_BRANCH = 0x63;
+static constexpr uint32_t OPCODE_JAL = 0x6f;
+static constexpr uint32_t OPCODE_JALR = 0x67;
+static constexpr uint32_t OPCODE_LUI = 0x37;
+static constexpr uint32_t OPCODE_AUIPC = 0x17;
+static constexpr uint32_t OPCODE_MISC_MEM = 0x0f;
+static constexpr uint32_t OPCODE_SYSTEM = 0x73;
+
+static constexpr uint32_t ECALL = 0x00000073;
+static constexpr uint32_t EBREAK = 0x00100073;
+static constexpr uint32_t MRET = 0x30200073;
+
+// Exception codes
+static constexpr uint32_t CAUSE_MISALIGNED_FETCH = 0;
+static constexpr uint32_t CAUSE_ILLEGAL_INSTRUCTION = 2;
+static constexpr uint32_t CAUSE_BREAKPOINT = 3;
+static constexpr uint32_t CAUSE_MISALIGNED_LOAD = 4;
+static constexpr uint32_t CAUSE_MISALIGNED_STORE = 6;
+static constexpr uint32_t CAUSE_ECALL = 11;
+
+static constexpr uint32_t CAUSE_INTERRUPT = 0x80000000;
+
+// Interrupt codes of rvsteel.v, the UART is fast interrupt 0
+static constexpr uint32_t IRQ_TIMER = 7;
+static constexpr uint32_t IRQ_UART = 16;
+
+// CSR addresses of rvsteel_core.v
+static constexpr uint16_t MARCHID = 0xf12;
+static constexpr uint16_t MIMPID = 0xf13;
+static constexpr uint16_t CYCLE = 0xc00;
+static constexpr uint16_t TIME = 0xc01;
+static constexpr uint16_t INSTRET = 0xc02;
+static constexpr uint16_t CYCLEH = 0xc80;
+static constexpr uint16_t TIMEH = 0xc81;
+static constexpr uint16_t INSTRETH = 0xc82;
+static constexpr uint16_t MSTATUS = 0x300;
+static constexpr uint16_t MSTATUSH = 0x310;
+static constexpr uint16_t MISA = 0x301;
+static constexpr uint16_t MIE = 0x304;
+static constexpr uint16_t MTVEC = 0x305;
+static constexpr uint16_t MSCRATCH = 0x340;
+static constexpr uint16_t MEPC = 0x341;
+static constexpr uint16_t MCAUSE = 0x342;
+static constexpr uint16_t MTVAL = 0x343;
+static constexpr uint16_t MIP = 0x344;
+static constexpr uint16_t MCYCLE = 0xb00;
+static constexpr uint16_t MINSTRET = 0xb02;
+static constexpr uint16_t MCYCLEH = 0xb80;
+static constexpr uint16_t MINSTRETH = 0xb82;
+
+// Writable bits of mie: the fast, external, timer and software interrupts
+static constexpr uint32_t MIE_MASK = 0xffff0888;
+
+static uint32_t immediate_i(uint32_t instruction)
+{
+  return (int32_t)instruction >> 20;
+}
+
+static uint32_t immediate_s(uint32_t instruction)
+{
+  return ((int32_t)(instruction & 0xfe000000) >> 20) | ((instruction >> 7) & 0x1f);
+}
+
+static uint32_t immediate_b(uint32_t instruction)
+{
+  return ((int32_t)(instruction & 0x80000000) >> 19) | ((instruction & 0x80) << 4) |
+         ((instruction >> 20) & 0x7e0) | ((instruction >> 7) & 0x1e);
+}
+
+static uint32_t immediate_j(uint32_t instruction)
+{
+  return ((int32_t)(instruction & 0x80000000) >> 11) | (instruction & 0xff000) |
+         ((instruction >> 9) & 0x800) | ((instruction >> 20) & 0x7fe);
+}
+
+// Inlined with a constant funct3 into each op
+static inline uint32_t alu(uint32_t funct3, bool alternate, uint32_t a, uint32_t b)
+{
+  switch (funct3)
+  {
+  case 0: return alternate ? a - b : a + b;
+  case 1: return a << (b & 0x1f);
+  case 2: return (int32_t)a < (int32_t)b;
+  case 3: return a < b;
+  case 4: return a ^ b;
+  case 5: return alternate ? (uint32_t)((int32_t)a >> (b & 0x1f)) : a >> (b & 0x1f);
+  case 6: return a | b;
+  default: return a & b;
+  }
+}
+
+static inline bool branch_taken(uint32_t funct3, uint32_t a, uint32_t b)
+{
+  switch (funct3)
+  {
+  case 0: return a == b;
+  case 1: return a != b;
+  case 4: return (int32_t)a < (int32_t)b;
+  case 5: return (int32_t)a >= (int32_t)b;
+  case 6: return a < b;
+  default: return a >= b;
+  }
+}
+
+static uint64_t set_low(uint64_t value, uint32_t low)
+{
+  return (value & 0xffffffff00000000) | low;
+}
+
+static uint64_t set_high(uint64_t value, uint32_t high)
+{
+  return ((uint64_t)high << 32) | (uint32_t)value;
+}
+
+// The ops. An op that leaves the block sets pc and the instructions executed.
+struct FunctionalSim::Exec
+{
+    enum CsrOperation
+    {
+      CSR_RW,
+      CSR_RS,
+      CSR_RC
+    };
+
+    template <uint32_t FUNCT3, bool ALTERNATE>
+    static const Op *reg(FunctionalSim &sim, const Op *op)
+    {
+      sim.x[op->rd] = alu(FUNCT3, ALTERNATE, sim.x[op->rs1], sim.x[op->rs2]);
+      return op + 1;
+    }
+
+    template <uint32_t FUNCT3, bool ALTERNATE>
+    static const Op *imm(FunctionalSim &sim, const Op *op)
+    {
+      sim.x[op->rd] = alu(FUNCT3, ALTERNATE, sim.x[op->rs1], op->imm);
+      return op + 1;
+    }
+
+    // lui and auipc, with the value worked out when decoding
+    static const Op *li(FunctionalSim &sim, const Op *op)
+    {
+      sim.x[op->rd] = op->imm;
+      return op + 1;
+    }
+
+    static const Op *nop(FunctionalSim &, const Op *op)
+    {
+      return op + 1;
+    }
+
+    // T is the type of the loaded value, its sign extends it
+    template <typename T> static const Op *load(FunctionalSim &sim, const Op *op)
+    {
+      uint32_t address = sim.x[op->rs1] + op->imm;
+      T value;
+
+      if (address & (sizeof(T) - 1))
+      {
+        return sim.trap(op, CAUSE_MISALIGNED_LOAD, address);
+      }
+
+      if (address < sim.ram_size)
+      {
+        std::memcpy(&value, sim.ram_bytes + address, sizeof(T));
+      }
+      else
+      {
+        value = sim.device_load(address & ~3u, op) >> 8 * (address & 0x3);
+      }
+
+      sim.x[op->rd] = value;
+      return op + 1;
+    }
+
+    template <typename T> static const Op *store(FunctionalSim &sim, const Op *op)
+    {
+      uint32_t address = sim.x[op->rs1] + op->imm;
+      T value = sim.x[op->rs2];
+
+      if (address & (sizeof(T) - 1))
+      {
+        return sim.trap(op, CAUSE_MISALIGNED_STORE, address);
+      }
+
+      if (address >= sim.ram_size)
+      {
+        return sim.device_store(op, address, value, sizeof(T));
+      }
+
+      std::memcpy(sim.ram_bytes + address, &value, sizeof(T));
+
+      if (sim.page_flags[address >> PAGE_SHIFT])
+      {
+        return sim.watched_store(op, address, value);
+      }
+
+      return op + 1;
+    }
+
+    template <uint32_t FUNCT3> static const Op *branch(FunctionalSim &sim, const Op *op)
+    {
+      if (branch_taken(FUNCT3, sim.x[op->rs1], sim.x[op->rs2]))
+      {
+        return sim.jump(op, op->pc + op->imm);
+      }
+
+      return sim.leave(op);
+    }
+
+    // A jump to a misaligned target still writes rd, as in rvsteel_core.v
+    static const Op *jal(FunctionalSim &sim, const Op *op)
+    {
+      sim.x[op->rd] = op->pc + 4;
+      return sim.jump(op, op->pc + op->imm);
+    }
+
+    static const Op *jalr(FunctionalSim &sim, const Op *op)
+    {
+      uint32_t target = sim.x[op->rs1] + op->imm;
+
+      sim.x[op->rd] = op->pc + 4;
+      return sim.jump(op, target);
+    }
+
+    // csrrwi, csrrsi and csrrci take rs1 as an immediate, op->imm is the CSR
+    template <CsrOperation OPERATION, bool IMMEDIATE>
+    static const Op *csr(FunctionalSim &sim, const Op *op)
+    {
+      uint32_t mask = IMMEDIATE ? op->rs1 : sim.x[op->rs1];
+      uint32_t value = sim.csr_read(op->imm, op);
+
+      switch (OPERATION)
+      {
+      case CSR_RW: sim.csr_write(op->imm, mask, op); break;
+      case CSR_RS: sim.csr_write(op->imm, value | mask, op); break;
+      case CSR_RC: sim.csr_write(op->imm, value & ~mask, op); break;
+      }
+
+      sim.x[op->rd] = value;
+      return sim.leave(op);
+    }
+
+    static const Op *mret(FunctionalSim &sim, const Op *op)
+    {
+      sim.mstatus_mie = sim.mstatus_mpie;
+      sim.mstatus_mpie = true;
+      sim.pc = sim.mepc;
+      sim.executed = op->index + 1;
+      return nullptr;
+    }
+
+    // ecall, ebreak and illegal instructions, op->imm is the cause
+    static const Op *exception(FunctionalSim &sim, const Op *op)
+    {
+      if (op->imm == CAUSE_BREAKPOINT and sim.semihosting and sim.semihosting_call(op))
+      {
+        return sim.leave(op);
+      }
+
+      return sim.trap(op, op->imm, op->imm == CAUSE_BREAKPOINT ? op->pc : 0);
+    }
+
+    // Ends a block that was cut short, op->pc is the next instruction
+    static const Op *end_block(FunctionalSim &sim, const Op *op)
+    {
+      sim.pc = op->pc;
+      sim.executed = op->index;
+      return nullptr;
+    }
+};
+
+void FunctionalSim::start(uint32_t boot_address, uint32_t memory_size, uint32_t gpio_width)
+{
+  *this = FunctionalSim();
+  pc = boot_address;
+
+  ram_size = memory_size & ~3u;
+  ram.assign(ram_size / 4, 0);
+  ram_bytes = reinterpret_cast<uint8_t *>(ram.data());
+
+  blocks.resize(ram_size / 4);
+  page_blocks.resize((ram_size >> PAGE_SHIFT) + 1);
+  page_flags.assign(page_blocks.size(), 0);
+
+  gpio.start(gpio_width);
+}
+
+FunctionalSim::State FunctionalSim::state() const
+{
+  State state{};
+
+  state.pc = pc;
+  std::copy(x, x + 32, state.x);
+  state.mstatus_mie = mstatus_mie;
+  state.mstatus_mpie = mstatus_mpie;
+  state.mie = mie;
+  state.mtvec = mtvec;
+  state.mscratch = mscratch;
+  state.mepc = mepc;
+  state.mcause = mcause;
+  state.mtval = mtval;
+  state.mcycle = cycle + mcycle_offset;
+  state.minstret = instret + minstret_offset;
+
+  return state;
+}
+
+void FunctionalSim::watch(uint32_t address)
+{
+  if (address and address < ram_size)
+  {
+    page_flags[address >> PAGE_SHIFT] |= PAGE_WATCH;
+  }
+}
+
+void FunctionalSim::set_host_out(uint32_t address)
+{
+  host_out = address;
+  watch(address);
+}
+
+void FunctionalSim::set_tohost(uint32_t address)
+{
+  tohost = address;
+  watch(address);
+}
+
+void FunctionalSim::set_semihosting(Semihosting *host, uint32_t cycle_ns)
+{
+  semihosting = host;
+  semihosting_cycle_ns = cycle_ns;
+}
+
+FunctionalSim::Op FunctionalSim::decode_op(uint32_t instruction, uint32_t address,
+                                           bool &last) const
+{
+  static constexpr Handler OP_HANDLERS[8] = {
+      Exec::reg<0, false>, Exec::reg<1, false>, Exec::reg<2, false>, Exec::reg<3, false>,
+      Exec::reg<4, false>, Exec::reg<5, false>, Exec::reg<6, false>, Exec::reg<7, false>};
+
+  static constexpr Handler OP_IMM_HANDLERS[8] = {
+      Exec::imm<0, false>, Exec::imm<1, false>, Exec::imm<2, false>, Exec::imm<3, false>,
+      Exec::imm<4, false>, Exec::imm<5, false>, Exec::imm<6, false>, Exec::imm<7, false>};
+
+  static constexpr Handler BRANCH_HANDLERS[8] = {
+      Exec::branch<0>, Exec::branch<1>, nullptr,         nullptr,
+      Exec::branch<4>, Exec::branch<5>, Exec::branch<6>, Exec::branch<7>};
+
+  static constexpr Handler LOAD_HANDLERS[8] = {
+      Exec::load<int8_t>, Exec::load<int16_t>,  Exec::load<uint32_t>, nullptr,
+      Exec::load<uint8_t>, Exec::load<uint16_t>, nullptr,             nullptr};
+
+  static constexpr Handler STORE_HANDLERS[8] = {
+      Exec::store<uint8_t>, Exec::store<uint16_t>, Exec::store<uint32_t>, nullptr,
+      nullptr,              nullptr,               nullptr,               nullptr};
+
+  static constexpr Handler CSR_HANDLERS[8] = {
+      nullptr,
+      Exec::csr<Exec::CSR_RW, false>,
+      Exec::csr<Exec::CSR_RS, false>,
+      Exec::csr<Exec::CSR_RC, false>,
+      nullptr,
+      Exec::csr<Exec::CSR_RW, true>,
+      Exec::csr<Exec::CSR_RS, true>,
+      Exec::csr<Exec::CSR_RC, true>};
+
+  uint32_t opcode = instruction & 0x7f;
+  uint32_t funct3 = (instruction >> 12) & 0x7;
+  uint32_t funct7 = instruction >> 25;
+
+  Op op{};
+  op.pc = address;
+  op.rd = (instruction >> 7) & 0x1f;
+  op.rs1 = (instruction >> 15) & 0x1f;
+  op.rs2 = (instruction >> 20) & 0x1f;
+
+  // x0 is written to a register that is never read
+  op.rd = op.rd ? op.rd : 32;
+
+  last = false;
+
+  switch (opcode)
+  {
+  case OPCODE_LUI:
+    op.handler = Exec::li;
+    op.imm = instruction & 0xfffff000;
+    break;
+
+  case OPCODE_AUIPC:
+    op.handler = Exec::li;
+    op.imm = address + (instruction & 0xfffff000);
+    break;
+
+  case OPCODE_JAL:
+    op.handler = Exec::jal;
+    op.imm = immediate_j(instruction);
+    last = true;
+    break;
+
+  case OPCODE_JALR:
+    op.handler = funct3 == 0 ? Exec::jalr : nullptr;
+    op.imm = immediate_i(instruction);
+    last = true;
+    break;
+
+  case OPCODE_BRANCH:
+    op.handler = BRANCH_HANDLERS[funct3];
+    op.imm = immediate_b(instruction);
+    last = true;
+    break;
+
+  case OPCODE_LOAD:
+    op.handler = LOAD_HANDLERS[funct3];
+    op.imm = immediate_i(instruction);
+    break;
+
+  case OPCODE_STORE:
+    op.handler = STORE_HANDLERS[funct3];
+    op.imm = immediate_s(instruction);
+    break;
+
+  case OPCODE_OP_IMM:
+    op.imm = immediate_i(instruction);
+
+    if (funct3 == 5 and funct7 == 0x20)
+    {
+      op.handler = Exec::imm<5, true>;
+    }
+    else if (funct3 == 1 or funct3 == 5)
+    {
+      op.handler = funct7 == 0 ? OP_IMM_HANDLERS[funct3] : nullptr;
+    }
+    else
+    {
+      op.handler = OP_IMM_HANDLERS[funct3];
+    }
+    break;
+
+  case OPCODE_OP:
+    if (funct7 == 0)
+    {
+      op.handler = OP_HANDLERS[funct3];
+    }
+    else if (funct7 == 0x20 and (funct3 == 0 or funct3 == 5))
+    {
+      op.handler = funct3 == 0 ? Exec::reg<0, true> : Exec::reg<5, true>;
+    }
+    break;
+
+  case OPCODE_MISC_MEM:
+    op.handler = Exec::nop;
+    break;
+
+  // A CSR instruction ends the block, so an interrupt it enables is taken
+  // right after it
+  case OPCODE_SYSTEM:
+    last = true;
+
+    if (CSR_HANDLERS[funct3])
+    {
+      op.handler = CSR_HANDLERS[funct3];
+      op.imm = instruction >> 20;
+    }
+    else if (instruction == MRET)
+    {
+      op.handler = Exec::mret;
+    }
+    else if (instruction == ECALL or instruction == EBREAK)
+    {
+      op.handler = Exec::exception;
+      op.imm = instruction == ECALL ? CAUSE_ECALL : CAUSE_BREAKPOINT;
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  if (not op.handler)
+  {
+    op.handler = Exec::exception;
+    op.imm = CAUSE_ILLEGAL_INSTRUCTION;
+    last = true;
+  }
+
+  return op;
+}
+
+FunctionalSim::Block *FunctionalSim::decode(uint32_t start)
+{
+  std::unique_ptr<Block> block(new Block);
+  uint32_t address = start;
+  bool last = false;
+
+  while (not last and address < ram_size and block->ops.size() < MAX_BLOCK_INSTRUCTIONS)
+  {
+    Op op = decode_op(ram[address / 4], address, last);
+    op.index = block->ops.size();
+    block->ops.push_back(op);
+    address += 4;
+  }
+
+  if (not last)
+  {
+    Op op{};
+    op.handler = Exec::end_block;
+    op.pc = address;
+    op.index = block->ops.size();
+    block->ops.push_back(op);
+  }
+
+  block->start = start;
+  block->end = address;
+
+  for (uint32_t page = start >> PAGE_SHIFT; page <= (address - 1) >> PAGE_SHIFT; page++)
+  {
+    page_blocks[page].push_back(block.get());
+    page_flags[page] |= PAGE_CODE;
+  }
+
+  decoded++;
+  blocks[start / 4] = std::move(block);
+  return blocks[start / 4].get();
+}
+
+// Drops the blocks that overlap the page. They are freed between blocks, as
+// the running one can be among them.
+void FunctionalSim::invalidate(uint32_t page)
+{
+  for (Block *block : page_blocks[page])
+  {
+    for (uint32_t other = block->start >> PAGE_SHIFT; other <= (block->end - 1) >> PAGE_SHIFT;
+         other++)
+    {
+      if (other == page)
+      {
+        continue;
+      }
+
+      std::vector<Block *> &list = page_blocks[other];
+      list.erase(std::find(list.begin(), list.end(), block));
+
+      if (list.empty())
+      {
+        page_flags[other] &= ~PAGE_CODE;
+      }
+    }
+
+    dropped.push_back(std::move(blocks[block->start / 4]));
+    invalidated++;
+  }
+
+  page_blocks[page].clear();
+  page_flags[page] &= ~PAGE_CODE;
+}
+
+const FunctionalSim::Block *FunctionalSim::lookup()
+{
+  if (pc < ram_size)
+  {
+    Block *block = blocks[pc / 4].get();
+    return block ? block : decode(pc);
+  }
+
+  // Past the RAM the bus reads 0 or a device register, neither is code
+  bool last;
+  outside.ops.assign(1, decode_op(0, pc, last));
+  return &outside;
+}
+
+const FunctionalSim::Op *FunctionalSim::leave(const Op *op)
+{
+  pc = op->pc + 4;
+  executed = op->index + 1;
+  return nullptr;
+}
+
+// The target drops bit 0, a target that is not word aligned traps
+const FunctionalSim::Op *FunctionalSim::jump(const Op *op, uint32_t target)
+{
+  if (target & 0x2)
+  {
+    return trap(op, CAUSE_MISALIGNED_FETCH, target);
+  }
+
+  pc = target & ~1u;
+  executed = op->index + 1;
+  return nullptr;
+}
+
+const FunctionalSim::Op *FunctionalSim::trap(const Op *op, uint32_t cause, uint32_t tval)
+{
+  mepc = op->pc;
+  mcause = cause;
+  mtval = tval;
+  trap_count[mcause]++;
+  mstatus_mpie = mstatus_mie;
+  mstatus_mie = false;
+  pc = mtvec & ~3u;
+
+  executed = op->index + 1;
+  trapped = true;
+  return nullptr;
+}
+
+uint32_t FunctionalSim::mip(uint64_t now) const
+{
+  return ((uint32_t)uart.irq() << IRQ_UART) | ((uint32_t)mtimer.irq(now) << IRQ_TIMER);
+}
+
+// Fast interrupts come first, then the external, software and timer ones, as
+// in rvsteel_core.v. Only the UART and the timer are connected.
+void FunctionalSim::check_interrupts()
+{
+  if (not mstatus_mie or not mie)
+  {
+    return;
+  }
+
+  uint32_t pending = mip(cycle) & mie;
+
+  if (not pending)
+  {
+    return;
+  }
+
+  uint32_t code = pending & (1u << IRQ_UART) ? IRQ_UART : IRQ_TIMER;
+
+  if (code == IRQ_UART)
+  {
+    uart.irq_response();
+  }
+
+  mepc = pc;
+  mcause = CAUSE_INTERRUPT | code;
+  mtval = 0;
+  trap_count[mcause]++;
+  mstatus_mpie = mstatus_mie;
+  mstatus_mie = false;
+
+  // Vectored mode
+  pc = (mtvec & ~3u) + ((mtvec & 0x3) == 1 ? 4 * code : 0);
+}
+
+// The op index gives the cycles and instructions of the block before it
+uint32_t FunctionalSim::csr_read(uint16_t address, const Op *op) const
+{
+  uint64_t mcycle = cycle + op->index + mcycle_offset;
+  uint64_t minstret = instret + op->index + minstret_offset;
+
+  switch (address)
+  {
+  case MARCHID: return 0x00000018;
+  case MIMPID: return 0x00000006;
+  case MSTATUS: return 0x00001800 | (mstatus_mpie << 7) | (mstatus_mie << 3);
+  case MSTATUSH: return 0;
+  case MISA: return 0x40000100;
+  case MIE: return mie;
+  case MTVEC: return mtvec;
+  case MSCRATCH: return mscratch;
+  case MEPC: return mepc;
+  case MCAUSE: return mcause;
+  case MTVAL: return mtval;
+  case MIP: return mip(cycle + op->index);
+
+  case CYCLE:
+  case MCYCLE: return mcycle;
+  case CYCLEH:
+  case MCYCLEH: return mcycle >> 32;
+  case INSTRET:
+  case MINSTRET: return minstret;
+  case INSTRETH:
+  case MINSTRETH: return minstret >> 32;
+
+  // The real time clock of rvsteel.v is tied to 0
+  case TIME:
+  case TIMEH: return 0;
+
+  default: return 0;
+  }
+}
+
+void FunctionalSim::csr_write(uint16_t address, uint32_t value, const Op *op)
+{
+  uint64_t now = cycle + op->index;
+  uint64_t retired = instret + op->index;
+
+  switch (address)
+  {
+  case MSTATUS:
+    mstatus_mie = (value >> 3) & 1;
+    mstatus_mpie = (value >> 7) & 1;
+    break;
+
+  case MIE: mie = value & MIE_MASK; break;
+  case MTVEC: mtvec = value & ~2u; break;
+  case MSCRATCH: mscratch = value; break;
+  case MEPC: mepc = value & ~3u; break;
+  case MCAUSE: mcause = value; break;
+  case MTVAL: mtval = value; break;
+  case MCYCLE: mcycle_offset = set_low(now + mcycle_offset, value) - now; break;
+  case MCYCLEH: mcycle_offset = set_high(now + mcycle_offset, value) - now; break;
+  case MINSTRET: minstret_offset = set_low(retired + minstret_offset, value) - retired; break;
+  case MINSTRETH: minstret_offset = set_high(retired + minstret_offset, value) - retired; break;
+  default: break;
+  }
+}
+
+// Nothing selected reads 0, as on rvsteel_bus.v
+uint32_t FunctionalSim::device_load(uint32_t address, const Op *op)
+{
+  if ((address & ~(UART_SIZE - 1)) == UART_START)
+  {
+    return uart.read(address & (UART_SIZE - 1));
+  }
+
+  if ((address & ~(MTIMER_SIZE - 1)) == MTIMER_START)
+  {
+    return mtimer.read(address & (MTIMER_SIZE - 1), cycle + op->index);
+  }
+
+  if ((address & ~(GPIO_SIZE - 1)) == GPIO_START)
+  {
+    return gpio.read(address & (GPIO_SIZE - 1));
+  }
+
+  if ((address & ~(SPI_SIZE - 1)) == SPI_START)
+  {
+    return spi.read(address & (SPI_SIZE - 1));
+  }
+
+  return 0;
+}
+
+const FunctionalSim::Op *FunctionalSim::device_store(const Op *op, uint32_t address,
+                                                     uint32_t value, uint32_t size)
+{
+  uint32_t word = address & ~3u;
+  uint32_t data = value << 8 * (address & 0x3);
+  uint32_t strobe = ((1u << size) - 1) << (address & 0x3);
+
+  if ((word & ~(UART_SIZE - 1)) == UART_START)
+  {
+    uart.write(word & (UART_SIZE - 1), data);
+  }
+  else if ((word & ~(MTIMER_SIZE - 1)) == MTIMER_START)
+  {
+    mtimer.write(word & (MTIMER_SIZE - 1), data, strobe, cycle + op->index);
+  }
+  else if ((word & ~(GPIO_SIZE - 1)) == GPIO_START)
+  {
+    gpio.write(word & (GPIO_SIZE - 1), data, strobe);
+  }
+  else if ((word & ~(SPI_SIZE - 1)) == SPI_START)
+  {
+    spi.write(word & (SPI_SIZE - 1), data, strobe);
+  }
+
+  return check_watch(word, data) ? leave(op) : op + 1;
+}
+
+// A store into a page with code or a watched address. The block is left when
+// code was dropped, it may be the running one.
+const FunctionalSim::Op *FunctionalSim::watched_store(const Op *op, uint32_t address,
+                                                      uint32_t value)
+{
+  uint32_t page = address >> PAGE_SHIFT;
+  bool code = page_flags[page] & PAGE_CODE;
+
+  if (code)
+  {
+    invalidate(page);
+  }
+
+  bool stop = check_watch(address & ~3u, value << 8 * (address & 0x3));
+  return code or stop ? leave(op) : op + 1;
+}
+
+// --host-out and tohost compare the word address, as the harness does on the
+// bus. Returns true when the run ends.
+bool FunctionalSim::check_watch(uint32_t address, uint32_t value)
+{
+  if (host_out and address == host_out)
+  {
+    Log::host_out((char)value);
+  }
+
+  if (tohost and address == tohost)
+  {
+    tohost_data = value;
+    tohost_written = true;
+  }
+
+  return tohost_written;
+}
+
+// --semihosting: the ebreak of the sequence is serviced by the host and retires
+// as a nop. The blocks decoded from the RAM the call read into are dropped.
+bool FunctionalSim::semihosting_call(const Op *op)
+{
+  if (not Semihosting::is_call(ram.data(), ram.size(), op->pc))
+  {
+    return false;
+  }
+
+  uint64_t now = cycle + op->index;
+
+  x[10] = semihosting->call(ram.data(), ram.size(), x[10], x[11], now * semihosting_cycle_ns);
+  semihosting_exit = semihosting->exited();
+
+  uint32_t start = semihosting->written_address();
+  uint32_t size = semihosting->written_size();
+
+  for (uint32_t page = start >> PAGE_SHIFT; size and page <= (start + size - 1) >> PAGE_SHIFT;
+       page++)
+  {
+    if (page_flags[page] & PAGE_CODE)
+    {
+      invalidate(page);
+    }
+  }
+
+  return true;
+}
+
+FunctionalSim::Stop FunctionalSim::run(uint64_t stop_cycle)
+{
+  tohost_written = false;
+
+  while (cycle < stop_cycle and not tohost_written and not semihosting_exit)
+  {
+    check_interrupts();
+
+    const Op *op = lookup()->ops.data();
+
+    while ((op = op->handler(*this, op)))
+    {
+    }
+
+    cycle += executed;
+    instret += executed - trapped;
+    trapped = false;
+    dropped.clear();
+  }
+
+  if (semihosting_exit)
+  {
+    return STOP_EXIT;
+  }
+
+  return tohost_written ? STOP_TOHOST : STOP_CYCLES;
+}
@@ -0,0 +1,211 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef FUNCTIONAL_SIM_H
+#define FUNCTIONAL_SIM_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "peripherals.h"
+#include "semihosting.h"
+
+// Instruction set simulator of rvsteel.v for --functional: RV32I, Zicsr and
+// the machine CSRs and trap causes of rvsteel_core.v, with the RAM and the
+// peripheral models of the memory map. Every instruction takes one cycle.
+//
+// Code is decoded once per basic block into an array of ops, each with the
+// function that executes it, and the blocks are kept per start address. A
+// store into a page that holds decoded code drops the blocks of the page.
+// Interrupts are taken between blocks.
+class FunctionalSim
+{
+  public:
+    enum Stop
+    {
+      STOP_CYCLES, // The given cycle was reached
+      STOP_TOHOST, // tohost was written
+      STOP_EXIT    // SYS_EXIT of --semihosting
+    };
+
+    // Architectural state of the core between two runs, for --sample-every
+    struct State
+    {
+      uint32_t pc;
+      uint32_t x[32];
+      bool mstatus_mie;
+      bool mstatus_mpie;
+      uint32_t mie;
+      uint32_t mtvec;
+      uint32_t mscratch;
+      uint32_t mepc;
+      uint32_t mcause;
+      uint32_t mtval;
+      uint64_t mcycle;
+      uint64_t minstret;
+    };
+
+    UartModel uart;
+    MtimerModel mtimer;
+    GpioModel gpio;
+    SpiModel spi;
+
+    // Reset state with a zeroed RAM of memory_size bytes
+    void start(uint32_t boot_address, uint32_t memory_size, uint32_t gpio_width);
+
+    uint32_t *ram_words()
+    {
+      return ram.data();
+    }
+
+    // Bytes written to host_out are printed, a word written to tohost ends the
+    // run. 0 is none.
+    void set_host_out(uint32_t address);
+    void set_tohost(uint32_t address);
+
+    // --semihosting, the calls see cycle_ns per cycle as the simulated time.
+    // nullptr is none.
+    void set_semihosting(Semihosting *host, uint32_t cycle_ns);
+
+    // Runs until stop_cycle is reached, within a block, or tohost is written
+    Stop run(uint64_t stop_cycle);
+
+    uint32_t tohost_value() const
+    {
+      return tohost_data;
+    }
+
+    uint64_t cycles() const
+    {
+      return cycle;
+    }
+
+    uint64_t instructions() const
+    {
+      return instret;
+    }
+
+    State state() const;
+
+    uint64_t blocks_decoded() const
+    {
+      return decoded;
+    }
+
+    uint64_t blocks_invalidated() const
+    {
+      return invalidated;
+    }
+
+    // Traps taken, by mcause
+    const std::map<uint32_t, uint64_t> &traps() const
+    {
+      return trap_count;
+    }
+
+  private:
+    struct Op;
+    struct Exec;
+
+    // Executes the op and returns the next one of the block, or nullptr when
+    // the block is left with pc set
+    using Handler = const Op *(*)(FunctionalSim &sim, const Op *op);
+
+    struct Op
+    {
+      Handler handler;
+      uint32_t pc;
+      uint32_t imm;
+      uint8_t rd; // 32 for x0, a register that is never read
+      uint8_t rs1;
+      uint8_t rs2;
+      uint8_t index; // In the block
+    };
+
+    struct Block
+    {
+      uint32_t start;
+      uint32_t end; // Past the last instruction
+      std::vector<Op> ops;
+    };
+
+    static constexpr uint32_t MAX_BLOCK_INSTRUCTIONS = 64;
+    static constexpr uint32_t PAGE_SHIFT = 8;
+
+    // page_flags
+    static constexpr uint8_t PAGE_CODE = 0x1;
+    static constexpr uint8_t PAGE_WATCH = 0x2;
+
+    uint32_t pc{0};
+    uint32_t x[33]{};
+
+    bool mstatus_mie{false};
+    bool mstatus_mpie{true};
+    uint32_t mie{0};
+    uint32_t mtvec{0};
+    uint32_t mscratch{0};
+    uint32_t mepc{0};
+    uint32_t mcause{0};
+    uint32_t mtval{0};
+    uint64_t mcycle_offset{0}; // mcycle - cycle
+    uint64_t minstret_offset{0};
+
+    uint64_t cycle{0};
+    uint64_t instret{0};
+
+    // Set by the op that leaves the block
+    uint32_t executed{0};
+    bool trapped{false};
+
+    std::vector<uint32_t> ram;
+    uint8_t *ram_bytes{nullptr};
+    uint32_t ram_size{0};
+
+    std::vector<std::unique_ptr<Block>> blocks;   // Per RAM word
+    std::vector<std::vector<Block *>> page_blocks; // Blocks that overlap a page
+    std::vector<uint8_t> page_flags;
+    std::vector<std::unique_ptr<Block>> dropped;  // Freed between blocks
+    Block outside;                                // Code past the RAM
+
+    uint32_t host_out{0};
+    uint32_t tohost{0};
+    uint32_t tohost_data{0};
+    bool tohost_written{false};
+
+    Semihosting *semihosting{nullptr};
+    uint32_t semihosting_cycle_ns{0};
+    bool semihosting_exit{false};
+
+    uint64_t decoded{0};
+    uint64_t invalidated{0};
+    std::map<uint32_t, uint64_t> trap_count;
+
+    const Block *lookup();
+    Block *decode(uint32_t start);
+    Op decode_op(uint32_t instruction, uint32_t address, bool &last) const;
+    void invalidate(uint32_t page);
+    void watch(uint32_t address);
+
+    uint32_t mip(uint64_t now) const;
+    void check_interrupts();
+    const Op *trap(const Op *op, uint32_t cause, uint32_t tval);
+    const Op *jump(const Op *op, uint32_t target);
+    const Op *leave(const Op *op);
+
+    uint32_t csr_read(uint16_t address, const Op *op) const;
+    void csr_write(uint16_t address, uint32_t value, const Op *op);
+
+    uint32_t device_load(uint32_t address, const Op *op);
+    const Op *device_store(const Op *op, uint32_t address, uint32_t value, uint32_t size);
+    const Op *watched_store(const Op *op, uint32_t address, uint32_t value);
+    bool check_watch(uint32_t address, uint32_t value);
+    bool semihosting_call(const Op *op);
+};
+
+#endif // FUNCTIONAL_SIM_H
@@ -0,0 +1,114 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef GOLDEN_MODEL_H
+#define GOLDEN_MODEL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "commit_log.h"
+
+// Instruction set model of rvsteel_core.v: RV32I, Zicsr and the machine CSRs
+// of the core, with its trap behaviour, e.g. the register a misaligned jal
+// still writes. It runs in lockstep with the RTL: every record of the commit
+// stream steps it by one instruction or one trap, and what the model expects
+// is compared with what the RTL did.
+//
+// What the model cannot know is taken from the RTL: the interrupts, the loads
+// past the RAM, which are devices, and the counter and mip CSRs.
+class GoldenModel
+{
+  public:
+    // The architectural state after reset, with a copy of the RAM
+    void start(uint32_t boot_address, const uint32_t *ram, uint32_t words);
+
+    // Steps the model over the record of the RTL. Returns false on the first
+    // difference, described by error().
+    bool check(const CommitRecord &rtl);
+
+    // --semihosting: the ebreak at pc was serviced by the host, so it retires
+    // as a nop. a0 is the result and the host wrote size bytes of the RAM at
+    // address.
+    void host_call(uint32_t a0, const uint32_t *ram, uint32_t address, uint32_t size);
+
+    const std::string &error() const
+    {
+      return message;
+    }
+
+    // Records checked so far
+    uint64_t records() const
+    {
+      return checked;
+    }
+
+    // The state after the last record, for --fuzz
+    uint32_t reg(uint32_t index) const
+    {
+      return x[index];
+    }
+
+    const std::vector<uint32_t> &memory() const
+    {
+      return ram;
+    }
+
+  private:
+    // What the instruction at pc does, before it is applied
+    struct Step
+    {
+      CommitRecord record;         // As the RTL should commit it
+      int exception{-1};           // mcause, -1 when none
+      uint32_t tval{0};            // mtval of the exception
+      uint32_t next_pc{0};
+      bool csr_write{false};
+      uint16_t csr_address{0};
+      uint32_t csr_value{0};
+      bool mret{false};
+      bool rd_from_rtl{false};     // A device load or a counter CSR read
+    };
+
+    uint32_t pc{0};
+    uint32_t x[32]{};
+
+    bool mstatus_mie{false};
+    bool mstatus_mpie{true};
+    uint32_t mie{0};
+    uint32_t mtvec{0};
+    uint32_t mscratch{0};
+    uint32_t mepc{0};
+    uint32_t mcause{0};
+    uint32_t mtval{0};
+
+    std::vector<uint32_t> ram;
+
+    bool host_nop{false}; // The next instruction was a semihosting ebreak
+
+    uint64_t checked{0};
+    std::string message;
+
+    bool in_ram(uint32_t address) const
+    {
+      return address / 4 < ram.size();
+    }
+
+    Step execute(uint32_t instruction) const;
+    void execute_csr(uint32_t instruction, Step &step) const;
+    uint32_t csr_read(uint16_t address, bool &from_rtl) const;
+    void csr_write(uint16_t address, uint32_t value);
+    void store(uint32_t address, uint32_t value, uint32_t size);
+    void write_rd(const CommitRecord &record);
+    void take_trap(uint32_t cause, uint32_t tval);
+
+    bool check_interrupt(const CommitRecord &rtl);
+    bool compare(const CommitRecord &rtl, const CommitRecord &expected);
+    bool fail(const char *what, const CommitRecord &rtl, const CommitRecord *expected);
+};
+
+#endif // GOLDEN_MODEL_H
@@ -0,0 +1,106 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "idle_loop.h"
+
+#include <algorithm>
+#include <cstring>
+
+void IdleLoop::set_map(uint32_t ram_size, uint32_t timer_start, uint32_t timer_size)
+{
+  this->ram_size = ram_size;
+  this->timer_start = timer_start;
+  this->timer_size = timer_size;
+}
+
+void IdleLoop::reset()
+{
+  prev_pc = UINT32_MAX;
+  head = UINT32_MAX;
+  started = false;
+  stable_count = 0;
+}
+
+void IdleLoop::start_iteration(uint64_t instret, const uint32_t *regs)
+{
+  start_cycle = cycle;
+  start_instret = instret;
+  memcpy(start_regs, regs, sizeof(start_regs));
+  iter_write = false;
+  iter_other_read = false;
+  iter_timer_read = false;
+  iter_timer_regs = 0;
+  iter_low = UINT32_MAX;
+  iter_high = 0;
+  started = true;
+}
+
+bool IdleLoop::sample(uint32_t pc, uint64_t instret, bool read, bool write, uint32_t address,
+                      uint32_t rd, const uint32_t *regs)
+{
+  cycle++;
+
+  bool advanced = pc != prev_pc or instret != prev_instret;
+  bool backward = pc <= prev_pc and prev_pc != UINT32_MAX;
+  bool is_stable = false;
+
+  prev_pc = pc;
+  prev_instret = instret;
+
+  if (advanced and pc == head and started)
+  {
+    uint32_t cycles = cycle - start_cycle;
+    uint64_t instructions = instret - start_instret;
+
+    // Only the registers loaded from the timer may differ
+    bool same_regs = true;
+
+    for (size_t i = 0; i < REGS; i++)
+    {
+      same_regs &= start_regs[i] == regs[i] or (iter_timer_regs >> (i + 1) & 1);
+    }
+
+    bool same = cycles == period_cycles and instructions == period_instret and
+                not iter_write and not iter_other_read and same_regs and
+                iter_low == pc_low and iter_high == pc_high;
+
+    stable_count = same ? stable_count + 1 : 0;
+    period_cycles = cycles;
+    period_instret = instructions;
+    timer_read = iter_timer_read;
+    pc_low = iter_low;
+    pc_high = iter_high;
+    is_stable = stable_count >= STABLE_ITERATIONS;
+
+    start_iteration(instret, regs);
+  }
+  else if (advanced and backward and pc != head)
+  {
+    // A jump back to a new address starts a candidate loop
+    head = pc;
+    stable_count = 0;
+    period_cycles = 0;
+    start_iteration(instret, regs);
+  }
+
+  if (started)
+  {
+    iter_low = std::min(iter_low, pc);
+    iter_high = std::max(iter_high, pc);
+    iter_write |= write;
+
+    if (read)
+    {
+      bool is_timer = address - timer_start < timer_size;
+      iter_timer_read |= is_timer;
+      iter_timer_regs |= is_timer ? 1u << (rd & 31) : 0;
+      iter_other_read |= not is_timer and address >= ram_size;
+    }
+  }
+
+  return is_stable;
+}
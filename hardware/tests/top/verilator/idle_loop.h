@@ -0,0 +1,102 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef IDLE_LOOP_H
+#define IDLE_LOOP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Recognizes a loop that only waits, from the program counter and the bus
+// accesses of the core. Every iteration must take the same number of cycles
+// and instructions, write nothing, read only RAM or the timer, and leave the
+// registers as it found them, except for the destinations of its timer loads.
+// Such a loop can only be left by an interrupt or, if it reads the timer, by
+// time passing. A branch-to-self is the simplest case.
+class IdleLoop
+{
+  public:
+    // Iterations that must repeat identically before the loop is reported
+    static constexpr uint32_t STABLE_ITERATIONS = 4;
+
+    // Addresses read by the loop: RAM, which only the core writes, and the timer
+    void set_map(uint32_t ram_size, uint32_t timer_start, uint32_t timer_size);
+
+    // Called once per clock cycle. rd is the destination register of the
+    // instruction that makes the access, regs are the integer registers x1 to
+    // x31. Returns true at the head of an iteration of an idle loop.
+    bool sample(uint32_t pc, uint64_t instret, bool read, bool write, uint32_t address,
+                uint32_t rd, const uint32_t *regs);
+
+    // Forgets the current loop, e.g. after the harness changed the counters
+    void reset();
+
+    // Cycles and instructions per iteration
+    uint32_t period() const
+    {
+      return period_cycles;
+    }
+
+    uint64_t instructions() const
+    {
+      return period_instret;
+    }
+
+    // Whether the loop polls the timer, so it may exit as time passes
+    bool reads_timer() const
+    {
+      return timer_read;
+    }
+
+    // Program counter range of one iteration
+    uint32_t first_pc() const
+    {
+      return pc_low;
+    }
+
+    uint32_t last_pc() const
+    {
+      return pc_high;
+    }
+
+  private:
+    static constexpr size_t REGS = 31;
+
+    uint32_t ram_size{0};
+    uint32_t timer_start{0};
+    uint32_t timer_size{0};
+
+    uint64_t cycle{0};
+    uint32_t prev_pc{UINT32_MAX};
+    uint64_t prev_instret{0};
+    uint32_t head{UINT32_MAX};
+    bool started{false};
+    uint32_t stable_count{0};
+
+    // Current iteration
+    uint64_t start_cycle{0};
+    uint64_t start_instret{0};
+    uint32_t start_regs[REGS];
+    bool iter_write{false};
+    bool iter_other_read{false};
+    bool iter_timer_read{false};
+    uint32_t iter_timer_regs{0};
+    uint32_t iter_low{UINT32_MAX};
+    uint32_t iter_high{0};
+
+    // Previous iteration
+    uint32_t period_cycles{0};
+    uint64_t period_instret{0};
+    bool timer_read{false};
+    uint32_t pc_low{0};
+    uint32_t pc_high{0};
+
+    void start_iteration(uint64_t instret, const uint32_t *regs);
+};
+
+#endif // IDLE_LOOP_H
@@ -8,17 +8,35 @@
 #ifndef LOG_H
 #define LOG_H
 
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
 #include <cstddef>
-#include <iostream>
-#include <sstream>
-#include <fstream>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <thread>
+
+// Messages below this level are removed at compile time, e.g.
+// -DLOG_MIN_LEVEL=1 drops every Log::debug() call
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
 
+// Messages are formatted by the caller into a lock-free ring of records and
+// written by a background thread, so logging never waits on the output stream.
+// The ring is drained and the thread stopped at exit.
 class Log
 {
   public:
-    ~Log() = default;
     static constexpr size_t BUFFER_SIZE = 1024;
+    static constexpr size_t RING_SIZE = 1024; // Records, a power of two
 
     enum Level
     {
@@ -31,6 +49,8 @@ class Log
       END
     };
 
+    static constexpr Level MIN_LEVEL = (Level)LOG_MIN_LEVEL;
+
     static const char *level_name(Level level) {
       switch(level) {
       case DEBUG: return "DEBUG";
@@ -48,6 +68,29 @@ class Log
         return instance;
     }
 
+    ~Log()
+    {
+      flush_host_out();
+
+      {
+        SignalsBlocked blocked;
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stop = true;
+      }
+
+      wake.notify_one();
+
+      // std::exit() on the writer thread cannot wait for itself
+      if (std::this_thread::get_id() == writer.get_id())
+      {
+        writer.detach();
+      }
+      else
+      {
+        writer.join();
+      }
+    }
+
     static void set_level(const Level level)
     {
       get_instance().level = level;
@@ -69,6 +112,9 @@ class Log
     static void set_out(const std::string& filename)
     {
       Log &log = get_instance();
+      log.flush();
+
+      std::lock_guard<std::mutex> lock(log.out_mutex);
       log.fileout.open(filename, std::ios::out | std::ios::trunc);
 
       if (log.fileout.is_open())
@@ -77,82 +123,366 @@ class Log
       }
     }
 
+    // Messages are stamped with the value of this counter, e.g. the simulated
+    // clock cycles. nullptr disables the stamp.
+    static void set_cycles(const uint64_t *cycles)
+    {
+      get_instance().cycles = cycles;
+    }
+
     template<typename... Targs>
     static void debug(const char* format, Targs... Fargs)
     {
-      get_instance().message(DEBUG, format, Fargs...);
+      if constexpr (DEBUG >= MIN_LEVEL)
+      {
+        get_instance().message(DEBUG, format, Fargs...);
+      }
     }
 
     template<typename... Targs>
     static void info(const char* format, Targs... Fargs)
     {
-      get_instance().message(INFO, format, Fargs...);
+      if constexpr (INFO >= MIN_LEVEL)
+      {
+        get_instance().message(INFO, format, Fargs...);
+      }
     }
 
     template<typename... Targs>
     static void warning(const char* format, Targs... Fargs)
     {
-      get_instance().message(WARNING, format, Fargs...);
+      if constexpr (WARNING >= MIN_LEVEL)
+      {
+        get_instance().message(WARNING, format, Fargs...);
+      }
     }
 
     template<typename... Targs>
     static void error(const char* format, Targs... Fargs)
     {
-      get_instance().message(ERROR, format, Fargs...);
+      if constexpr (ERROR >= MIN_LEVEL)
+      {
+        get_instance().message(ERROR, format, Fargs...);
+      }
     }
 
     template<typename... Targs>
     static void critical(const char* format, Targs... Fargs)
     {
-      get_instance().message(CRITICAL, format, Fargs...);
+      if constexpr (CRITICAL >= MIN_LEVEL)
+      {
+        get_instance().message(CRITICAL, format, Fargs...);
+      }
     }
 
+    // Characters written by the firmware are buffered until a newline, a full
+    // buffer or exit. Only called from the simulation thread.
     static void host_out(const char c)
     {
-      if (get_instance().level < QUIET)
+      Log &log = get_instance();
+
+      log.host_count++;
+
+      if (log.level < QUIET)
       {
-        *get_instance().log_stream << c;
+        log.host_buffer[log.host_size++] = c;
+
+        if (c == '\n' or log.host_size == BUFFER_SIZE - 1)
+        {
+          log.flush_host_out();
+        }
       }
     }
 
+    // Characters written by the firmware so far, printed or not
+    static uint64_t host_out_count()
+    {
+      return get_instance().host_count;
+    }
+
+    // Waits until every record pushed so far is written
+    static void flush()
+    {
+      Log &log = get_instance();
+      size_t pushed = log.tail.load(std::memory_order_acquire);
+      SignalsBlocked blocked;
+      std::unique_lock<std::mutex> lock(log.wake_mutex);
+
+      log.flushing++;
+      log.drained.wait(lock, [&] { return log.written.load() >= pushed; });
+      log.flushing--;
+    }
+
   private:
-    char buffer[BUFFER_SIZE];
+    // Every signal is blocked while wake_mutex is held, so the SIGINT handler,
+    // which logs and exits, never waits on a lock held by its own thread
+    struct SignalsBlocked
+    {
+      sigset_t previous;
+
+      SignalsBlocked()
+      {
+        sigset_t all;
+
+        sigfillset(&all);
+        pthread_sigmask(SIG_SETMASK, &all, &previous);
+      }
+
+      ~SignalsBlocked()
+      {
+        pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+      }
+    };
+
+    struct Record
+    {
+      std::atomic<size_t> sequence;
+      uint64_t cycle;
+      Level level;
+      bool host; // Raw --host-out text, no prefix nor newline added
+      bool stamped;
+      char text[BUFFER_SIZE];
+    };
+
     Level level{DEBUG};
     std::ofstream fileout;
     std::ostream* log_stream{&std::cout};
+    const uint64_t *cycles{nullptr};
+
+    std::unique_ptr<Record[]> ring{new Record[RING_SIZE]};
+    std::atomic<size_t> tail{0};    // Next record to claim, by any thread
+    std::atomic<size_t> written{0}; // Records drained by the writer
+    size_t head{0};                 // Next record to drain, writer only
+
+    char host_buffer[BUFFER_SIZE];
+    size_t host_size{0};
+    uint64_t host_count{0};
+
+    // The writer sleeps on wake until a record is published, and flush() on
+    // drained until the writer has caught up. Each side only signals the other
+    // when its flag says it is waiting, so logging stays lock-free otherwise.
+    bool stop{false};
+    std::atomic<bool> sleeping{false};
+    std::atomic<int> flushing{0};
+    std::mutex wake_mutex;
+    std::mutex out_mutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::thread writer;
+
+    Log()
+    {
+      for (size_t i = 0; i < RING_SIZE; i++)
+      {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+      }
 
-    Log() = default;
+      // The writer inherits the blocked mask, so signal handlers always run
+      // on a simulation thread
+      SignalsBlocked blocked;
+      writer = std::thread(&Log::drain, this);
+    }
+
+    bool is_ready(size_t pos) const
+    {
+      return ring[pos & (RING_SIZE - 1)].sequence.load(std::memory_order_acquire) == pos + 1;
+    }
+
+    Record &claim();
+    void publish(Record &record, size_t pos);
+    void flush_host_out();
+    void drain();
 
     template<typename... Targs>
     void message(Level level, const char* format, Targs... Fargs);
+};
 
-    template<typename... Targs>
-    void message(std::stringstream &ss, const char* format, Targs... Fargs);
+// Claims the next free record, waiting for the writer when the ring is full.
+// The record is handed back to the writer by publish().
+inline Log::Record &Log::claim()
+{
+  size_t pos = tail.load(std::memory_order_relaxed);
 
-    template<typename... Targs>
-    void message(std::stringstream &ss, const char* str)
+  while (true)
+  {
+    Record &record = ring[pos & (RING_SIZE - 1)];
+    size_t sequence = record.sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+    if (diff == 0)
     {
-      ss << str;
+      if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+      {
+        return record;
+      }
     }
-};
+    else if (diff < 0)
+    {
+      wake.notify_one();
+      std::this_thread::yield();
+      pos = tail.load(std::memory_order_relaxed);
+    }
+    else
+    {
+      pos = tail.load(std::memory_order_relaxed);
+    }
+  }
+}
 
-template<typename... Targs>
-void Log::message(Level level, const char* format, Targs... Fargs)
+inline void Log::publish(Record &record, size_t pos)
 {
-  if (level >= this->level)
+  // Errors usually come right before std::exit() or a crash, write them now
+  bool urgent = record.level >= ERROR;
+
+  record.sequence.store(pos + 1, std::memory_order_release);
+
+  // Pairs with the fence in drain(): either the writer sees the record before
+  // it sleeps, or it is seen sleeping here and woken
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  if (sleeping.load(std::memory_order_relaxed))
+  {
+    SignalsBlocked blocked;
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    wake.notify_one();
+  }
+
+  if (urgent)
+  {
+    flush();
+  }
+}
+
+inline void Log::flush_host_out()
+{
+  if (host_size == 0)
   {
-    std::stringstream ss;
-    message(ss, "[%s] ", level_name(level));
-    message(ss, format, Fargs...);
-    *log_stream << ss.str() << std::endl;
+    return;
+  }
+
+  Record &record = claim();
+  size_t pos = record.sequence.load(std::memory_order_relaxed);
+
+  record.level = INFO;
+  record.host = true;
+  record.stamped = false;
+  memcpy(record.text, host_buffer, host_size);
+  record.text[host_size] = '\0';
+  host_size = 0;
+
+  publish(record, pos);
+}
+
+// Writer thread: formats the published records into one block per wakeup
+inline void Log::drain()
+{
+  std::string out;
+  char prefix[64];
+
+  while (true)
+  {
+    Record &record = ring[head & (RING_SIZE - 1)];
+    bool ready = is_ready(head);
+
+    if (ready)
+    {
+      if (record.host)
+      {
+        out += record.text;
+      }
+      else
+      {
+        if (record.stamped)
+        {
+          snprintf(prefix, sizeof(prefix), "[%s] @%llu ", level_name(record.level),
+                   (unsigned long long)record.cycle);
+        }
+        else
+        {
+          snprintf(prefix, sizeof(prefix), "[%s] ", level_name(record.level));
+        }
+
+        out += prefix;
+        out += record.text;
+        out += '\n';
+      }
+
+      record.sequence.store(head + RING_SIZE, std::memory_order_release);
+      head++;
+
+      // Keep draining while the block has room
+      if (out.size() < 64 * BUFFER_SIZE)
+      {
+        continue;
+      }
+    }
+
+    if (not out.empty())
+    {
+      std::lock_guard<std::mutex> lock(out_mutex);
+      log_stream->write(out.data(), out.size());
+      log_stream->flush();
+      out.clear();
+    }
+
+    written.store(head, std::memory_order_release);
+
+    // Pairs with the increment in flush(): either flush() sees the count
+    // written before it waits, or it is seen waiting here and woken
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (flushing.load(std::memory_order_relaxed))
+    {
+      std::lock_guard<std::mutex> lock(wake_mutex);
+      drained.notify_all();
+    }
+
+    if (ready)
+    {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(wake_mutex);
+
+    sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    wake.wait(lock, [&] { return stop or is_ready(head); });
+    sleeping.store(false, std::memory_order_relaxed);
+
+    if (stop and not is_ready(head))
+    {
+      return;
+    }
   }
 }
 
 template<typename... Targs>
-void Log::message(std::stringstream &ss, const char* format, Targs... Fargs)
+void Log::message(Level level, const char* format, Targs... Fargs)
 {
-  snprintf(buffer, sizeof(buffer), format, Fargs...);
-  ss << buffer;
+  if (level >= this->level)
+  {
+    // Messages may come from several simulation threads, each formats into
+    // the record it claimed
+    Record &record = claim();
+    size_t pos = record.sequence.load(std::memory_order_relaxed);
+
+    record.level = level;
+    record.host = false;
+    record.stamped = cycles != nullptr;
+    record.cycle = cycles ? *cycles : 0;
+
+    if constexpr (sizeof...(Targs) == 0)
+    {
+      snprintf(record.text, sizeof(record.text), "%s", format);
+    }
+    else
+    {
+      snprintf(record.text, sizeof(record.text), format, Fargs...);
+    }
+
+    publish(record, pos);
+  }
 }
 
 #endif // LOG_H
@@ -1,190 +1,1931 @@
-// ----------------------------------------------------------------------------
-// Copyright (c) 2020-2024 RISC-V Steel contributors
-//
-// This work is licensed under the MIT License, see LICENSE file for details.
-// SPDX-License-Identifier: MIT
-// ----------------------------------------------------------------------------
-
-#include <stdlib.h>
-
-#include <fstream>
-#include <iostream>
-#include <signal.h>
-#include <string.h>
-
-#include <verilated_fst_c.h>
-
-#include "Vmcu_sim.h"
-#include "Vmcu_sim___024root.h"
-#include "argparse.h"
-#include "log.h"
-#include "ram_init.h"
-
-using Dut = Vmcu_sim;
-using Trace = VerilatedFstC;
-
-vluint64_t trace_time = 0;
-vluint64_t clk_cur_cycles = 0;
-vluint64_t clk_half_cycles = 2;
-Dut *dut = new Dut;
-Trace *trace = new Trace;
-Args args;
-
-static void open_trace(const char *out_wave_path)
-{
-  Verilated::traceEverOn(true);
-  dut->trace(trace, 99);
-  trace->set_time_resolution("1ns");
-  trace->set_time_unit("1ns");
-  trace->open(out_wave_path);
-}
-
-static void close_trace()
-{
-  if (trace->isOpen())
-  {
-    trace->dump(trace_time);
-    trace->close();
-  }
-}
-
-static void clk()
-{
-  static vluint64_t interval = 0;
-
-  if (trace_time >= interval)
-  {
-    dut->clock ^= 1;
-    interval = trace_time + clk_half_cycles;
-    clk_cur_cycles += dut->clock & 0x1;
-  }
-}
-
-static void eval(vluint64_t cycles_cnt = 1)
-{
-  while (cycles_cnt--)
-  {
-    clk();
-    dut->eval();
-    trace->dump(trace_time++);
-  }
-}
-
-static void reset_dut()
-{
-  dut->reset = 1;
-  eval(100);
-  dut->reset = 0;
-  dut->halt = 0;
-}
-
-static void set_clock_frequency(Dut *dut, uint32_t frequency)
-{
-  uint32_t clock_dut = dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__CLOCK_FREQUENCY;
-
-  Log::warning("Dut clock frequency: %u (Hz)", clock_dut);
-  Log::warning("MCU sim clock frequency: %u (ns)", frequency);
-
-  // Set clock frequency (freq/2)
-  clk_half_cycles = frequency / 2;
-}
-
-static void exit_app(int sig)
-{
-  (void)sig;
-  close_trace();
-  Log::info("Exit.");
-  std::exit(EXIT_SUCCESS);
-}
-
-static void ram_init(const char *path, RamInitVariants variants)
-{
-  if (not path)
-  {
-    return;
-  }
-
-  uint32_t ram_size = dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__MEMORY_SIZE;
-
-  switch (args.ram_init_variants)
-  {
-  case RamInitVariants::H32:
-    ram_init_h32(
-        args.ram_init_path, ram_size / 4,
-        [](uint32_t i, uint32_t v) {
-          dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_ram_instance__DOT__ram[i] = v;
-        });
-    break;
-
-  case RamInitVariants::BIN:
-    ram_init_bin(
-        args.ram_init_path, ram_size / 4,
-        [](uint32_t i, uint32_t v) {
-          dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_ram_instance__DOT__ram[i] = v;
-        });
-    break;
-  }
-}
-
-static bool is_host_out(uint32_t addr)
-{
-  static bool is_pos_edg = false;
-
-  bool is_write =
-      (addr != 0x0) &&
-      (not is_pos_edg and
-       dut->rootp
-           ->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_request) &&
-      (dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__rw_address ==
-       addr);
-
-  is_pos_edg =
-      dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_request;
-
-  return is_write;
-}
-
-int main(int argc, char *argv[])
-{
-  signal(SIGINT, exit_app);
-  signal(SIGKILL, exit_app);
-
-  // Default log level
-  Log::set_level(Log::DEBUG);
-  args = parser(argc, argv);
-
-  set_clock_frequency(dut, args.freq);
-
-  if (args.out_wave_path)
-  {
-    open_trace(args.out_wave_path);
-  }
-
-  reset_dut();
-
-  ram_init(args.ram_init_path, args.ram_init_variants);
-
-  while (true)
-  {
-    eval();
-
-    // --cycles
-    if (args.max_cycles)
-    {
-      if (clk_cur_cycles >= args.max_cycles)
-      {
-        Log::info("Exit: end cycles");
-        close_trace();
-        std::exit(EXIT_SUCCESS);
-      }
-    }
-
-    // --host-out
-    if (is_host_out(args.host_out))
-    {
-      Log::host_out(
-          (char)dut->rootp
-              ->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_data);
-    }
-  }
-}
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include <verilated_fst_c.h>
+#include <verilated_save.h>
+
+#include "Vmcu_sim.h"
+#include "Vmcu_sim___024root.h"
+#include "argparse.h"
+#include "commit_log.h"
+#include "cpi_stack.h"
+#include "flight_recorder.h"
+#include "functional_sim.h"
+#include "golden_model.h"
+#include "idle_loop.h"
+#include "log.h"
+#include "monitor.h"
+#include "profiler.h"
+#include "ram_init.h"
+#include "run_stats.h"
+#include "semihosting.h"
+#include "sparse_ram.h"
+#include "snapshot.h"
+
+using Dut = Vmcu_sim;
+using Trace = VerilatedFstC;
+
+vluint64_t trace_time = 0;
+vluint64_t clk_cur_cycles = 0;
+vluint64_t clk_half_cycles = 2;
+std::chrono::steady_clock::time_point run_start;
+vluint64_t run_start_cycles = 0;
+// Before the model is constructed, for the startup time of --stats
+std::chrono::steady_clock::time_point process_start = std::chrono::steady_clock::now();
+Dut *dut = new Dut;
+Trace *trace = new Trace;
+FlightRecorder recorder;
+SnapshotStore snapshots;
+IdleLoop idle_loop;
+Profiler profiler;
+CpiStack cpi_stack;
+CommitLog commit_log;
+GoldenModel golden_model;
+FunctionalSim functional_sim;
+Semihosting semihosting;
+RunStats run_stats;
+ElfSymbols elf_symbols;
+Args args;
+
+// Values of current_state in rvsteel_core.v
+static constexpr uint8_t CORE_STATE_RESET = 0x1;
+static constexpr uint8_t CORE_STATE_OPERATING = 0x2;
+static constexpr uint8_t CORE_STATE_TRAP_TAKEN = 0x4;
+static constexpr uint8_t CORE_STATE_TRAP_RETURN = 0x8;
+
+// NOP_INSTRUCTION of rvsteel_core.v, addi x0, x0, 0
+static constexpr uint32_t NOP = 0x00000013;
+
+// tx_bit_counter of rvsteel_uart.v right after a write to REG_WDATA
+static constexpr uint8_t UART_TX_BITS = 10;
+
+// --uart-fast polls stdin for input every so many cycles
+static constexpr vluint64_t UART_STDIN_POLL_CYCLES = 1024;
+
+// --functional returns to the harness every so many cycles, for stdin and the
+// exit conditions
+static constexpr uint64_t FUNCTIONAL_RUN_CYCLES = 1 << 16;
+
+// A --sample-window ends after this many cycles per instruction, should the
+// core stop retiring
+static constexpr uint64_t SAMPLE_MAX_CPI = 64;
+
+// Value of curr_state in rvsteel_spi.v when no transfer is in progress
+static constexpr uint8_t SPI_READY = 0x1;
+
+// --fast-forward only jumps over at least this many loop iterations, and over
+// at most this many cycles at once
+static constexpr uint64_t FAST_FORWARD_MIN_ITERATIONS = 16;
+static constexpr vluint64_t FAST_FORWARD_MAX_CYCLES = UINT32_MAX;
+
+// Cycles jumped over by --fast-forward
+static vluint64_t fast_forward_cycles = 0;
+static vluint64_t fast_forward_jumps = 0;
+
+// Windows of --sample-every run on the RTL
+static uint64_t sample_windows = 0;
+static uint64_t sample_instructions = 0;
+static uint64_t sample_cycles = 0;
+
+#ifdef RVSTEEL_MONITOR_DPI
+// From the events of the RTL
+static bool tohost_written = false;
+static uint32_t tohost_value = 0;
+static uint64_t retired_instructions = 0;
+#endif
+
+// Tracing modes of the simulation loop. The loop is instantiated once per mode
+// so the untraced variants carry no tracing cost at all.
+enum TraceMode
+{
+  TRACE_OFF,   // Tracing disabled
+  TRACE_ARMED, // Waiting for --trace-start / --trace-pc / --trace-addr
+  TRACE_ON     // Dumping every edge
+};
+
+static void open_trace(const char *out_wave_path)
+{
+  Verilated::traceEverOn(true);
+
+  // --trace-scope
+  if (args.trace_scope)
+  {
+    trace->dumpvars(99, args.trace_scope);
+  }
+
+  dut->trace(trace, 99);
+  trace->set_time_resolution("1ns");
+  trace->set_time_unit("1ns");
+  trace->open(out_wave_path);
+}
+
+static void close_trace()
+{
+  if (trace->isOpen())
+  {
+    trace->dump(trace_time);
+    trace->close();
+  }
+}
+
+#ifdef RVSTEEL_FLIGHT_RECORDER
+
+static void open_flight_recorder(uint32_t cycles)
+{
+  auto *root = dut->rootp;
+  const char *core = "mcu_sim.rvsteel_instance.rvsteel_core_instance";
+
+  recorder.add_signal("mcu_sim", "clock", 1, dut->clock);
+  recorder.add_signal("mcu_sim", "reset", 1, dut->reset);
+  recorder.add_signal("mcu_sim", "uart_rx", 1, dut->uart_rx);
+  recorder.add_signal("mcu_sim", "uart_tx", 1, dut->uart_tx);
+  recorder.add_signal(
+      core, "program_counter", 32,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__program_counter);
+  recorder.add_signal(
+      core, "current_state", 4,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__current_state);
+  recorder.add_signal(
+      core, "rw_address", 32,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__rw_address);
+  recorder.add_signal(
+      core, "read_data", 32,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__read_data);
+  recorder.add_signal(
+      core, "read_request", 1,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__read_request);
+  recorder.add_signal(
+      core, "read_response", 1,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__read_response);
+  recorder.add_signal(
+      core, "write_data", 32,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_data);
+  recorder.add_signal(
+      core, "write_strobe", 4,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_strobe);
+  recorder.add_signal(
+      core, "write_request", 1,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_request);
+  recorder.add_signal(
+      core, "write_response", 1,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_response);
+
+  // One sample per clock edge
+  recorder.start(2 * (size_t)cycles);
+}
+
+#else
+
+static void open_flight_recorder(uint32_t) {}
+
+#endif
+
+static void dump_flight_recorder(const char *reason)
+{
+  if (recorder.enabled())
+  {
+    Log::info("Flight recorder: %s", reason);
+    recorder.dump(args.wave_on_failure_path);
+  }
+}
+
+// Advance the model by one clock edge. The model only changes on a clock edge,
+// so it is evaluated exactly once per edge and trace_time jumps by half a
+// clock period, keeping the FST timestamps in nanoseconds.
+template <TraceMode MODE> static void edge()
+{
+  dut->clock ^= 1;
+  dut->eval();
+
+  if constexpr (MODE == TRACE_ON)
+  {
+    trace->dump(trace_time);
+  }
+
+  if (recorder.enabled())
+  {
+    recorder.sample(trace_time);
+  }
+
+  trace_time += clk_half_cycles;
+  clk_cur_cycles += dut->clock & 0x1;
+}
+
+template <TraceMode MODE> static void eval(vluint64_t edges_cnt = 1)
+{
+  while (edges_cnt--)
+  {
+    edge<MODE>();
+  }
+}
+
+static void print_run_rate()
+{
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - run_start;
+  double seconds = elapsed.count();
+  vluint64_t cycles = clk_cur_cycles - run_start_cycles;
+
+  Log::info("Simulated cycles: %" PRIu64 " in %.3f s (%.0f cycles/s)", (uint64_t)cycles, seconds,
+            seconds > 0 ? cycles / seconds : 0.0);
+
+  if (fast_forward_jumps)
+  {
+    Log::info("Fast-forward: %" PRIu64 " cycles in %" PRIu64 " jumps",
+              (uint64_t)fast_forward_cycles, (uint64_t)fast_forward_jumps);
+  }
+
+#ifdef RVSTEEL_MONITOR_DPI
+  Log::info("Retired instructions: %" PRIu64 " (IPC %.3f)", retired_instructions,
+            cycles ? (double)retired_instructions / cycles : 0.0);
+#endif
+}
+
+// --stats, from the RTL or from --functional
+static void write_stats(const char *exit_reason, int exit_code)
+{
+  auto *root = dut->rootp;
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - run_start;
+
+  run_stats.simulator = "mcu_sim";
+  run_stats.exit_reason = exit_reason;
+  run_stats.exit_code = exit_code;
+  run_stats.wall_seconds = elapsed.count();
+  run_stats.startup_seconds = std::chrono::duration<double>(run_start - process_start).count();
+  run_stats.cycles = clk_cur_cycles - run_start_cycles;
+  run_stats.host_out_bytes = Log::host_out_count();
+
+  if (args.functional)
+  {
+    FunctionalSim::State state = functional_sim.state();
+
+    run_stats.mcycle = state.mcycle;
+    run_stats.minstret = state.minstret;
+    run_stats.traps = functional_sim.traps();
+  }
+  else
+  {
+    run_stats.mcycle =
+        root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mcycle;
+    run_stats.minstret =
+        root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_minstret;
+  }
+
+  run_stats.write(args.stats_path);
+}
+
+// --profile, --cpi-stack, --commit-log, --lockstep and --stats
+static void write_reports(const char *exit_reason, int exit_code)
+{
+  if (args.profile_path)
+  {
+    profiler.write(args.profile_path);
+  }
+
+  if (args.cpi_stack_path)
+  {
+    cpi_stack.write(args.cpi_stack_path);
+  }
+
+  commit_log.close();
+
+  if (args.lockstep)
+  {
+    Log::info("Lockstep: %" PRIu64 " records checked", golden_model.records());
+  }
+
+  if (args.stats_path)
+  {
+    write_stats(exit_reason, exit_code);
+  }
+}
+
+template <TraceMode MODE> static void reset_dut()
+{
+  // Hold reset for 100ns
+  dut->reset = 1;
+  eval<MODE>((100 + clk_half_cycles - 1) / clk_half_cycles);
+  dut->reset = 0;
+  dut->halt = 0;
+}
+
+static void set_clock_frequency(Dut *dut, uint32_t frequency)
+{
+  uint32_t clock_dut = dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__CLOCK_FREQUENCY;
+
+  Log::warning("Dut clock frequency: %u (Hz)", clock_dut);
+  Log::warning("MCU sim clock frequency: %u (ns)", frequency);
+
+  // Set clock frequency (freq/2)
+  clk_half_cycles = frequency / 2;
+}
+
+static void exit_app(int sig)
+{
+  (void)sig;
+  dump_flight_recorder("SIGINT");
+  print_run_rate();
+  write_reports("sigint", EXIT_SUCCESS);
+  close_trace();
+  Log::info("Exit.");
+  std::exit(EXIT_SUCCESS);
+}
+
+// Words of the model RAM, held on the host in RVSTEEL_RAM_DPI builds
+static uint32_t *ram_words()
+{
+#ifdef RVSTEEL_RAM_DPI
+  void *ram =
+      dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_ram_instance__DOT__ram_handle;
+  return static_cast<SparseRam *>(ram)->data();
+#else
+  return &dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_ram_instance__DOT__ram[0];
+#endif
+}
+
+static void ram_dump_pages()
+{
+#ifdef RVSTEEL_RAM_DPI
+  // --ram-dump-pages
+  if (args.ram_dump_pages)
+  {
+    void *ram =
+        dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_ram_instance__DOT__ram_handle;
+    static_cast<SparseRam *>(ram)->dump_pages(args.ram_dump_pages);
+  }
+#endif
+}
+
+static void ram_init(const char *path, RamInitVariants variants, uint32_t *ram)
+{
+  if (not path)
+  {
+    return;
+  }
+
+  uint32_t ram_size = dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__MEMORY_SIZE;
+
+  switch (variants)
+  {
+  case RamInitVariants::H32:
+    ram_init_h32(path, ram, ram_size / 4);
+    break;
+
+  case RamInitVariants::BIN:
+    ram_init_bin(path, ram, ram_size / 4);
+    break;
+
+  case RamInitVariants::ELF:
+    elf_symbols = ram_init_elf(path, ram, ram_size / 4, args.host_out_symbol);
+    break;
+
+  case RamInitVariants::NONE:
+    break;
+  }
+
+  // --host-out-symbol
+  if (elf_symbols.host_out)
+  {
+    args.host_out = elf_symbols.host_out;
+    Log::info("Host out: 0x%x", args.host_out);
+  }
+
+  if (elf_symbols.tohost)
+  {
+    Log::info("tohost: 0x%x", elf_symbols.tohost);
+  }
+}
+
+// Set while replay() re-simulates cycles whose output was already seen
+static bool replaying = false;
+
+// Bytes given to the UART by --uart-fast, by the trace_time of the edge, so a
+// replay delivers the same bytes on the same edges instead of reading stdin
+static std::vector<std::pair<vluint64_t, uint8_t>> uart_rx_log;
+static size_t uart_rx_replay_pos = 0;
+
+#ifndef RVSTEEL_RAM_DPI
+
+// The model is verilated with --savable, so the checkpoint holds the complete
+// design state, RAM contents included, followed by the harness counters.
+static void save_checkpoint(const char *path)
+{
+  VerilatedSave os;
+  os.open(path);
+
+  if (not os.isOpen())
+  {
+    Log::error("Error file opening: %s", path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  os << trace_time << clk_cur_cycles << *dut;
+  os.close();
+
+  Log::info("Checkpoint saved: %s at cycle %" PRIu64, path, (uint64_t)clk_cur_cycles);
+}
+
+static void restore_checkpoint(const char *path)
+{
+  VerilatedRestore os;
+  os.open(path);
+
+  if (not os.isOpen())
+  {
+    Log::error("Error file opening: %s", path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  os >> trace_time >> clk_cur_cycles >> *dut;
+  os.close();
+
+  Log::info("Checkpoint restored: %s at cycle %" PRIu64, path, (uint64_t)clk_cur_cycles);
+}
+
+static void check_uart_fast();
+
+// One edge of a replay, with the hooks of run() that change the model
+template <TraceMode MODE> static void replay_edge()
+{
+  edge<MODE>();
+
+  if (args.uart_fast)
+  {
+    check_uart_fast();
+  }
+}
+
+// Re-simulates from the nearest snapshot before --replay-from up to the current
+// cycle, tracing from --replay-from on.
+static void replay()
+{
+  vluint64_t stop_cycle = clk_cur_cycles;
+
+  if (args.replay_from > stop_cycle)
+  {
+    Log::warning("Replay: cycle %" PRIu64 " not reached", args.replay_from);
+    return;
+  }
+
+  if (not snapshots.restore(args.replay_from, *dut, trace_time, clk_cur_cycles))
+  {
+    Log::warning("Replay: no snapshot before cycle %" PRIu64, args.replay_from);
+    return;
+  }
+
+  Log::info("Replay: from snapshot at cycle %" PRIu64, (uint64_t)clk_cur_cycles);
+
+  // The events were already seen
+  Monitor::set_enabled(false);
+  replaying = true;
+  uart_rx_replay_pos = std::lower_bound(uart_rx_log.begin(), uart_rx_log.end(),
+                                        std::make_pair(trace_time, (uint8_t)0)) -
+                       uart_rx_log.begin();
+
+  while (clk_cur_cycles < args.replay_from)
+  {
+    replay_edge<TRACE_OFF>();
+  }
+
+  open_trace(args.out_wave_path);
+
+  while (clk_cur_cycles < stop_cycle)
+  {
+    replay_edge<TRACE_ON>();
+  }
+
+  Log::info("Replay: traced cycles %" PRIu64 " to %" PRIu64, args.replay_from,
+            (uint64_t)stop_cycle);
+}
+
+static void take_snapshot()
+{
+  snapshots.take(*dut, trace_time, clk_cur_cycles);
+}
+
+static void check_snapshot()
+{
+  // --snapshot-every
+  if (clk_cur_cycles >= snapshots.next_cycle())
+  {
+    take_snapshot();
+  }
+}
+
+static void check_checkpoint()
+{
+  static bool saved = false;
+
+  // --save-checkpoint
+  if (args.save_checkpoint_path and not saved and clk_cur_cycles >= args.save_checkpoint_cycle)
+  {
+    saved = true;
+    save_checkpoint(args.save_checkpoint_path);
+  }
+}
+
+#else
+
+// The RAM of RVSTEEL_RAM_DPI builds is not part of the model, so it cannot be
+// checkpointed with it. The options are rejected at startup.
+static void restore_checkpoint(const char *) {}
+static void replay() {}
+static void take_snapshot() {}
+static void check_snapshot() {}
+static void check_checkpoint() {}
+
+#endif
+
+#ifndef RVSTEEL_MONITOR_DPI
+static bool is_host_out(uint32_t addr)
+{
+  static bool is_pos_edg = false;
+
+  bool is_write =
+      (addr != 0x0) &&
+      (not is_pos_edg and
+       dut->rootp
+           ->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_request) &&
+      (dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__rw_address ==
+       addr);
+
+  is_pos_edg =
+      dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_request;
+
+  return is_write;
+}
+#endif
+
+// Whether tohost from --ram-init-elf was written, and the value
+static bool is_tohost(uint32_t &value)
+{
+#ifdef RVSTEEL_MONITOR_DPI
+  // Set by the bus write monitor
+  value = tohost_value;
+  return tohost_written;
+#else
+  value =
+      dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_data;
+
+  return elf_symbols.tohost and
+         dut->rootp
+             ->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_request and
+         dut->rootp
+                 ->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__rw_address ==
+             elf_symbols.tohost;
+#endif
+}
+
+// Stops the simulation when one of the exit conditions is met
+static void check_exit()
+{
+  // --cycles
+  if (args.max_cycles)
+  {
+    if (clk_cur_cycles >= args.max_cycles)
+    {
+      Log::info("Exit: end cycles");
+      dump_flight_recorder("end cycles");
+      ram_dump_pages();
+      print_run_rate();
+      write_reports("end cycles", EXIT_SUCCESS);
+
+      if (args.replay_enable)
+      {
+        replay();
+      }
+
+      close_trace();
+      std::exit(EXIT_SUCCESS);
+    }
+  }
+
+  // tohost from --ram-init-elf, 1 means success
+  uint32_t value;
+
+  if (is_tohost(value))
+  {
+    Log::info("Exit: tohost 0x%x", value);
+
+    if (value != 1)
+    {
+      dump_flight_recorder("tohost");
+    }
+
+    int status = value == 1 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    ram_dump_pages();
+    print_run_rate();
+    write_reports("tohost", status);
+
+    if (args.replay_enable)
+    {
+      replay();
+    }
+
+    close_trace();
+    std::exit(status);
+  }
+}
+
+static void check_host_out()
+{
+#ifndef RVSTEEL_MONITOR_DPI
+  // --host-out
+  if (is_host_out(args.host_out))
+  {
+    Log::host_out(
+        (char)dut->rootp
+            ->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_data);
+  }
+#endif
+}
+
+// tohost and --host-out from the bus write monitor, and the count of retired
+// instructions, instead of polling the model after every edge
+static void start_monitor()
+{
+#ifdef RVSTEEL_MONITOR_DPI
+  Monitor::on_bus_write(
+      [](const Monitor::BusWrite &write)
+      {
+        if (elf_symbols.tohost and write.address == elf_symbols.tohost)
+        {
+          tohost_written = true;
+          tohost_value = write.data;
+        }
+
+        if (args.host_out and write.address == args.host_out)
+        {
+          Log::host_out((char)write.data);
+        }
+      });
+
+  Monitor::on_retire([](const Monitor::Retire &) { retired_instructions++; });
+#endif
+}
+
+// Host stdin, buffered for --uart-fast
+static uint8_t uart_stdin[4096];
+static size_t uart_stdin_size = 0;
+static size_t uart_stdin_pos = 0;
+static bool uart_stdin_eof = false;
+
+// Reads what stdin holds without blocking. Returns true when a byte is buffered.
+static bool uart_stdin_poll()
+{
+  if (uart_stdin_pos < uart_stdin_size)
+  {
+    return true;
+  }
+
+  pollfd fd{STDIN_FILENO, POLLIN, 0};
+
+  if (uart_stdin_eof or poll(&fd, 1, 0) <= 0)
+  {
+    return false;
+  }
+
+  ssize_t count = read(STDIN_FILENO, uart_stdin, sizeof(uart_stdin));
+  uart_stdin_eof = count <= 0;
+  uart_stdin_size = uart_stdin_eof ? 0 : count;
+  uart_stdin_pos = 0;
+
+  return not uart_stdin_eof;
+}
+
+// Returns the next byte of stdin, polled every UART_STDIN_POLL_CYCLES
+static bool uart_stdin_read(uint8_t &byte)
+{
+  static vluint64_t next_poll = 0;
+
+  if (uart_stdin_pos == uart_stdin_size)
+  {
+    if (clk_cur_cycles < next_poll)
+    {
+      return false;
+    }
+
+    next_poll = clk_cur_cycles + UART_STDIN_POLL_CYCLES;
+
+    if (not uart_stdin_poll())
+    {
+      return false;
+    }
+  }
+
+  byte = uart_stdin[uart_stdin_pos++];
+  return true;
+}
+
+#ifdef RVSTEEL_UART_FAST
+
+// The next byte for the UART: from stdin, or during a replay the byte the run
+// delivered on this edge
+static bool uart_rx_read(uint8_t &byte)
+{
+  if (replaying)
+  {
+    if (uart_rx_replay_pos == uart_rx_log.size() or
+        uart_rx_log[uart_rx_replay_pos].first != trace_time)
+    {
+      return false;
+    }
+
+    byte = uart_rx_log[uart_rx_replay_pos++].second;
+    return true;
+  }
+
+  if (not uart_stdin_read(byte))
+  {
+    return false;
+  }
+
+  if (args.replay_enable)
+  {
+    uart_rx_log.emplace_back(trace_time, byte);
+  }
+
+  return true;
+}
+
+// --uart-fast: a byte written to REG_WDATA goes to the host at once and the
+// UART reports ready on the next cycle instead of shifting out 10 bits. Bytes
+// from stdin are placed in REG_RDATA with the RX interrupt raised, as if the
+// whole frame had just been received.
+static void check_uart_fast()
+{
+  auto *root = dut->rootp;
+  auto &tx_bit_counter =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_uart_instance__DOT__tx_bit_counter;
+  auto &tx_cycle_counter =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_uart_instance__DOT__tx_cycle_counter;
+  auto &tx_register =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_uart_instance__DOT__tx_register;
+  auto &rx_data = root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_uart_instance__DOT__rx_data;
+  auto &uart_irq = root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_uart_instance__DOT__uart_irq;
+  auto &rx_active =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_uart_instance__DOT__rx_active;
+
+  if (tx_bit_counter == UART_TX_BITS and tx_cycle_counter == 0)
+  {
+    // Printed by the run already
+    if (not replaying)
+    {
+      Log::host_out((char)(tx_register >> 1));
+    }
+
+    // The last bit period ends on the next clock, the line stays idle
+    tx_register = 0x3ff;
+    tx_bit_counter = 1;
+    tx_cycle_counter = UINT32_MAX;
+  }
+
+  uint8_t byte;
+
+  if (not uart_irq and not rx_active and uart_rx_read(byte))
+  {
+    rx_data = byte;
+    uart_irq = 1;
+  }
+}
+
+#else
+
+static void check_uart_fast() {}
+
+#endif
+
+#ifdef RVSTEEL_FAST_FORWARD
+
+// Advances the timer and the core counters as if the idle loop had run for the
+// given number of iterations. The rest of the state is the same at the head of
+// every iteration.
+static void skip_iterations(uint64_t iterations)
+{
+  auto *root = dut->rootp;
+  uint64_t cycles = iterations * idle_loop.period();
+
+  if (root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_mtimer_instance__DOT__cr_en)
+  {
+    auto &mtime = root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_mtimer_instance__DOT__mtime;
+
+    mtime += cycles;
+    root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_mtimer_instance__DOT__mtime_plus_1 =
+        mtime + 1;
+  }
+
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mcycle += cycles;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_minstret +=
+      iterations * idle_loop.instructions();
+}
+
+// Cycles until something outside the idle loop happens: the timer interrupt,
+// the end of the run, a checkpoint or a snapshot. The GPIO inputs and the UART
+// RX line are constant in this harness.
+static vluint64_t fast_forward_horizon()
+{
+  auto *root = dut->rootp;
+  vluint64_t horizon = FAST_FORWARD_MAX_CYCLES;
+
+  // --cycles
+  if (args.max_cycles)
+  {
+    horizon = std::min<vluint64_t>(horizon, args.max_cycles - clk_cur_cycles);
+  }
+
+  // mtime reaching mtimecmp, unless the interrupt is already pending
+  uint64_t mtime = root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_mtimer_instance__DOT__mtime;
+  uint64_t mtimecmp =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_mtimer_instance__DOT__mtimecmp;
+
+  if (root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_mtimer_instance__DOT__cr_en and
+      not root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_mtimer_instance__DOT__irq and
+      mtimecmp > mtime)
+  {
+    horizon = std::min<vluint64_t>(horizon, mtimecmp - mtime);
+  }
+
+  // --save-checkpoint
+  if (args.save_checkpoint_path and args.save_checkpoint_cycle > clk_cur_cycles)
+  {
+    horizon = std::min<vluint64_t>(horizon, args.save_checkpoint_cycle - clk_cur_cycles);
+  }
+
+#ifndef RVSTEEL_RAM_DPI
+  // --snapshot-every
+  if (snapshots.next_cycle() > clk_cur_cycles)
+  {
+    horizon = std::min<vluint64_t>(horizon, snapshots.next_cycle() - clk_cur_cycles);
+  }
+#endif
+
+  return horizon;
+}
+
+#ifndef RVSTEEL_RAM_DPI
+
+// Whether the loop is left within two iterations once the given number of
+// iterations is skipped. Only the model runs, the harness counters are kept.
+static bool is_loop_exit(const std::vector<uint8_t> &state, uint64_t iterations)
+{
+  auto *root = dut->rootp;
+
+  {
+    SnapshotReader os(state);
+    os >> *dut;
+  }
+
+  skip_iterations(iterations);
+
+  for (uint32_t cycle = 0; cycle < 2 * idle_loop.period(); cycle++)
+  {
+    dut->clock ^= 1;
+    dut->eval();
+    dut->clock ^= 1;
+    dut->eval();
+
+    uint32_t pc =
+        root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__program_counter;
+
+    if (pc < idle_loop.first_pc() or pc > idle_loop.last_pc() or
+        root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_request or
+        root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__current_state ==
+            CORE_STATE_TRAP_TAKEN)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// A loop that polls the timer is left once enough time has passed. Finds the
+// largest skip, up to the given one, after which the model still runs the loop
+// for one more iteration, so the loop is left at the same cycle as without
+// fast-forward. Probing restores the model from an in-memory copy.
+static uint64_t find_loop_exit(uint64_t iterations)
+{
+  std::vector<uint8_t> state;
+
+  {
+    SnapshotWriter os(state);
+    os << *dut;
+  }
+
+  uint64_t low = 0;
+  uint64_t high = iterations;
+
+  // The probes are not part of the run
+  Monitor::set_enabled(false);
+
+  if (not is_loop_exit(state, iterations))
+  {
+    low = iterations;
+  }
+
+  while (high - low > 1)
+  {
+    uint64_t mid = low + (high - low) / 2;
+
+    if (is_loop_exit(state, mid))
+    {
+      high = mid;
+    }
+    else
+    {
+      low = mid;
+    }
+  }
+
+  Monitor::set_enabled(true);
+
+  SnapshotReader os(state);
+  os >> *dut;
+
+  return low;
+}
+
+#endif
+
+// --fast-forward: jumps over the iterations of an idle loop up to the next event
+static void check_fast_forward()
+{
+  auto *root = dut->rootp;
+
+  // One sample per cycle, after the rising edge
+  if (not dut->clock)
+  {
+    return;
+  }
+
+  if (not idle_loop.sample(
+          root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__program_counter,
+          root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_minstret,
+          root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__read_request,
+          root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_request,
+          root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__rw_address,
+          root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__instruction_rd_address,
+          &root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__integer_file[0]))
+  {
+    return;
+  }
+
+  // Peripherals that progress on their own must be idle
+  if (root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_uart_instance__DOT__tx_bit_counter or
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_uart_instance__DOT__rx_active or
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_spi_instance__DOT__curr_state !=
+          SPI_READY or
+      (args.uart_fast and uart_stdin_poll()))
+  {
+    return;
+  }
+
+  // The last iteration before the event is left to the model
+  uint64_t iterations = fast_forward_horizon() / idle_loop.period();
+  iterations = iterations ? iterations - 1 : 0;
+
+  if (idle_loop.reads_timer())
+  {
+#ifdef RVSTEEL_RAM_DPI
+    // The exit of the loop can only be found with a savable model
+    return;
+#else
+    iterations = find_loop_exit(iterations);
+#endif
+  }
+
+  idle_loop.reset();
+
+  if (iterations < FAST_FORWARD_MIN_ITERATIONS)
+  {
+    return;
+  }
+
+  vluint64_t cycles = iterations * idle_loop.period();
+
+  skip_iterations(iterations);
+  clk_cur_cycles += cycles;
+  trace_time += cycles * 2 * clk_half_cycles;
+  fast_forward_cycles += cycles;
+  fast_forward_jumps++;
+
+#ifdef RVSTEEL_MONITOR_DPI
+  retired_instructions += iterations * idle_loop.instructions();
+#endif
+
+  if (args.profile_path)
+  {
+    profiler.add_cycles(idle_loop.first_pc(), cycles);
+  }
+
+  if (args.cpi_stack_path)
+  {
+    cpi_stack.add_skipped(idle_loop.first_pc(), cycles, iterations * idle_loop.instructions());
+  }
+
+  Log::debug("Fast-forward: %" PRIu64 " cycles in the loop at 0x%x", (uint64_t)cycles,
+             idle_loop.first_pc());
+}
+
+#else
+
+static void check_fast_forward() {}
+
+#endif
+
+#ifdef RVSTEEL_CORE_TRACE
+
+// --profile: one sample per cycle, after the rising edge
+static void check_profile()
+{
+  auto *root = dut->rootp;
+
+  if (dut->clock)
+  {
+    profiler.sample(
+        root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__program_counter,
+        root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__current_state);
+  }
+}
+
+// Register written in the cycle, if any
+static void read_rd_write(CommitRecord &record)
+{
+  auto *root = dut->rootp;
+  uint8_t rd =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__instruction_rd_address;
+
+  if (rd and
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__integer_file_write_enable)
+  {
+    record.rd_write = true;
+    record.rd = rd;
+    record.rd_value =
+        root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__writeback_multiplexer_output;
+  }
+}
+
+// The instruction retired or the trap taken in the cycle. Returns false when
+// the cycle has neither.
+static bool read_commit(const CoreCycle &cycle, CommitRecord &record)
+{
+  auto *root = dut->rootp;
+  CpiStack::Category category = CpiStack::classify(cycle);
+
+  // The trapped instruction can still write its register in the cycle before
+  static CommitRecord trap;
+
+  if (category == CpiStack::TRAP and cycle.state != CORE_STATE_TRAP_TAKEN)
+  {
+    trap = CommitRecord{};
+    read_rd_write(trap);
+    return false;
+  }
+
+  if (category == CpiStack::TRAP and cycle.state == CORE_STATE_TRAP_TAKEN)
+  {
+    record = trap;
+    record.trap = true;
+    record.cause =
+        root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mcause;
+    record.epc = root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mepc;
+    trap = CommitRecord{};
+    return true;
+  }
+
+  if (category != CpiStack::RETIRED)
+  {
+    return false;
+  }
+
+  record = CommitRecord{};
+  record.pc = cycle.pc;
+  record.instruction =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__instruction;
+  read_rd_write(record);
+
+  // A load or store commits in its second cycle
+  record.load =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__load_commit_cycle;
+  record.store =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__store_commit_cycle;
+
+  if (record.load or record.store)
+  {
+    // sb, sh and sw from funct3
+    uint32_t size = 1 << ((record.instruction >> 12) & 0x3);
+
+    record.address =
+        root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__target_address_adder;
+    record.store_value =
+        root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__rs2_data;
+    record.store_value &= size == 4 ? UINT32_MAX : (1u << (8 * size)) - 1;
+  }
+
+  return true;
+}
+
+// --lockstep: stops at the first record that differs from the golden model
+static void check_lockstep(const CommitRecord &record)
+{
+  if (golden_model.check(record))
+  {
+    return;
+  }
+
+  Log::error("Lockstep: %s", golden_model.error().c_str());
+  dump_flight_recorder("lockstep mismatch");
+  print_run_rate();
+  write_reports("lockstep mismatch", EXIT_FAILURE);
+  close_trace();
+  std::exit(EXIT_FAILURE);
+}
+
+// --cpi-stack, --commit-log and --lockstep: one sample per cycle, after the
+// falling edge
+static void check_core_cycle()
+{
+  auto *root = dut->rootp;
+
+  if (dut->clock)
+  {
+    return;
+  }
+
+  CoreCycle cycle{
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__program_counter,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__current_state,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__halt,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__take_trap,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__load_pending,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__store_pending,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__prev_load_request,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__prev_read_request,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__prev_write_request,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__read_response,
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_response
+  };
+
+  if (args.cpi_stack_path)
+  {
+    cpi_stack.sample(cycle);
+  }
+
+  CommitRecord record;
+
+  if ((commit_log.is_open() or args.lockstep) and read_commit(cycle, record))
+  {
+    if (commit_log.is_open())
+    {
+      commit_log.write(record);
+    }
+
+    if (args.lockstep)
+    {
+      check_lockstep(record);
+    }
+  }
+}
+
+#else
+
+static void check_profile() {}
+static void check_core_cycle() {}
+
+#endif
+
+static void check_trap()
+{
+#ifdef RVSTEEL_FLIGHT_RECORDER
+  static bool trap_recorded = false;
+
+  // --wave-on-failure: dump the cycles that led to the first trap
+  if (recorder.enabled() and not trap_recorded and
+      dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__current_state ==
+          CORE_STATE_TRAP_TAKEN)
+  {
+    trap_recorded = true;
+    dump_flight_recorder("trap taken");
+  }
+#endif
+
+#ifdef RVSTEEL_CORE_TRACE
+  static bool trap_taken = false;
+
+  // --stats: mcause is written on the edge that leaves the trap state
+  if (args.stats_path and dut->clock)
+  {
+    bool in_trap =
+        dut->rootp
+            ->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__current_state ==
+        CORE_STATE_TRAP_TAKEN;
+
+    if (trap_taken and not in_trap)
+    {
+      run_stats.count_trap(
+          dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mcause);
+    }
+
+    trap_taken = in_trap;
+  }
+#endif
+}
+
+#ifdef RVSTEEL_SEMIHOSTING
+
+// --semihosting: services the call when the ebreak of the sequence is in the
+// core, before the rising edge that would take the trap. The ebreak is turned
+// into a nop where the core reads it, the RAM output or the instruction held
+// by a stall, and a0 gets the result. An interrupt taken at the ebreak goes
+// first, the call is made when the handler returns to it.
+static void check_semihosting()
+{
+  auto *root = dut->rootp;
+  auto &read_data =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_ram_instance__DOT__read_data;
+  auto &prev_instruction =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__prev_instruction;
+  auto &integer_file =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__integer_file;
+
+  if (dut->clock or
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__instruction !=
+          Semihosting::EBREAK or
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__current_state !=
+          CORE_STATE_OPERATING)
+  {
+    return;
+  }
+
+  uint32_t pc =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__program_counter;
+  uint32_t words = root->mcu_sim__DOT__rvsteel_instance__DOT__MEMORY_SIZE / 4;
+  uint32_t *ram = ram_words();
+
+  if (not Semihosting::is_call(ram, words, pc))
+  {
+    return;
+  }
+
+  uint32_t saved_read_data = read_data;
+  uint32_t saved_prev_instruction = prev_instruction;
+
+  read_data = read_data == Semihosting::EBREAK ? NOP : read_data;
+  prev_instruction = prev_instruction == Semihosting::EBREAK ? NOP : prev_instruction;
+  dut->eval();
+
+  if (root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__take_trap)
+  {
+    read_data = saved_read_data;
+    prev_instruction = saved_prev_instruction;
+    dut->eval();
+    return;
+  }
+
+  uint64_t time_ns = clk_cur_cycles * 2 * clk_half_cycles;
+  uint32_t a0 = semihosting.call(ram, words, integer_file[9], integer_file[10], time_ns);
+
+  integer_file[9] = a0;
+
+  if (args.lockstep)
+  {
+    golden_model.host_call(a0, ram, semihosting.written_address(), semihosting.written_size());
+  }
+
+  if (semihosting.exited())
+  {
+    Log::info("Exit: semihosting %d", semihosting.exit_code());
+
+    if (semihosting.exit_code() != EXIT_SUCCESS)
+    {
+      dump_flight_recorder("semihosting exit");
+    }
+
+    ram_dump_pages();
+    print_run_rate();
+    write_reports("semihosting", semihosting.exit_code());
+    close_trace();
+    std::exit(semihosting.exit_code());
+  }
+}
+
+#else
+
+static void check_semihosting() {}
+
+#endif
+
+static bool is_trace_trigger()
+{
+  // --trace-start
+  if (clk_cur_cycles < args.trace_start)
+  {
+    return false;
+  }
+
+#ifdef RVSTEEL_TRACE_TRIGGER
+  // --trace-pc
+  if (args.trace_pc_enable)
+  {
+    return dut->rootp
+               ->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__program_counter ==
+           args.trace_pc;
+  }
+
+  // --trace-addr
+  if (args.trace_addr_enable)
+  {
+    return dut->rootp
+               ->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__write_request &&
+           dut->rootp
+                   ->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__rw_address ==
+               args.trace_addr;
+  }
+#endif
+
+  return true;
+}
+
+static bool is_trace_stop(vluint64_t trace_start_cycle)
+{
+  // --trace-stop
+  if (args.trace_stop and clk_cur_cycles >= args.trace_stop)
+  {
+    return true;
+  }
+
+  // --trace-cycles
+  return args.trace_cycles and (clk_cur_cycles - trace_start_cycle >= args.trace_cycles);
+}
+
+// Runs the simulation loop. The TRACE_ARMED and TRACE_ON variants return when
+// the trace window opens or closes, TRACE_OFF only leaves through check_exit().
+template <TraceMode MODE> static void run()
+{
+  vluint64_t trace_start_cycle = clk_cur_cycles;
+
+  while (true)
+  {
+    eval<MODE>();
+    check_snapshot();
+    check_checkpoint();
+    check_exit();
+    check_trap();
+    check_host_out();
+
+    if (args.semihosting)
+    {
+      check_semihosting();
+    }
+
+    if (args.profile_path)
+    {
+      check_profile();
+    }
+
+    if (args.cpi_stack_path or args.commit_log_path or args.lockstep)
+    {
+      check_core_cycle();
+    }
+
+    if (args.uart_fast)
+    {
+      check_uart_fast();
+    }
+
+    if constexpr (MODE == TRACE_OFF)
+    {
+      if (args.fast_forward)
+      {
+        check_fast_forward();
+      }
+    }
+
+    if constexpr (MODE == TRACE_ARMED)
+    {
+      if (is_trace_trigger())
+      {
+        return;
+      }
+    }
+
+    if constexpr (MODE == TRACE_ON)
+    {
+      if (is_trace_stop(trace_start_cycle))
+      {
+        return;
+      }
+    }
+  }
+}
+
+// Ends a --functional run
+static void exit_functional(const char *exit_reason, int status)
+{
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - run_start;
+  double seconds = elapsed.count();
+  uint64_t instructions = functional_sim.instructions();
+
+  print_run_rate();
+  Log::info("Functional: %" PRIu64 " instructions (%.1f MIPS), %" PRIu64
+            " blocks decoded, %" PRIu64 " dropped by stores",
+            instructions, seconds > 0 ? instructions / seconds / 1e6 : 0.0,
+            functional_sim.blocks_decoded(), functional_sim.blocks_invalidated());
+
+  // --sample-every
+  if (sample_instructions)
+  {
+    double cpi = (double)sample_cycles / sample_instructions;
+
+    Log::info("Sampled: %" PRIu64 " windows of %" PRIu64 " instructions, CPI %.3f",
+              sample_windows, sample_instructions, cpi);
+    Log::info("Estimated cycles: %.0f", instructions * cpi);
+  }
+
+  if (args.stats_path)
+  {
+    write_stats(exit_reason, status);
+  }
+
+  std::exit(status);
+}
+
+#ifdef RVSTEEL_SAMPLING
+
+// Loads the state of --functional into the RTL. The core leaves reset through
+// a trap return to pc, which fetches from mepc and sets mstatus.MIE from MPIE,
+// so mepc and MPIE get their values once it is done. The peripherals get their
+// registers, a transfer in progress in the model has already completed.
+static void load_functional_state()
+{
+  auto *root = dut->rootp;
+  FunctionalSim::State state = functional_sim.state();
+  uint32_t ram_size = root->mcu_sim__DOT__rvsteel_instance__DOT__MEMORY_SIZE;
+
+  reset_dut<TRACE_OFF>();
+
+  // Up to the first rising edge out of reset
+  while (root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__reset_reg or
+         dut->clock)
+  {
+    edge<TRACE_OFF>();
+  }
+
+  std::copy(functional_sim.ram_words(), functional_sim.ram_words() + ram_size / 4, ram_words());
+
+  for (int i = 1; i < 32; i++)
+  {
+    root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__integer_file[i - 1] =
+        state.x[i];
+  }
+
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__current_state =
+      CORE_STATE_TRAP_RETURN;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mepc = state.pc;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mstatus_mpie =
+      state.mstatus_mie;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mie_mfie =
+      state.mie >> 16;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mie_meie =
+      (state.mie >> 11) & 0x1;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mie_mtie =
+      (state.mie >> 7) & 0x1;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mie_msie =
+      (state.mie >> 3) & 0x1;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mtvec = state.mtvec;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mscratch =
+      state.mscratch;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mcause =
+      state.mcause;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mtval = state.mtval;
+
+  uint64_t now = functional_sim.cycles();
+  uint64_t mtime = functional_sim.mtimer.mtime(now);
+
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_mtimer_instance__DOT__cr_en =
+      functional_sim.mtimer.enabled();
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_mtimer_instance__DOT__mtime = mtime;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_mtimer_instance__DOT__mtime_plus_1 =
+      mtime + 1;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_mtimer_instance__DOT__mtimecmp =
+      functional_sim.mtimer.compare();
+
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_uart_instance__DOT__rx_data =
+      functional_sim.uart.data();
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_uart_instance__DOT__uart_irq =
+      functional_sim.uart.irq();
+
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_gpio_instance__DOT__oe =
+      functional_sim.gpio.output_enable();
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_gpio_instance__DOT__out =
+      functional_sim.gpio.output();
+
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_spi_instance__DOT__cpol =
+      functional_sim.spi.clock_polarity();
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_spi_instance__DOT__cpha =
+      functional_sim.spi.clock_phase();
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_spi_instance__DOT__chip_select =
+      functional_sim.spi.selected();
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_spi_instance__DOT__clock_div =
+      functional_sim.spi.clock_divider();
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_spi_instance__DOT__rx_reg =
+      functional_sim.spi.data();
+
+  // The trap return
+  eval<TRACE_OFF>(2);
+
+  if (root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__program_counter !=
+      state.pc)
+  {
+    Log::error("Sample: the core did not return to pc 0x%x", state.pc);
+    std::exit(EXIT_FAILURE);
+  }
+
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mepc = state.mepc;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mstatus_mpie =
+      state.mstatus_mpie;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_mcycle = state.mcycle;
+  root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_minstret =
+      state.minstret;
+}
+
+// --sample-every: runs --sample-window instructions on the RTL from the state
+// of --functional. The functional simulation goes on from its own state.
+static void run_sample()
+{
+  auto *root = dut->rootp;
+  auto &minstret =
+      root->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__csr_minstret;
+
+  load_functional_state();
+
+  // The window is not part of the run of --functional
+  Monitor::set_enabled(false);
+
+  uint64_t start_instret = minstret;
+  vluint64_t start_cycle = clk_cur_cycles;
+  vluint64_t max_cycle = start_cycle + args.sample_window * SAMPLE_MAX_CPI;
+
+  while (minstret - start_instret < args.sample_window and clk_cur_cycles < max_cycle)
+  {
+    eval<TRACE_OFF>(2);
+  }
+
+  uint64_t instructions = minstret - start_instret;
+  uint64_t cycles = clk_cur_cycles - start_cycle;
+
+  sample_windows++;
+  sample_instructions += instructions;
+  sample_cycles += cycles;
+
+  Monitor::set_enabled(true);
+
+  Log::info("Sample %" PRIu64 ": instructions %" PRIu64 " to %" PRIu64 ", %" PRIu64
+            " cycles, CPI %.3f",
+            sample_windows, functional_sim.instructions(),
+            functional_sim.instructions() + instructions, cycles,
+            instructions ? (double)cycles / instructions : 0.0);
+
+  clk_cur_cycles = functional_sim.cycles();
+}
+
+#else
+
+static void run_sample() {}
+
+#endif
+
+// --functional: runs the program on the instruction set simulator instead of
+// the RTL. The UART behaves as with --uart-fast.
+static void run_functional()
+{
+  auto *root = dut->rootp;
+
+  functional_sim.start(root->mcu_sim__DOT__rvsteel_instance__DOT__BOOT_ADDRESS,
+                       root->mcu_sim__DOT__rvsteel_instance__DOT__MEMORY_SIZE,
+                       root->mcu_sim__DOT__rvsteel_instance__DOT__GPIO_WIDTH);
+  ram_init(args.ram_init_path, args.ram_init_variants, functional_sim.ram_words());
+  functional_sim.set_host_out(args.host_out);
+  functional_sim.set_tohost(elf_symbols.tohost);
+
+  // --semihosting
+  if (args.semihosting)
+  {
+    functional_sim.set_semihosting(&semihosting, 2 * clk_half_cycles);
+  }
+
+  run_start = std::chrono::steady_clock::now();
+  run_start_cycles = 0;
+
+  // --sample-start and --sample-every, in instructions
+  bool sampling = args.sample_start or args.sample_every;
+  uint64_t next_sample = args.sample_start ? args.sample_start : args.sample_every;
+
+  while (true)
+  {
+    uint64_t stop_cycle = functional_sim.cycles() + FUNCTIONAL_RUN_CYCLES;
+
+    // --cycles
+    if (args.max_cycles)
+    {
+      stop_cycle = std::min<uint64_t>(stop_cycle, args.max_cycles);
+    }
+
+    // Every instruction takes at least a cycle. The run stops after the block
+    // that reaches the sample point.
+    if (sampling)
+    {
+      uint64_t instructions = functional_sim.instructions();
+
+      stop_cycle = std::min<uint64_t>(
+          stop_cycle, functional_sim.cycles() + next_sample - std::min(next_sample, instructions));
+    }
+
+    FunctionalSim::Stop stop = functional_sim.run(stop_cycle);
+    clk_cur_cycles = functional_sim.cycles();
+
+    // tohost from --ram-init-elf, 1 means success
+    if (stop == FunctionalSim::STOP_TOHOST)
+    {
+      uint32_t value = functional_sim.tohost_value();
+
+      Log::info("Exit: tohost 0x%x", value);
+      exit_functional("tohost", value == 1 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    if (stop == FunctionalSim::STOP_EXIT)
+    {
+      Log::info("Exit: semihosting %d", semihosting.exit_code());
+      exit_functional("semihosting", semihosting.exit_code());
+    }
+
+    if (sampling and functional_sim.instructions() >= next_sample)
+    {
+      run_sample();
+      next_sample = args.sample_every ? next_sample + args.sample_every : UINT64_MAX;
+    }
+
+    if (args.max_cycles and clk_cur_cycles >= args.max_cycles)
+    {
+      Log::info("Exit: end cycles");
+      exit_functional("end cycles", EXIT_SUCCESS);
+    }
+
+    uint8_t byte;
+
+    if (not functional_sim.uart.irq() and uart_stdin_read(byte))
+    {
+      functional_sim.uart.receive(byte);
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  signal(SIGINT, exit_app);
+  signal(SIGKILL, exit_app);
+
+  // Default log level
+  Log::set_level(Log::DEBUG);
+  args = parser(argc, argv);
+
+  // Messages are stamped with the simulated cycle from here on
+  Log::set_cycles(&clk_cur_cycles);
+
+  set_clock_frequency(dut, args.freq);
+
+  // The UART RX line idles high
+  dut->uart_rx = 1;
+
+  // The signals of these options are only public in the model when built with them
+#ifndef RVSTEEL_FLIGHT_RECORDER
+  if (args.wave_on_failure)
+  {
+    Log::error("--wave-on-failure needs a RVSTEEL_FLIGHT_RECORDER build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+#ifndef RVSTEEL_TRACE_TRIGGER
+  if (args.trace_pc_enable or args.trace_addr_enable)
+  {
+    Log::error("--trace-pc and --trace-addr need a RVSTEEL_TRACE_TRIGGER build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+#ifndef RVSTEEL_CORE_TRACE
+  if (args.profile_path or args.cpi_stack_path or args.commit_log_path or args.lockstep)
+  {
+    Log::error("--profile, --cpi-stack, --commit-log and --lockstep need a RVSTEEL_CORE_TRACE "
+               "build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+#ifndef RVSTEEL_UART_FAST
+  if (args.uart_fast)
+  {
+    Log::error("--uart-fast needs a RVSTEEL_UART_FAST build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+#ifndef RVSTEEL_FAST_FORWARD
+  if (args.fast_forward)
+  {
+    Log::error("--fast-forward needs a RVSTEEL_FAST_FORWARD build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+#ifndef RVSTEEL_SAMPLING
+  if (args.sample_start or args.sample_every)
+  {
+    Log::error("--sample-start and --sample-every need a RVSTEEL_SAMPLING build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+#ifndef RVSTEEL_SEMIHOSTING
+  // --functional services the calls in the instruction set simulator
+  if (args.semihosting and not args.functional)
+  {
+    Log::error("--semihosting needs a RVSTEEL_SEMIHOSTING build, or --functional");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+  // --functional does not simulate the RTL
+  if (args.functional and
+      (args.out_wave_path or args.wave_on_failure or args.save_checkpoint_path or
+       args.restore_checkpoint_path or args.snapshot_every or args.replay_enable or
+       args.fast_forward or args.profile_path or args.cpi_stack_path or args.commit_log_path or
+       args.lockstep or args.ram_file_path or args.ram_dump_pages))
+  {
+    Log::error("--functional cannot be used with options that need the RTL");
+    std::exit(EXIT_FAILURE);
+  }
+
+  if ((args.sample_start or args.sample_every) and not args.functional)
+  {
+    Log::error("--sample-start and --sample-every require --functional");
+    std::exit(EXIT_FAILURE);
+  }
+
+  if (args.functional)
+  {
+    run_functional();
+  }
+
+  if (args.fast_forward)
+  {
+    idle_loop.set_map(dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__MEMORY_SIZE, MTIMER_START,
+                      MTIMER_SIZE);
+  }
+
+#ifdef RVSTEEL_RAM_DPI
+  if (args.save_checkpoint_path or args.restore_checkpoint_path or args.snapshot_every or
+      args.replay_enable)
+  {
+    Log::error("Checkpoints and snapshots are not available in RVSTEEL_RAM_DPI builds");
+    std::exit(EXIT_FAILURE);
+  }
+
+  // --ram-file, before the first eval opens the RAM
+  SparseRam::backing_path = args.ram_file_path;
+#else
+  if (args.ram_file_path or args.ram_dump_pages)
+  {
+    Log::error("--ram-file and --ram-dump-pages need a RVSTEEL_RAM_DPI build");
+    std::exit(EXIT_FAILURE);
+  }
+#endif
+
+  // The golden model starts from reset
+  if (args.lockstep and args.restore_checkpoint_path)
+  {
+    Log::error("--lockstep cannot be used with --restore-checkpoint");
+    std::exit(EXIT_FAILURE);
+  }
+
+  if (args.replay_enable and not args.out_wave_path)
+  {
+    Log::error("--replay-from requires --out-wave");
+    std::exit(EXIT_FAILURE);
+  }
+
+  // The calls act on the host, on files and stdin, and cannot be made a second time
+  if (args.replay_enable and args.semihosting)
+  {
+    Log::error("--replay-from cannot be used with --semihosting");
+    std::exit(EXIT_FAILURE);
+  }
+
+  // With --replay-from the wave is only written by the replay at exit
+  const char *out_wave_path = args.replay_enable ? nullptr : args.out_wave_path;
+
+  if (out_wave_path)
+  {
+    open_trace(out_wave_path);
+  }
+
+  if (args.wave_on_failure)
+  {
+    open_flight_recorder(args.wave_on_failure);
+  }
+
+  // Trace from reset unless a trace window or trigger is requested
+  bool trace_from_reset = out_wave_path and (args.trace_start == 0) and
+                          not args.trace_pc_enable and not args.trace_addr_enable;
+
+  if (args.restore_checkpoint_path)
+  {
+    // --restore-checkpoint replaces reset and RAM init
+    restore_checkpoint(args.restore_checkpoint_path);
+  }
+  else
+  {
+    if (trace_from_reset)
+    {
+      reset_dut<TRACE_ON>();
+    }
+    else
+    {
+      reset_dut<TRACE_OFF>();
+    }
+
+    ram_init(args.ram_init_path, args.ram_init_variants, ram_words());
+  }
+
+  start_monitor();
+
+  run_start = std::chrono::steady_clock::now();
+  run_start_cycles = clk_cur_cycles;
+
+  if (args.cpi_stack_path)
+  {
+    cpi_stack.start(elf_symbols.functions);
+  }
+
+  if (args.commit_log_path)
+  {
+    commit_log.open(args.commit_log_path);
+  }
+
+#ifdef RVSTEEL_CORE_TRACE
+  if (args.lockstep)
+  {
+    golden_model.start(
+        dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__rvsteel_core_instance__DOT__program_counter,
+        ram_words(), dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__MEMORY_SIZE / 4);
+  }
+#endif
+
+  if (args.profile_path)
+  {
+    profiler.start(elf_symbols.functions, ram_words(),
+                   dut->rootp->mcu_sim__DOT__rvsteel_instance__DOT__MEMORY_SIZE / 4);
+  }
+
+  if (args.snapshot_every or args.replay_enable)
+  {
+    snapshots.start(args.snapshot_every, (size_t)args.snapshot_mem << 20);
+    take_snapshot();
+  }
+
+  if (not out_wave_path)
+  {
+    run<TRACE_OFF>();
+  }
+
+  if (not trace_from_reset)
+  {
+    run<TRACE_ARMED>();
+  }
+
+  Log::info("Trace start: cycle %" PRIu64, (uint64_t)clk_cur_cycles);
+  run<TRACE_ON>();
+
+  Log::info("Trace stop: cycle %" PRIu64, (uint64_t)clk_cur_cycles);
+  close_trace();
+  run<TRACE_OFF>();
+}
@@ -0,0 +1,71 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Events the RTL reports through DPI-C when built with RVSTEEL_MONITOR_DPI:
+// the writes of the manager on the bus and the instructions the core retires.
+// The subscribers are called from eval(), on the rising edge of the event and
+// only when it happens, instead of every feature polling the model after
+// every edge.
+class Monitor
+{
+  public:
+    struct BusWrite
+    {
+      uint32_t address;
+      uint32_t data;
+      uint8_t strobe;
+    };
+
+    struct Retire
+    {
+      uint32_t pc;
+      uint32_t instruction;
+    };
+
+    using BusWriteHandler = std::function<void(const BusWrite &)>;
+    using RetireHandler = std::function<void(const Retire &)>;
+
+    static void on_bus_write(BusWriteHandler handler)
+    {
+      get_instance().bus_write_handlers.push_back(std::move(handler));
+    }
+
+    static void on_retire(RetireHandler handler)
+    {
+      get_instance().retire_handlers.push_back(std::move(handler));
+    }
+
+    // Events are dropped while disabled, e.g. while the model is replayed
+    static void set_enabled(bool enabled)
+    {
+      get_instance().enabled = enabled;
+    }
+
+    // From the DPI-C imports
+    static void bus_write(const BusWrite &write);
+    static void retire(const Retire &retire);
+
+  private:
+    std::vector<BusWriteHandler> bus_write_handlers;
+    std::vector<RetireHandler> retire_handlers;
+    bool enabled{true};
+
+    static Monitor &get_instance()
+    {
+      static Monitor instance;
+      return instance;
+    }
+};
+
+#endif // MONITOR_H
@@ -0,0 +1,190 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "peripherals.h"
+
+#include "log.h"
+
+// Register maps of rvsteel_uart.v, rvsteel_mtimer.v, rvsteel_gpio.v and
+// rvsteel_spi.v
+static constexpr uint32_t UART_REG_WDATA = 0x00;
+static constexpr uint32_t UART_REG_RDATA = 0x04;
+static constexpr uint32_t UART_REG_READY = 0x08;
+static constexpr uint32_t UART_REG_RXSTATUS = 0x0c;
+
+static constexpr uint32_t MTIMER_REG_CR = 0x00;
+static constexpr uint32_t MTIMER_REG_MTIMEL = 0x04;
+static constexpr uint32_t MTIMER_REG_MTIMEH = 0x08;
+static constexpr uint32_t MTIMER_REG_MTIMECMPL = 0x0c;
+static constexpr uint32_t MTIMER_REG_MTIMECMPH = 0x10;
+
+static constexpr uint32_t GPIO_REG_IN = 0x00;
+static constexpr uint32_t GPIO_REG_OE = 0x04;
+static constexpr uint32_t GPIO_REG_OUT = 0x08;
+static constexpr uint32_t GPIO_REG_CLR = 0x0c;
+static constexpr uint32_t GPIO_REG_SET = 0x10;
+
+static constexpr uint32_t SPI_REG_CPOL = 0x00;
+static constexpr uint32_t SPI_REG_CPHA = 0x04;
+static constexpr uint32_t SPI_REG_CHIP_SELECT = 0x08;
+static constexpr uint32_t SPI_REG_CLOCK_CONF = 0x0c;
+static constexpr uint32_t SPI_REG_WDATA = 0x10;
+static constexpr uint32_t SPI_REG_RDATA = 0x14;
+static constexpr uint32_t SPI_REG_BUSY = 0x18;
+
+// The timer, GPIO and SPI registers only take word writes
+static constexpr uint32_t STROBE_WORD = 0xf;
+
+uint32_t UartModel::read(uint32_t offset)
+{
+  switch (offset)
+  {
+  case UART_REG_RDATA:
+    rx_irq = false;
+    return rx_data;
+
+  case UART_REG_READY: return 1;
+  case UART_REG_RXSTATUS: return rx_irq;
+  default: return 0;
+  }
+}
+
+void UartModel::write(uint32_t offset, uint32_t value)
+{
+  if (offset == UART_REG_WDATA)
+  {
+    Log::host_out((char)value);
+  }
+}
+
+void UartModel::receive(uint8_t byte)
+{
+  rx_data = byte;
+  rx_irq = true;
+}
+
+uint32_t MtimerModel::read(uint32_t offset, uint64_t now) const
+{
+  switch (offset)
+  {
+  case MTIMER_REG_CR: return cr_en;
+  case MTIMER_REG_MTIMEL: return mtime(now);
+  case MTIMER_REG_MTIMEH: return mtime(now) >> 32;
+  case MTIMER_REG_MTIMECMPL: return mtimecmp;
+  case MTIMER_REG_MTIMECMPH: return mtimecmp >> 32;
+  default: return 0;
+  }
+}
+
+void MtimerModel::write(uint32_t offset, uint32_t value, uint32_t strobe, uint64_t now)
+{
+  if (strobe != STROBE_WORD)
+  {
+    return;
+  }
+
+  uint64_t current = mtime(now);
+
+  switch (offset)
+  {
+  case MTIMER_REG_CR:
+    cr_en = value & 0x1;
+    mtime_at = current;
+    since = now;
+    break;
+
+  // The other half is taken from mtime + 1, as in the Verilog
+  case MTIMER_REG_MTIMEL:
+    mtime_at = ((current + 1) & 0xffffffff00000000) | value;
+    since = now;
+    break;
+
+  case MTIMER_REG_MTIMEH:
+    mtime_at = ((uint64_t)value << 32) | (uint32_t)(current + 1);
+    since = now;
+    break;
+
+  case MTIMER_REG_MTIMECMPL: mtimecmp = (mtimecmp & 0xffffffff00000000) | value; break;
+  case MTIMER_REG_MTIMECMPH: mtimecmp = ((uint64_t)value << 32) | (uint32_t)mtimecmp; break;
+  default: break;
+  }
+}
+
+void GpioModel::start(uint32_t width)
+{
+  *this = GpioModel();
+  mask = width >= 32 ? UINT32_MAX : (1u << width) - 1;
+}
+
+uint32_t GpioModel::read(uint32_t offset) const
+{
+  switch (offset)
+  {
+  case GPIO_REG_OE: return oe;
+  case GPIO_REG_OUT: return out;
+  default: return 0;
+  }
+}
+
+void GpioModel::write(uint32_t offset, uint32_t value, uint32_t strobe)
+{
+  if (strobe != STROBE_WORD)
+  {
+    return;
+  }
+
+  uint32_t prev_out = out;
+  value &= mask;
+
+  switch (offset)
+  {
+  case GPIO_REG_OE: oe = value; break;
+  case GPIO_REG_OUT: out = value; break;
+  case GPIO_REG_CLR: out &= ~value; break;
+  case GPIO_REG_SET: out |= value; break;
+  default: break;
+  }
+
+  if (out != prev_out)
+  {
+    Log::debug("GPIO out: 0x%x", out);
+  }
+}
+
+uint32_t SpiModel::read(uint32_t offset) const
+{
+  switch (offset)
+  {
+  case SPI_REG_CPOL: return cpol;
+  case SPI_REG_CPHA: return cpha;
+  case SPI_REG_CHIP_SELECT: return chip_select;
+  case SPI_REG_CLOCK_CONF: return clock_div;
+  case SPI_REG_RDATA: return rx_data;
+  case SPI_REG_BUSY: return 0;
+  default: return 0xdeadbeef;
+  }
+}
+
+void SpiModel::write(uint32_t offset, uint32_t value, uint32_t strobe)
+{
+  if (strobe != STROBE_WORD)
+  {
+    return;
+  }
+
+  switch (offset)
+  {
+  case SPI_REG_CPOL: cpol = value & 0x1; break;
+  case SPI_REG_CPHA: cpha = value & 0x1; break;
+  case SPI_REG_CHIP_SELECT: chip_select = value; break;
+  case SPI_REG_CLOCK_CONF: clock_div = value; break;
+
+  // Eight bits of poci are shifted in
+  case SPI_REG_WDATA: rx_data = 0; break;
+  default: break;
+  }
+}
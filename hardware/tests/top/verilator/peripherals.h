@@ -0,0 +1,162 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef PERIPHERALS_H
+#define PERIPHERALS_H
+
+#include <cstdint>
+
+// Memory map of rvsteel.v. The RAM starts at 0.
+static constexpr uint32_t UART_START = 0x80000000;
+static constexpr uint32_t UART_SIZE = 16;
+static constexpr uint32_t MTIMER_START = 0x80010000;
+static constexpr uint32_t MTIMER_SIZE = 32;
+static constexpr uint32_t GPIO_START = 0x80020000;
+static constexpr uint32_t GPIO_SIZE = 32;
+static constexpr uint32_t SPI_START = 0x80030000;
+static constexpr uint32_t SPI_SIZE = 32;
+
+// C++ models of the peripherals of rvsteel.v for --functional. The registers
+// and their reset values follow the Verilog, what takes time there, a UART
+// frame or an SPI transfer, is done at once. Offsets are word aligned and the
+// write data is on its byte lanes, as on the bus.
+
+class UartModel
+{
+  public:
+    // Reading REG_RDATA clears the RX interrupt
+    uint32_t read(uint32_t offset);
+
+    // A byte written to REG_WDATA goes to the host at once
+    void write(uint32_t offset, uint32_t value);
+
+    // Places a byte in REG_RDATA and raises the interrupt, as a received frame
+    void receive(uint8_t byte);
+
+    bool irq() const
+    {
+      return rx_irq;
+    }
+
+    // REG_RDATA without clearing the interrupt
+    uint8_t data() const
+    {
+      return rx_data;
+    }
+
+    // The core took the interrupt
+    void irq_response()
+    {
+      rx_irq = false;
+    }
+
+  private:
+    uint8_t rx_data{0};
+    bool rx_irq{false};
+};
+
+// mtime counts the cycles of the caller while enabled, so it is only computed
+// when read
+class MtimerModel
+{
+  public:
+    uint32_t read(uint32_t offset, uint64_t now) const;
+    void write(uint32_t offset, uint32_t value, uint32_t strobe, uint64_t now);
+
+    bool irq(uint64_t now) const
+    {
+      return mtime(now) >= mtimecmp;
+    }
+
+    bool enabled() const
+    {
+      return cr_en;
+    }
+
+    uint64_t mtime(uint64_t now) const
+    {
+      return cr_en ? mtime_at + (now - since) : mtime_at;
+    }
+
+    uint64_t compare() const
+    {
+      return mtimecmp;
+    }
+
+  private:
+    bool cr_en{false};
+    uint64_t mtime_at{0}; // mtime at cycle since
+    uint64_t since{0};
+    uint64_t mtimecmp{UINT64_MAX};
+};
+
+// The inputs are low in this harness
+class GpioModel
+{
+  public:
+    void start(uint32_t width);
+
+    uint32_t read(uint32_t offset) const;
+    void write(uint32_t offset, uint32_t value, uint32_t strobe);
+
+    uint32_t output_enable() const
+    {
+      return oe;
+    }
+
+    uint32_t output() const
+    {
+      return out;
+    }
+
+  private:
+    uint32_t mask{0};
+    uint32_t oe{0};
+    uint32_t out{0};
+};
+
+// poci is low in this harness, so every transfer receives 0
+class SpiModel
+{
+  public:
+    uint32_t read(uint32_t offset) const;
+    void write(uint32_t offset, uint32_t value, uint32_t strobe);
+
+    bool clock_polarity() const
+    {
+      return cpol;
+    }
+
+    bool clock_phase() const
+    {
+      return cpha;
+    }
+
+    uint8_t selected() const
+    {
+      return chip_select;
+    }
+
+    uint8_t clock_divider() const
+    {
+      return clock_div;
+    }
+
+    uint8_t data() const
+    {
+      return rx_data;
+    }
+
+  private:
+    bool cpol{false};
+    bool cpha{false};
+    uint8_t chip_select{0xff};
+    uint8_t clock_div{0};
+    uint8_t rx_data{0};
+};
+
+#endif // PERIPHERALS_H
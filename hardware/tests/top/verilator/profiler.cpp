@@ -0,0 +1,369 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "log.h"
+
+// Values of current_state in rvsteel_core.v
+static constexpr uint8_t STATE_OPERATING = 0x2;
+static constexpr uint8_t STATE_TRAP_TAKEN = 0x4;
+static constexpr uint8_t STATE_TRAP_RETURN = 0x8;
+
+static constexpr uint32_t OPCODE_JAL = 0x6f;
+static constexpr uint32_t OPCODE_JALR = 0x67;
+
+// Calls deeper than this are not tracked, e.g. when a task switch leaves the
+// stack unbalanced
+static constexpr uint32_t MAX_DEPTH = 256;
+
+// Addresses listed after the flat profile
+static constexpr size_t HOT_ADDRESSES = 20;
+
+static FILE *open_file(const char *path)
+{
+  FILE *file = fopen(path, "w");
+
+  if (!file)
+  {
+    Log::error("Error file opening: %s", path);
+    std::exit(EXIT_FAILURE);
+  }
+
+  return file;
+}
+
+void Profiler::start(const std::vector<ElfFunction> &functions, const uint32_t *ram,
+                     uint32_t words)
+{
+  this->functions = functions;
+  this->ram = ram;
+  this->words = words;
+
+  if (functions.empty())
+  {
+    Log::warning("Profile without ELF symbols, every cycle is [unknown]");
+  }
+
+  // A label extends to the next symbol
+  for (size_t i = 0; i < functions.size(); i++)
+  {
+    uint32_t start = functions[i].address / 4;
+    uint32_t end = functions[i].size ? (functions[i].address + functions[i].size + 3) / 4
+                   : i + 1 < functions.size() ? functions[i + 1].address / 4
+                                              : start + 1;
+
+    end = std::min(end, words);
+
+    if (start >= end)
+    {
+      continue;
+    }
+
+    if (end > function_at.size())
+    {
+      function_at.resize(end, functions.size());
+    }
+
+    std::fill(function_at.begin() + start, function_at.begin() + end, i);
+  }
+
+  pc_cycles.assign(function_at.size(), 0);
+  calls.assign(functions.size() + 1, 0);
+  nodes.push_back({UINT32_MAX, ROOT, 0, 0});
+}
+
+// Index in functions, functions.size() when pc is in none
+uint32_t Profiler::function_of(uint32_t pc) const
+{
+  return pc / 4 < function_at.size() ? function_at[pc / 4] : functions.size();
+}
+
+uint32_t Profiler::child(uint32_t parent, uint32_t function)
+{
+  uint64_t key = (uint64_t)parent << 32 | function;
+  auto it = children.find(key);
+
+  if (it != children.end())
+  {
+    return it->second;
+  }
+
+  uint32_t node = nodes.size();
+  nodes.push_back({function, parent, nodes[parent].depth + 1, 0});
+  children.emplace(key, node);
+
+  return node;
+}
+
+// Node of the frame for code in function, which is the frame itself unless
+// the function was reached by a jump rather than a call
+uint32_t Profiler::current_leaf(uint32_t function)
+{
+  if (leaf_frame != frame or leaf_function != function)
+  {
+    leaf = nodes[frame].function == function ? frame : child(frame, function);
+    leaf_frame = frame;
+    leaf_function = function;
+  }
+
+  return leaf;
+}
+
+void Profiler::call(uint32_t pc, uint32_t target)
+{
+  uint32_t parent = current_leaf(function_of(pc));
+  uint32_t function = function_of(target);
+
+  calls[function]++;
+
+  if (nodes[parent].depth < MAX_DEPTH)
+  {
+    frame = child(parent, function);
+  }
+}
+
+void Profiler::ret()
+{
+  if (frame != ROOT)
+  {
+    frame = nodes[frame].parent;
+  }
+}
+
+// The instruction at pc completed and the program counter moved to target
+void Profiler::retire(uint32_t pc, uint32_t target)
+{
+  if (pc / 4 >= words)
+  {
+    return;
+  }
+
+  uint32_t instruction = ram[pc / 4];
+  uint32_t opcode = instruction & 0x7f;
+  uint32_t rd = (instruction >> 7) & 0x1f;
+  uint32_t rs1 = (instruction >> 15) & 0x1f;
+  bool rd_link = rd == 1 or rd == 5;
+  bool rs1_link = rs1 == 1 or rs1 == 5;
+
+  if (opcode == OPCODE_JAL)
+  {
+    if (rd_link)
+    {
+      call(pc, target);
+    }
+  }
+  else if (opcode == OPCODE_JALR)
+  {
+    // A jalr that both reads and writes a different link register is a
+    // coroutine swap: return, then call
+    if (rd_link and rs1_link and rd != rs1)
+    {
+      ret();
+      call(pc, target);
+    }
+    else if (rd_link)
+    {
+      call(pc, target);
+    }
+    else if (rs1_link)
+    {
+      ret();
+    }
+  }
+}
+
+void Profiler::sample(uint32_t pc, uint8_t state)
+{
+  if (prev_state == STATE_TRAP_TAKEN and state != STATE_TRAP_TAKEN)
+  {
+    // First cycle of the trap handler
+    call(prev_pc, pc);
+  }
+  else if (prev_state == STATE_TRAP_RETURN and state != STATE_TRAP_RETURN)
+  {
+    // Back from mret
+    ret();
+  }
+  else if (pc != prev_pc and prev_state == STATE_OPERATING and state == STATE_OPERATING)
+  {
+    retire(prev_pc, pc);
+  }
+
+  prev_pc = pc;
+  prev_state = state;
+
+  add_cycles(pc, 1);
+}
+
+void Profiler::add_cycles(uint32_t pc, uint64_t cycles)
+{
+  nodes[current_leaf(function_of(pc))].cycles += cycles;
+
+  if (pc / 4 < pc_cycles.size())
+  {
+    pc_cycles[pc / 4] += cycles;
+  }
+  else
+  {
+    other_cycles += cycles;
+  }
+}
+
+void Profiler::write(const char *path) const
+{
+  write_flat(path);
+  write_folded((std::string(path) + ".folded").c_str());
+
+  Log::info("Ok profile: %s", path);
+}
+
+void Profiler::write_flat(const char *path) const
+{
+  size_t count = functions.size() + 1;
+  std::vector<uint64_t> self(count, 0);
+  std::vector<uint64_t> total(count, 0);
+  std::vector<uint64_t> subtree(nodes.size(), 0);
+  uint64_t cycles = 0;
+
+  // Children come after their parent in nodes
+  for (size_t n = nodes.size(); n-- > 1;)
+  {
+    subtree[n] += nodes[n].cycles;
+    subtree[nodes[n].parent] += subtree[n];
+    self[nodes[n].function] += nodes[n].cycles;
+    cycles += nodes[n].cycles;
+  }
+
+  // Recursive calls count once in the total of the function
+  for (size_t n = 1; n < nodes.size(); n++)
+  {
+    uint32_t ancestor = nodes[n].parent;
+
+    while (ancestor != ROOT and nodes[ancestor].function != nodes[n].function)
+    {
+      ancestor = nodes[ancestor].parent;
+    }
+
+    if (ancestor == ROOT)
+    {
+      total[nodes[n].function] += subtree[n];
+    }
+  }
+
+  std::vector<uint32_t> order;
+
+  for (uint32_t f = 0; f < count; f++)
+  {
+    if (total[f] or calls[f])
+    {
+      order.push_back(f);
+    }
+  }
+
+  std::stable_sort(order.begin(), order.end(),
+                   [&](uint32_t a, uint32_t b) { return self[a] > self[b]; });
+
+  FILE *file = open_file(path);
+  double percent = cycles ? 100.0 / cycles : 0.0;
+  uint64_t cumulative = 0;
+
+  fprintf(file, "Flat profile, %llu cycles\n\n", (unsigned long long)cycles);
+  fprintf(file, "     %%    cumulative         self        total      calls  name\n");
+  fprintf(file, "  time        cycles       cycles       cycles\n");
+
+  for (uint32_t f : order)
+  {
+    cumulative += self[f];
+    fprintf(file, "%6.2f  %12llu %12llu %12llu %10llu  %s\n", self[f] * percent,
+            (unsigned long long)cumulative, (unsigned long long)self[f],
+            (unsigned long long)total[f], (unsigned long long)calls[f], name(f));
+  }
+
+  // Hottest addresses, the offset is from the start of the function
+  std::vector<uint32_t> hot;
+
+  for (uint32_t word = 0; word < pc_cycles.size(); word++)
+  {
+    if (pc_cycles[word])
+    {
+      hot.push_back(word);
+    }
+  }
+
+  size_t listed = std::min(hot.size(), HOT_ADDRESSES);
+  std::partial_sort(hot.begin(), hot.begin() + listed, hot.end(),
+                    [&](uint32_t a, uint32_t b) { return pc_cycles[a] > pc_cycles[b]; });
+
+  fprintf(file, "\nHot addresses\n\n");
+  fprintf(file, "   address       cycles  time  function\n");
+
+  for (size_t i = 0; i < listed; i++)
+  {
+    uint32_t pc = hot[i] * 4;
+    uint32_t f = function_of(pc);
+
+    fprintf(file, "0x%08x %12llu %5.2f  %s", pc, (unsigned long long)pc_cycles[hot[i]],
+            pc_cycles[hot[i]] * percent, name(f));
+
+    if (f < functions.size())
+    {
+      fprintf(file, "+0x%x", pc - functions[f].address);
+    }
+
+    fprintf(file, "\n");
+  }
+
+  if (other_cycles)
+  {
+    fprintf(file, "\nOutside the symbols: %llu cycles\n", (unsigned long long)other_cycles);
+  }
+
+  fclose(file);
+}
+
+// One line per stack, the function names from the outermost call separated
+// by ';', then the cycles with the program counter in the innermost one
+void Profiler::write_folded(const char *path) const
+{
+  FILE *file = open_file(path);
+  std::vector<uint32_t> stack;
+
+  for (uint32_t n = 1; n < nodes.size(); n++)
+  {
+    if (nodes[n].cycles == 0)
+    {
+      continue;
+    }
+
+    stack.clear();
+
+    for (uint32_t node = n; node != ROOT; node = nodes[node].parent)
+    {
+      stack.push_back(nodes[node].function);
+    }
+
+    for (size_t i = stack.size(); i-- > 0;)
+    {
+      fprintf(file, "%s%c", name(stack[i]), i ? ';' : ' ');
+    }
+
+    fprintf(file, "%llu\n", (unsigned long long)nodes[n].cycles);
+  }
+
+  fclose(file);
+}
+
+const char *Profiler::name(uint32_t function) const
+{
+  return function < functions.size() ? functions[function].name.c_str() : "[unknown]";
+}
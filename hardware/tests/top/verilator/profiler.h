@@ -0,0 +1,82 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "ram_init.h"
+
+// Attributes every clock cycle to the program counter and to a shadow call
+// stack. Calls and returns are the jal/jalr instructions that write or read a
+// link register (x1 or x5), as in the RISC-V return address prediction hints.
+// Traps push the handler, mret pops it.
+class Profiler
+{
+  public:
+    // functions as resolved by ram_init_elf(). ram holds the program, read to
+    // decode the instructions that change the program counter.
+    void start(const std::vector<ElfFunction> &functions, const uint32_t *ram, uint32_t words);
+
+    // Called once per clock cycle with the program counter and the state of
+    // the core
+    void sample(uint32_t pc, uint8_t state);
+
+    // Cycles spent at pc that were not sampled, e.g. jumped over by the harness
+    void add_cycles(uint32_t pc, uint64_t cycles);
+
+    // Writes the flat profile to path, and the stacks to path.folded in the
+    // format read by flamegraph.pl and speedscope
+    void write(const char *path) const;
+
+  private:
+    static constexpr uint32_t ROOT = 0;
+
+    struct Node
+    {
+      uint32_t function;
+      uint32_t parent;
+      uint32_t depth;
+      uint64_t cycles; // With the program counter in this function
+    };
+
+    std::vector<ElfFunction> functions;
+    const uint32_t *ram{nullptr};
+    uint32_t words{0};
+
+    // Function and cycles of every word of code, up to the end of the last function
+    std::vector<uint32_t> function_at;
+    std::vector<uint64_t> pc_cycles;
+    uint64_t other_cycles{0};
+
+    std::vector<Node> nodes;
+    std::unordered_map<uint64_t, uint32_t> children;
+    std::vector<uint64_t> calls;
+
+    uint32_t frame{ROOT};
+    uint32_t leaf{ROOT};
+    uint32_t leaf_frame{UINT32_MAX};
+    uint32_t leaf_function{UINT32_MAX};
+    uint32_t prev_pc{UINT32_MAX};
+    uint8_t prev_state{0};
+
+    uint32_t function_of(uint32_t pc) const;
+    uint32_t child(uint32_t parent, uint32_t function);
+    uint32_t current_leaf(uint32_t function);
+    void call(uint32_t pc, uint32_t target);
+    void ret();
+    void retire(uint32_t pc, uint32_t target);
+    void write_flat(const char *path) const;
+    void write_folded(const char *path) const;
+    const char *name(uint32_t function) const;
+};
+
+#endif // PROFILER_H
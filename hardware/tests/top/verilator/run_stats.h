@@ -0,0 +1,41 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef RUN_STATS_H
+#define RUN_STATS_H
+
+#include <cstdint>
+#include <map>
+
+// Summary of a run for --stats, written as one JSON object at exit. The keys
+// only ever get added to, so the dashboards that read them keep working.
+struct RunStats
+{
+    const char *simulator{""}; // Name of the harness, e.g. "mcu_sim"
+    const char *exit_reason{""};
+    int exit_code{0};
+
+    double wall_seconds{0.0};
+    double startup_seconds{0.0}; // From the start of the process to the first simulated cycle
+    uint64_t cycles{0}; // Simulated, since the run started
+    uint64_t mcycle{0};
+    uint64_t minstret{0};
+
+    uint64_t host_out_bytes{0};
+
+    // Traps taken, by mcause
+    std::map<uint32_t, uint64_t> traps;
+
+    void count_trap(uint32_t mcause)
+    {
+      traps[mcause]++;
+    }
+
+    void write(const char *path) const;
+};
+
+#endif // RUN_STATS_H
@@ -0,0 +1,113 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef SEMIHOSTING_H
+#define SEMIHOSTING_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// RISC-V semihosting for --semihosting. The sequence
+//
+//   slli x0, x0, 0x1f
+//   ebreak
+//   srai x0, x0, 7
+//
+// asks the host for the operation in a0 with the parameter in a1, a pointer to
+// a block of words for most operations, and returns the result in a0. The
+// buffers are read from and written to the RAM of the simulator directly.
+//
+// SYS_OPEN, SYS_CLOSE, SYS_WRITEC, SYS_WRITE0, SYS_WRITE, SYS_READ, SYS_CLOCK,
+// SYS_EXIT and SYS_EXIT_EXTENDED are serviced. The ":tt" file is the console:
+// stdin for reading, the --host-out text for writing.
+class Semihosting
+{
+  public:
+    static constexpr uint32_t SLLI_X0 = 0x01f01013;
+    static constexpr uint32_t EBREAK = 0x00100073;
+    static constexpr uint32_t SRAI_X0 = 0x40705013;
+
+    static constexpr uint32_t SYS_OPEN = 0x01;
+    static constexpr uint32_t SYS_CLOSE = 0x02;
+    static constexpr uint32_t SYS_WRITEC = 0x03;
+    static constexpr uint32_t SYS_WRITE0 = 0x04;
+    static constexpr uint32_t SYS_WRITE = 0x05;
+    static constexpr uint32_t SYS_READ = 0x06;
+    static constexpr uint32_t SYS_CLOCK = 0x10;
+    static constexpr uint32_t SYS_EXIT = 0x18;
+    static constexpr uint32_t SYS_EXIT_EXTENDED = 0x20;
+
+    Semihosting() = default;
+    Semihosting(const Semihosting &) = delete;
+    Semihosting &operator=(const Semihosting &) = delete;
+    ~Semihosting();
+
+    // Whether the ebreak at pc sits between the slli and the srai of the
+    // sequence
+    static bool is_call(const uint32_t *ram, uint32_t words, uint32_t pc);
+
+    // Services the call and returns the new a0. time_ns is the simulated time
+    // since reset, for SYS_CLOCK.
+    uint32_t call(uint32_t *ram, uint32_t words, uint32_t a0, uint32_t a1, uint64_t time_ns);
+
+    // SYS_EXIT or SYS_EXIT_EXTENDED was called
+    bool exited() const
+    {
+      return exit_called;
+    }
+
+    int exit_code() const
+    {
+      return exit_status;
+    }
+
+    // RAM bytes written by the last call, for the models that keep a copy
+    uint32_t written_address() const
+    {
+      return written_start;
+    }
+
+    uint32_t written_size() const
+    {
+      return written_bytes;
+    }
+
+  private:
+    static constexpr uint32_t ERROR = UINT32_MAX;
+    static constexpr uint32_t ADP_STOPPED_APPLICATION_EXIT = 0x20026;
+
+    struct File
+    {
+      FILE *file;
+      bool console; // ":tt", never closed
+    };
+
+    std::vector<File> files; // Handle - 1, a closed one has no file
+
+    uint8_t *ram{nullptr};
+    uint32_t ram_size{0};
+
+    bool exit_called{false};
+    int exit_status{0};
+
+    uint32_t written_start{0};
+    uint32_t written_bytes{0};
+
+    bool in_ram(uint32_t address, uint32_t size) const;
+    bool read_block(uint32_t address, uint32_t *block, uint32_t count) const;
+    File *file(uint32_t handle);
+
+    uint32_t sys_open(uint32_t parameter);
+    uint32_t sys_close(uint32_t parameter);
+    uint32_t sys_write0(uint32_t address);
+    uint32_t sys_write(uint32_t parameter);
+    uint32_t sys_read(uint32_t parameter);
+    uint32_t sys_exit(uint32_t reason, uint32_t subcode);
+};
+
+#endif // SEMIHOSTING_H
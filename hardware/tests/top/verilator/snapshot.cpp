@@ -0,0 +1,98 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+#include "log.h"
+
+SnapshotWriter::SnapshotWriter(std::vector<uint8_t> &data) : data(data)
+{
+  data.clear();
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+  // The destructor of VerilatedSerialize no longer reaches this override
+  flush();
+}
+
+void SnapshotWriter::flush()
+{
+  data.insert(data.end(), m_bufp, m_cp);
+  m_cp = m_bufp;
+}
+
+SnapshotReader::SnapshotReader(const std::vector<uint8_t> &data) : data(data)
+{
+  m_endp = m_bufp;
+}
+
+void SnapshotReader::fill()
+{
+  // The unread bytes move to the start of the buffer, the rest is read anew
+  size_t unread = m_endp - m_cp;
+  size_t size = std::min(bufferSize() - unread, data.size() - pos);
+
+  std::memmove(m_bufp, m_cp, unread);
+  std::memcpy(m_bufp + unread, data.data() + pos, size);
+
+  m_cp = m_bufp;
+  m_endp = m_bufp + unread + size;
+  pos += size;
+}
+
+void SnapshotStore::start(uint64_t interval, size_t budget)
+{
+  this->interval = interval;
+  this->budget = budget;
+  snapshots.clear();
+  used = 0;
+  next = UINT64_MAX;
+}
+
+void SnapshotStore::add(Snapshot &&snapshot)
+{
+  used += snapshot.data.size();
+  snapshots.push_back(std::move(snapshot));
+
+  // Keep the first snapshot and every other one after it
+  while (used > budget and snapshots.size() > 1)
+  {
+    std::vector<Snapshot> kept;
+    used = 0;
+
+    for (size_t i = 0; i < snapshots.size(); i += 2)
+    {
+      used += snapshots[i].data.size();
+      kept.push_back(std::move(snapshots[i]));
+    }
+
+    snapshots = std::move(kept);
+    interval *= 2;
+    Log::debug("Snapshots: memory budget reached, interval now %" PRIu64 " cycles", interval);
+  }
+
+  next = interval ? snapshots.back().cycle + interval : UINT64_MAX;
+}
+
+const std::vector<uint8_t> *SnapshotStore::find(uint64_t cycle) const
+{
+  // Snapshots are in cycle order
+  for (auto it = snapshots.rbegin(); it != snapshots.rend(); it++)
+  {
+    if (it->cycle <= cycle)
+    {
+      return &it->data;
+    }
+  }
+
+  return nullptr;
+}
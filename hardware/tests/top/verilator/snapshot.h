@@ -0,0 +1,108 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include <verilated_save.h>
+
+// Serializes a --savable model into a byte vector. Verilator fills its own
+// buffer and calls flush() when it is full and at the end, which appends the
+// buffer to the vector: no file, no extra copy of the state.
+class SnapshotWriter : public VerilatedSerialize
+{
+  public:
+    explicit SnapshotWriter(std::vector<uint8_t> &data);
+    ~SnapshotWriter() override;
+
+    void flush() override;
+
+  private:
+    std::vector<uint8_t> &data;
+};
+
+// Restores a --savable model from a byte vector written by SnapshotWriter.
+// fill() tops the buffer of Verilator up from the vector.
+class SnapshotReader : public VerilatedDeserialize
+{
+  public:
+    explicit SnapshotReader(const std::vector<uint8_t> &data);
+
+    void fill() override;
+
+  private:
+    const std::vector<uint8_t> &data;
+    size_t pos{0};
+};
+
+// Periodic in-memory snapshots of the model within a memory budget. When the
+// budget is exceeded every other snapshot is dropped and the interval doubled,
+// so the snapshots keep covering the whole run at a coarser granularity.
+class SnapshotStore
+{
+  public:
+    // interval in cycles, 0 keeps only the snapshots taken explicitly
+    void start(uint64_t interval, size_t budget);
+
+    // Cycle of the next periodic snapshot
+    uint64_t next_cycle() const
+    {
+      return next;
+    }
+
+    template <typename Model> void take(Model &model, uint64_t time, uint64_t cycle)
+    {
+      Snapshot snapshot{cycle, {}};
+
+      {
+        SnapshotWriter os(snapshot.data);
+        os << time << cycle << model;
+      }
+
+      add(std::move(snapshot));
+    }
+
+    // Restores the latest snapshot taken at or before the given cycle.
+    // Returns false when there is none.
+    template <typename Model>
+    bool restore(uint64_t cycle, Model &model, uint64_t &time, uint64_t &cur_cycle) const
+    {
+      const std::vector<uint8_t> *data = find(cycle);
+
+      if (not data)
+      {
+        return false;
+      }
+
+      SnapshotReader os(*data);
+      os >> time >> cur_cycle >> model;
+
+      return true;
+    }
+
+  private:
+    struct Snapshot
+    {
+      uint64_t cycle;
+      std::vector<uint8_t> data;
+    };
+
+    std::vector<Snapshot> snapshots;
+    uint64_t interval{0};
+    uint64_t next{UINT64_MAX};
+    size_t budget{0};
+    size_t used{0};
+
+    void add(Snapshot &&snapshot);
+    const std::vector<uint8_t> *find(uint64_t cycle) const;
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,67 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef SPARSE_RAM_H
+#define SPARSE_RAM_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Host memory of rvsteel_ram when verilated with -DRVSTEEL_RAM_DPI. The whole
+// RAM is reserved as one mapping but the pages are only allocated by the OS on
+// first write, so untouched memory costs nothing and reads as zero. With a
+// backing file the RAM is a shared mapping of that file instead.
+class SparseRam
+{
+  public:
+    static constexpr size_t PAGE_SIZE = 4096;
+
+    // File mapped by the next RAM opened, nullptr for anonymous memory
+    static const char *backing_path;
+
+    explicit SparseRam(uint32_t words);
+    ~SparseRam();
+
+    uint32_t *data() const
+    {
+      return ram;
+    }
+
+    uint32_t size() const
+    {
+      return words;
+    }
+
+    uint32_t read(uint32_t address) const
+    {
+      return address < words ? ram[address] : 0;
+    }
+
+    void write(uint32_t address, uint32_t data, uint32_t strobe)
+    {
+      if (address >= words)
+      {
+        return;
+      }
+
+      uint32_t mask = STROBE_MASK[strobe & 0xf];
+      ram[address] = (ram[address] & ~mask) | (data & mask);
+    }
+
+    // Writes the allocated, non-zero pages in h32 format, each one preceded by
+    // its @address so the file can be loaded back with --ram-init-h32
+    void dump_pages(const char *path) const;
+
+  private:
+    static const uint32_t STROBE_MASK[16];
+
+    uint32_t *ram{nullptr};
+    uint32_t words{0};
+    size_t bytes{0};
+};
+
+#endif // SPARSE_RAM_H